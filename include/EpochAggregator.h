@@ -0,0 +1,108 @@
+/**
+ * Fuses the RMC, GLL and GSV sentences of one navigation epoch
+ * into a single fix record.
+ */
+#ifndef __EPOCH_AGGREGATOR_H
+#define __EPOCH_AGGREGATOR_H
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "NMEASentences.h"
+#include "NMEADispatch.h"
+#include "GSVAssembler.h"
+#include "SeqLock.h"
+
+/**
+ * All information about one epoch (i.e. one UTC time).
+ * Fields not contained in any received sentence are INT32_MAX ('\0' for chars).
+ */
+struct NMEAFix {
+    uint32_t utcTime; //hhmmss.ss
+    int32_t date; //ddmmyy, from RMC
+    NMEAPosition position;
+    int32_t speed; //1/1000 knots, from RMC
+    int32_t course; //1/1000 degrees, from RMC
+    char status; //A or V
+    char posMode; //N, E, A or D, from RMC
+    /**
+     * Satellites in view per constellation (see GSVTalkerSlot), from GSV.
+     * 0 if no GSV has been received.
+     */
+    uint8_t satsInView[GSV_NUM_TALKER_SLOTS];
+    /**
+     * Combination of NMEA_TYPE_MASK(...) of the sentence types
+     * that contributed to this fix
+     */
+    uint32_t sentenceMask;
+    /**
+     * Number of epochs published before this one
+     */
+    uint32_t epoch;
+};
+
+/**
+ * Groups sentences by their UTC time. GSV sentences (which have no time)
+ * are attributed to the epoch that is open when they arrive, or the
+ * next one if no epoch is open.
+ *
+ * An epoch is complete once all sentence types in the complete mask have been received
+ * (for GSV: the last message of a sequence), or once a sentence with a different
+ * UTC time arrives. Complete epochs are published through a seqlock, so readers
+ * on other threads never block the parsing thread and never see a half-updated fix.
+ * add() and flush() must be called from a single thread.
+ */
+class EpochAggregator {
+public:
+    /**
+     * @param completeMask Combination of NMEA_TYPE_MASK(...) of the sentence types
+     *  the receiver outputs every epoch
+     */
+    explicit EpochAggregator(uint32_t completeMask = NMEA_TYPE_MASK(NMEASentenceRMC) | NMEA_TYPE_MASK(NMEASentenceGLL));
+
+    /**
+     * Add a single sentence (not necessarily NUL-terminated).
+     * Sentences with a checksum are only used if it is correct.
+     * @return The number of epochs published by this call (0..2) or -1 if the
+     *  sentence has been ignored (unsupported type, invalid checksum or parse error)
+     */
+    int add(const char* sentence, size_t size);
+
+    /**
+     * Publish the open epoch, if any, e.g. if no sentences arrived for some time.
+     * @return The number of epochs published (0 or 1)
+     */
+    int flush();
+
+    /**
+     * Read the most recent complete fix. Can be called from any thread.
+     * @return false if no fix has been published yet
+     */
+    bool getLatestFix(NMEAFix* fix) const {
+        if(latest.getVersion() == 0) {
+            return false;
+        }
+        *fix = latest.load();
+        return true;
+    }
+
+    /**
+     * Number of published fixes. Can be called from any thread.
+     */
+    uint32_t getNumPublished() const {
+        return latest.getVersion();
+    }
+private:
+    int enterEpoch(uint32_t utcTime, bool* use);
+    int publishIfComplete();
+    int publish();
+
+    uint32_t completeMask;
+    NMEAFix current;
+    bool open; //Epoch with current.utcTime is being assembled
+    bool hasPublished;
+    uint32_t lastPublishedTime;
+    SeqLock<NMEAFix> latest;
+};
+
+#endif //__EPOCH_AGGREGATOR_H
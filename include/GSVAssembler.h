@@ -0,0 +1,116 @@
+/**
+ * Allocation-free assembler for multi-message GSV sequences.
+ */
+#ifndef __GSV_ASSEMBLER_H
+#define __GSV_ASSEMBLER_H
+
+#include <cstdint>
+
+#include "NMEASentences.h"
+#include "NMEADispatch.h"
+
+/**
+ * Satellites with higher IDs are ignored
+ */
+#define GSV_MAX_SATELLITE_ID 255
+
+/**
+ * Constellations with a separate sky view slot, by talker ID
+ */
+enum GSVTalkerSlot {
+    GSVTalkerGP = 0, //GPS, SBAS
+    GSVTalkerGL, //GLONASS
+    GSVTalkerGA, //Galileo
+    GSVTalkerGB, //BeiDou
+    GSV_NUM_TALKER_SLOTS
+};
+
+/**
+ * Complete sky view of one constellation.
+ * Satellites are stored in an array indexed by satellite ID.
+ */
+struct GSVSkyView {
+    uint8_t numSats; //Satellites in view as reported by the receiver
+    uint8_t numSatInfos; //Number of satellites present in the satellites array
+    /**
+     * Bitmap of present satellite IDs
+     */
+    uint64_t present[(GSV_MAX_SATELLITE_ID + 64) / 64];
+    GSVSatInfo satellites[GSV_MAX_SATELLITE_ID + 1];
+
+    bool hasSatellite(uint16_t id) const {
+        return id <= GSV_MAX_SATELLITE_ID && (present[id / 64] >> (id % 64)) & 1;
+    }
+};
+
+/**
+ * Reassembles the numMsgs/msgNum sequences of GSV sentences per talker
+ * and publishes a sky view only when a sequence is complete.
+ * Missing or out-of-order parts discard the sequence.
+ * Does not use dynamic memory.
+ */
+class GSVAssembler {
+public:
+    GSVAssembler();
+
+    /**
+     * Add a parsed GSV sentence.
+     * @param talker The two-character talker ID, e.g. "GP"
+     * @return 1 if a sky view has been completed and published,
+     *  0 if more sentences are required to complete the sequence,
+     *  -1 if the talker ID has no slot,
+     *  -2 if the sentence is invalid (msgNum not in 1..numMsgs),
+     *  -3 if the sentence does not continue the current sequence. The sequence is discarded.
+     */
+    int add(const char* talker, const GSVSentence& sentence);
+
+    /**
+     * Add a sentence as returned by dispatchNMEASentence().
+     * Returns -2 if it is not a GSV sentence.
+     */
+    int add(const NMEAParsedSentence& sentence);
+
+    /**
+     * true if at least one sky view has been published for the given slot
+     */
+    bool hasSkyView(GSVTalkerSlot slot) const {
+        return slots[slot].published >= 0;
+    }
+
+    /**
+     * The last complete sky view of the given slot.
+     * Only valid if hasSkyView(slot).
+     */
+    const GSVSkyView& getSkyView(GSVTalkerSlot slot) const {
+        return slots[slot].views[slots[slot].published < 0 ? 0 : slots[slot].published];
+    }
+
+    /**
+     * Number of sequences that have been discarded because of missing
+     * or out-of-order parts
+     */
+    uint32_t getDiscardedSequences() const {
+        return discardedSequences;
+    }
+
+    /**
+     * Map a talker ID to its slot.
+     * @return The slot or -1 if there is no slot for the talker ID
+     */
+    static int getTalkerSlot(const char* talker);
+private:
+    struct Slot {
+        /**
+         * Double buffer: One view is published, the other one is being assembled
+         */
+        GSVSkyView views[2];
+        int8_t published; //Index of the published view, -1 if none
+        uint8_t numMsgs; //Number of messages in the current sequence
+        uint8_t nextMsgNum; //Next expected msgNum, 0 if no sequence in progress
+    };
+
+    Slot slots[GSV_NUM_TALKER_SLOTS];
+    uint32_t discardedSequences;
+};
+
+#endif //__GSV_ASSEMBLER_H
@@ -7,6 +7,15 @@
 #include <cstdint>
 #include <cstdlib>
 
+/*
+ * The numeric parsers below convert up to 8 digits at once using SWAR arithmetic
+ * if the size of the field is known (the sized variants and NMEASentenceView).
+ * The NUL-terminated variants parse per character and never read past the
+ * terminator. Define NMEA_CSTRING_SWAR to use SWAR for them as well; they may
+ * then load up to 7 bytes after the terminator, but never across a page boundary.
+ * Define NMEA_DISABLE_SWAR to use plain per-character parsing everywhere.
+ */
+
 /**
  * Parse a coordinate of the form 4153.94820
  * to an integer, e.g. 415394820 so that the result
@@ -34,6 +43,12 @@ int32_t parseNMEAUTCTime(const char* src);
  */
 int32_t parseNMEAFixedPointDecimal(const char* src, int decimals);
 
+/**
+ * Like parseNMEAFixedPointDecimal(const char*, int), but additionally
+ * stops after size characters. src does not need to be NUL-terminated.
+ */
+int32_t parseNMEAFixedPointDecimal(const char* src, size_t size, int decimals);
+
 /**
  * Generic integer parser.
  * Parses e.g. "1234" to 1234.
@@ -43,6 +58,12 @@ int32_t parseNMEAFixedPointDecimal(const char* src, int decimals);
  */
 int32_t parseNMEAInteger(const char* src);
 
+/**
+ * Like parseNMEAInteger(const char*), but additionally
+ * stops after size characters. src does not need to be NUL-terminated.
+ */
+int32_t parseNMEAInteger(const char* src, size_t size);
+
 /**
  * Compute the NMEA checksum of a cstring.
  * The first character (usually $) and the last (usually *) are ignored.
@@ -77,4 +98,117 @@ uint16_t computeHexNMEAChecksum(const char* payload, size_t size);
  */
 uint16_t computeHexNMEAChecksum(const char* payload);
 
+/**
+ * Verify the checksum of a sentence of the form $...*HH (optionally followed by \r\n).
+ * The sentence does not need to be NUL-terminated.
+ * @return 0 if the checksum is correct, -1 if there is no checksum, -2 if it is wrong.
+ */
+int checkNMEAChecksum(const char* sentence, size_t size);
+
+/**
+ * Maximum number of fields (including the address field) indexed by NMEASentenceView.
+ * Additional fields are ignored.
+ */
+#ifndef NMEA_MAX_FIELDS
+#define NMEA_MAX_FIELDS 32
+#endif
+
+/**
+ * Lazy field-indexed view of a single sentence.
+ * Construction scans the sentence once and records the offset and size
+ * of every field. Fields are only decoded when they are accessed.
+ *
+ * Field 0 is the address field (e.g. "GPRMC" for "$GPRMC,..."),
+ * so for RMC, field 1 is the UTC time and field 3 is the latitude.
+ * The view ends at the '*' preceding the checksum, at \r, \n or \0 or after size bytes.
+ * The viewed buffer must outlive the view.
+ */
+class NMEASentenceView {
+public:
+    /**
+     * View a NUL-terminated sentence, with or without the leading '$'
+     */
+    explicit NMEASentenceView(const char* sentence);
+    /**
+     * View a sentence that is not necessarily NUL-terminated,
+     * e.g. as emitted by NMEAFramer.
+     */
+    NMEASentenceView(const char* sentence, size_t size);
+
+    /**
+     * Number of fields, including the address field
+     */
+    size_t numFields() const {
+        return nfields;
+    }
+
+    /**
+     * Pointer to the first character of the given field.
+     * The field is not NUL-terminated, use fieldSize().
+     * Returns NULL if there is no such field.
+     */
+    const char* field(size_t idx) const {
+        return idx < nfields ? buf + fields[idx].offset : NULL;
+    }
+
+    /**
+     * Number of characters in the given field, 0 if the field
+     * is empty or does not exist.
+     */
+    size_t fieldSize(size_t idx) const {
+        return idx < nfields ? fields[idx].size : 0;
+    }
+
+    /**
+     * The first character of a field, e.g. for status or direction fields.
+     * Returns '\0' if the field is empty or does not exist.
+     */
+    char character(size_t idx) const {
+        return fieldSize(idx) == 0 ? '\0' : buf[fields[idx].offset];
+    }
+
+    /**
+     * Parse the given field using parseNMEAFixedPointDecimal().
+     * Returns INT32_MAX if the field is invalid or does not exist.
+     */
+    int32_t fixedPoint(size_t idx, int decimals) const {
+        return idx < nfields ? parseNMEAFixedPointDecimal(field(idx), fields[idx].size, decimals) : INT32_MAX;
+    }
+
+    /**
+     * Parse the given field using parseNMEAInteger().
+     * Returns INT32_MAX if the field is invalid or does not exist.
+     */
+    int32_t integer(size_t idx) const {
+        return idx < nfields ? parseNMEAInteger(field(idx), fields[idx].size) : INT32_MAX;
+    }
+
+    /**
+     * Parse the given field using the parseNMEACoordinate() format.
+     * Returns INT32_MAX if the field is invalid or does not exist.
+     */
+    int32_t coordinate(size_t idx) const {
+        return fixedPoint(idx, 5);
+    }
+
+    /**
+     * Parse the given field using the parseNMEAUTCTime() format.
+     * Returns INT32_MAX if the field is invalid or does not exist.
+     */
+    int32_t utcTime(size_t idx) const {
+        return fixedPoint(idx, 2);
+    }
+private:
+    struct Field {
+        uint16_t offset;
+        uint16_t size;
+    };
+
+    void index(const char* end);
+
+    const char* buf;
+    size_t nfields;
+    Field fields[NMEA_MAX_FIELDS];
+};
+
 #endif //__NMEA_H
\ No newline at end of file
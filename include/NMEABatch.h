@@ -0,0 +1,55 @@
+/**
+ * Columnar (struct-of-arrays) batch parser for buffers of many
+ * RMC and GLL sentences, e.g. from log files.
+ */
+#ifndef __NMEA_BATCH_H
+#define __NMEA_BATCH_H
+
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * Row status flags
+ */
+#define NMEA_ROW_VALID 0x01 //Sentence has been parsed successfully
+#define NMEA_ROW_FIX 0x02 //Status field is 'A'
+#define NMEA_ROW_RMC 0x04 //Row is from a RMC sentence
+#define NMEA_ROW_GLL 0x08 //Row is from a GLL sentence
+#define NMEA_ROW_CHECKSUM_ERROR 0x10 //Checksum present but wrong. NMEA_ROW_VALID is not set.
+
+/**
+ * Caller-provided column arrays. Every array must have at least capacity elements.
+ * Any column except status may be NULL, in which case it is not written.
+ *
+ * Field semantics and units are the same as in RMCSentence.
+ * Fields that are not contained in the sentence type (speed, course and date for GLL)
+ * or could not be parsed are set to INT32_MAX.
+ */
+struct NMEAFixColumns {
+    uint32_t* utcTime;
+    int32_t* latitude;
+    int32_t* longitude;
+    int32_t* speed;
+    int32_t* course;
+    int32_t* date;
+    /**
+     * Combination of NMEA_ROW_... flags
+     */
+    uint8_t* status;
+    size_t capacity;
+};
+
+/**
+ * Parse all RMC and GLL sentences (of any talker) in a buffer of
+ * \n-separated sentences into the given columns, one row per sentence.
+ * Other sentence types are skipped. Does not allocate any memory.
+ *
+ * If a checksum is present, it is verified.
+ * @param consumed If not NULL, set to the number of bytes processed.
+ *  This is less than size if the columns are full or if the
+ *  buffer ends with an incomplete line.
+ * @return The number of rows written
+ */
+size_t parseNMEAFixBatch(const char* buf, size_t size, NMEAFixColumns* columns, size_t* consumed);
+
+#endif //__NMEA_BATCH_H
@@ -0,0 +1,62 @@
+/**
+ * Deterministic generator for realistic mixed-sentence NMEA corpora,
+ * e.g. for benchmarks and tests.
+ */
+#ifndef __NMEA_CORPUS_H
+#define __NMEA_CORPUS_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include "NMEADispatch.h"
+
+/**
+ * Generates RMC, GLL and GSV sentences of a simulated receiver moving
+ * along a random walk. Sentences use varying talker IDs (GP, GN, GL, GA, GB),
+ * may contain empty fields and may have corrupt checksums.
+ * The same seed always produces the same sequence of sentences.
+ */
+class NMEACorpusGenerator {
+public:
+    /**
+     * @param emptyFieldPercent Probability (in percent) for each optional field to be empty
+     * @param corruptChecksumPercent Probability (in percent) for a sentence to have a wrong checksum
+     */
+    explicit NMEACorpusGenerator(uint32_t seed = 1, unsigned emptyFieldPercent = 2, unsigned corruptChecksumPercent = 1);
+
+    /**
+     * Generate the next sentence of a random type, including $ and *HH\r\n.
+     * The result is NUL-terminated.
+     * @param type If not NULL, set to the type of the generated sentence
+     * @return The size of the sentence (excluding the NUL), 0 if buf is too small
+     */
+    size_t next(char* buf, size_t size, NMEASentenceType* type = NULL);
+
+    /**
+     * Generate the next sentence of the given type.
+     */
+    size_t next(NMEASentenceType type, char* buf, size_t size);
+
+    /**
+     * Generate a corpus of the given number of concatenated sentences.
+     */
+    std::string generate(size_t numSentences);
+private:
+    uint32_t random();
+    bool percent(unsigned probability) {
+        return random() % 100 < probability;
+    }
+    void advance();
+
+    uint64_t state;
+    unsigned emptyFieldPercent;
+    unsigned corruptChecksumPercent;
+    //Simulated receiver state
+    int32_t utcTime; //hhmmss.ss
+    int32_t date; //ddmmyy
+    int32_t latitude, longitude; //1/1e5 minutes, see NMEAPosition
+    int32_t speed, course;
+};
+
+#endif //__NMEA_CORPUS_H
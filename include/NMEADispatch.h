@@ -0,0 +1,77 @@
+/**
+ * Sentence type detection and dispatch to the sentence parsers,
+ * independent of the talker ID (GP, GN, GL, GA, GB, ...).
+ */
+#ifndef __NMEA_DISPATCH_H
+#define __NMEA_DISPATCH_H
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "NMEASentences.h"
+
+enum NMEASentenceType {
+    NMEASentenceUnknown = 0,
+    NMEASentenceGLL,
+    NMEASentenceRMC,
+    NMEASentenceGSV,
+    NMEASentenceGGA,
+    NMEASentenceGSA,
+    NMEASentenceVTG,
+    NMEASentenceZDA,
+    NMEASentenceGST
+};
+
+/**
+ * Bit mask for a single sentence type, to be used in enable masks.
+ */
+#define NMEA_TYPE_MASK(type) (1u << (type))
+#define NMEA_TYPE_MASK_ALL 0xFFFFFFFFu
+
+/**
+ * Pack a 3-letter sentence formatter (e.g. "RMC") into an integer.
+ * Usable in constant expressions, e.g. as switch case labels.
+ */
+constexpr uint32_t nmeaFormatterCode(const char* formatter) {
+    return ((uint32_t)(uint8_t)formatter[0] << 16)
+         | ((uint32_t)(uint8_t)formatter[1] << 8)
+         | (uint32_t)(uint8_t)formatter[2];
+}
+
+/**
+ * Determine the type of a sentence of the form $ttfff,... from its
+ * formatter, regardless of the two-character talker ID.
+ * The sentence does not need to be NUL-terminated.
+ * Proprietary sentences ($P...) are NMEASentenceUnknown.
+ */
+NMEASentenceType getNMEASentenceType(const char* sentence, size_t size);
+
+/**
+ * Result of dispatchNMEASentence()
+ */
+struct NMEAParsedSentence {
+    NMEASentenceType type;
+    char talker[2]; //e.g. "GP", not NUL-terminated
+    union {
+        NMEAPosition gll;
+        RMCSentence rmc;
+        GSVSentence gsv;
+        GGASentence gga;
+        GSASentence gsa;
+        VTGSentence vtg;
+        ZDASentence zda;
+        GSTSentence gst;
+    };
+};
+
+/**
+ * Detect the type of a sentence and parse it with the matching parser.
+ * Sentences whose type is not set in enabledTypes are dropped
+ * before any field is parsed.
+ * @param enabledTypes Combination of NMEA_TYPE_MASK(...) values
+ * @return 0 on success, 1 if the sentence type is unknown or not enabled,
+ *  the negative error code of the parser else.
+ */
+int dispatchNMEASentence(const char* sentence, size_t size, uint32_t enabledTypes, NMEAParsedSentence* result);
+
+#endif //__NMEA_DISPATCH_H
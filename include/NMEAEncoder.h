@@ -0,0 +1,47 @@
+/**
+ * Allocation-free NMEA sentence encoders, e.g. for simulators
+ * and retransmission of parsed sentences.
+ */
+#ifndef __NMEA_ENCODER_H
+#define __NMEA_ENCODER_H
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "NMEASentences.h"
+
+/**
+ * Upper bound of the size of any encoded sentence, including the NUL terminator.
+ */
+#define NMEA_ENCODER_MAX_SIZE 128
+
+/*
+ * The encoders write a complete sentence including $, *HH checksum
+ * and \r\n into buf and NUL-terminate it. The checksum is computed
+ * while the sentence is written.
+ *
+ * Fields that are INT32_MAX (or '\0' for characters) are written as empty fields.
+ * Values accepted by the parsers are reproduced exactly when the
+ * encoded sentence is parsed again.
+ *
+ * @param talker The two-character talker ID, e.g. "GP"
+ * @param size Size of buf. Must be at least NMEA_ENCODER_MAX_SIZE.
+ * @return The size of the sentence (excluding the NUL), 0 if buf is too small
+ */
+
+/**
+ * GLL with status A (V if the position is invalid) and mode A (N if invalid).
+ * @param utcTime hhmmss.ss, INT32_MAX if unknown
+ */
+size_t encodeGLLSentence(const char* talker, const NMEAPosition& position, uint32_t utcTime, char* buf, size_t size);
+/**
+ * RMC. Magnetic variation fields are empty.
+ */
+size_t encodeRMCSentence(const char* talker, const RMCSentence& sentence, char* buf, size_t size);
+/**
+ * GSV with the first numSatInfos satellites.
+ * Satellites with signal UINT8_MAX have an empty signal field.
+ */
+size_t encodeGSVSentence(const char* talker, const GSVSentence& sentence, char* buf, size_t size);
+
+#endif //__NMEA_ENCODER_H
@@ -0,0 +1,64 @@
+/**
+ * Fast buffer-based formatters for parsed NMEA structures.
+ * Integer-only, locale independent and allocation-free.
+ */
+#ifndef __NMEA_FORMAT_H
+#define __NMEA_FORMAT_H
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "NMEASentences.h"
+
+/**
+ * Upper bound of the size of any formatted record, including the NUL terminator.
+ */
+#define NMEA_FORMAT_MAX_SIZE 512
+
+enum NMEAFormatMode {
+    /**
+     * Human readable, as printed by the operator<< overloads
+     */
+    NMEAFormatText = 0,
+    /**
+     * One JSON object per line (JSON lines), terminated by '\n'.
+     * Coordinates are decimal degrees rounded to 1e-7 degrees, invalid fields are null.
+     */
+    NMEAFormatJSON,
+    /**
+     * One CSV record per line, terminated by '\n'. The first column
+     * is the record type, see NMEA_CSV_HEADER_*. Coordinates are decimal degrees
+     * like in NMEAFormatJSON, invalid fields are empty.
+     */
+    NMEAFormatCSV
+};
+
+#define NMEA_CSV_HEADER_POSITION "type,latitude,longitude\n"
+#define NMEA_CSV_HEADER_RMC "type,date,time,status,latitude,longitude,speed,course,posMode\n"
+/**
+ * GSV records have 4 satellite columns (id, azimuth, elevation, signal)
+ * for each satellite info in the sentence.
+ */
+#define NMEA_CSV_HEADER_GSV "type,numMsgs,msgNum,numSats,id,azimuth,elevation,signal,...\n"
+
+/*
+ * The formatters write a NUL-terminated record into buf.
+ * @param size Size of buf. Must be at least NMEA_FORMAT_MAX_SIZE.
+ * @return The size of the record (excluding the NUL), 0 if buf is too small
+ */
+size_t formatNMEAPosition(const NMEAPosition& position, NMEAFormatMode mode, char* buf, size_t size);
+size_t formatRMCSentence(const RMCSentence& sentence, NMEAFormatMode mode, char* buf, size_t size);
+size_t formatGSVSentence(const GSVSentence& sentence, NMEAFormatMode mode, char* buf, size_t size);
+/**
+ * Text mode only, e.g. "Satellite { #23, azimuth 38, elevation 230, signal 44 }"
+ */
+size_t formatGSVSatInfo(const GSVSatInfo& sat, char* buf, size_t size);
+
+/**
+ * Format the absolute value of a coordinate as xx°yy.zzzzz" (no hemisphere).
+ * @param buf Must have 24 bytes available
+ * @return The size (excluding the NUL)
+ */
+size_t formatNMEACoordinate(int32_t coord, char* buf);
+
+#endif //__NMEA_FORMAT_H
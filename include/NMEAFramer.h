@@ -0,0 +1,207 @@
+/**
+ * Resumable NMEA stream framer.
+ * Splits arbitrarily sized chunks of a byte stream (e.g. whatever a single
+ * read() returned) into complete $...\r\n sentences.
+ */
+#ifndef __NMEA_FRAMER_H
+#define __NMEA_FRAMER_H
+
+#include <cstdint>
+#include <cstring>
+
+#include "NMEAStats.h"
+
+/**
+ * Maximum size of a sentence that may be split across chunks,
+ * including $ and \r\n. Longer sentences are dropped.
+ * NMEA limits sentences to 82 characters, but proprietary
+ * UBX sentences (PUBX) may be longer.
+ */
+#ifndef NMEA_FRAMER_BUFSIZE
+#define NMEA_FRAMER_BUFSIZE 256
+#endif
+
+/**
+ * Stateful framer that accepts chunks of any size and calls a callback
+ * for each complete sentence.
+ *
+ * Sentences that are fully contained in a chunk are passed to the callback
+ * as a pointer into the chunk, i.e. without copying. Only sentences spanning
+ * two or more chunks are assembled in the internal buffer.
+ *
+ * Emitted sentences start with '$' and end with "\r\n" (both included in the size).
+ * They are NOT NUL-terminated when passed in-place, so consumers must honour
+ * the size. Any '$' encountered inside a sentence resynchronizes the framer,
+ * i.e. the incomplete sentence is discarded and a new one is started.
+ */
+class NMEAFramer {
+public:
+    NMEAFramer() : partialSize(0), inSentence(false), droppedBytes(0), resyncs(0) {}
+
+    /**
+     * Process a chunk of the stream.
+     * @param onSentence Callable as onSentence(const char* sentence, size_t size)
+     * @return The number of complete sentences emitted from this chunk
+     */
+    template<typename Callback>
+    size_t feed(const char* data, size_t size, Callback onSentence);
+
+    /**
+     * Discard any partially received sentence.
+     */
+    void reset() {
+        partialSize = 0;
+        inSentence = false;
+    }
+
+    /**
+     * Discard a partial sentence because the text stream has been
+     * interrupted, e.g. by a binary message. Its bytes are counted as dropped.
+     */
+    void abortSentence() {
+        if(inSentence) {
+            countDropped(partialSize);
+            reset();
+        }
+    }
+
+    /**
+     * true if a partial sentence is kept from a previous chunk
+     */
+    bool hasPartialSentence() const {
+        return inSentence;
+    }
+
+    /**
+     * Number of bytes that were discarded because they were not part of
+     * a valid sentence (garbage between sentences, overlong or truncated sentences).
+     */
+    uint32_t getDroppedBytes() const {
+        return droppedBytes;
+    }
+
+    /**
+     * Number of times an incomplete sentence was discarded because
+     * a new '$' was encountered.
+     */
+    uint32_t getResyncs() const {
+        return resyncs;
+    }
+private:
+    /**
+     * Emit a complete candidate sentence from $ to \n (inclusive) if it is valid.
+     */
+    template<typename Callback>
+    bool emit(const char* sentence, size_t size, Callback& onSentence) {
+        //'$' + 1+ byte content + \r\n, End must be \r\n
+        if(size < 4 || sentence[size - 2] != '\r') {
+            countDropped(size);
+            return false;
+        }
+        onSentence(sentence, size);
+        return true;
+    }
+
+    /**
+     * Append data to the partial sentence buffer.
+     * Drops the partial sentence if it does not fit.
+     */
+    void appendPartial(const char* data, size_t size) {
+        if(partialSize + size > NMEA_FRAMER_BUFSIZE - 1) {
+            countDropped(partialSize + size);
+            reset();
+            return;
+        }
+        memcpy(partial + partialSize, data, size);
+        partialSize += size;
+    }
+
+    void countDropped(size_t size) {
+        droppedBytes += size;
+        if(size != 0) {
+            NMEA_STATS_ADD(NMEAStatsDroppedBytes, size);
+        }
+    }
+
+    void countResync() {
+        resyncs++;
+        NMEA_STATS_ADD(NMEAStatsResyncs, 1);
+    }
+
+    char partial[NMEA_FRAMER_BUFSIZE];
+    size_t partialSize;
+    /**
+     * true if a partial sentence is stored in the partial buffer
+     */
+    bool inSentence;
+    uint32_t droppedBytes;
+    uint32_t resyncs;
+};
+
+/**
+ * Find the first '\n' or '$' in [p, end). Returns end if neither was found.
+ */
+static inline const char* findNMEASentenceDelimiter(const char* p, const char* end) {
+    for(; p < end; p++) {
+        if(*p == '\n' || *p == '$') {
+            return p;
+        }
+    }
+    return end;
+}
+
+template<typename Callback>
+size_t NMEAFramer::feed(const char* data, size_t size, Callback onSentence) {
+    const char* pos = data;
+    const char* end = data + size;
+    size_t emitted = 0;
+    //Continue a sentence from a previous chunk
+    if(inSentence) {
+        const char* delim = findNMEASentenceDelimiter(pos, end);
+        if(delim == end) { //Still no end of sentence
+            //On overflow, this drops the sentence and skips until the next $
+            appendPartial(pos, size);
+            return 0;
+        }
+        if(*delim == '$') { //Resync on new sentence
+            countDropped(partialSize + (delim - pos));
+            countResync();
+            reset();
+            pos = delim;
+        } else { // '\n'
+            appendPartial(pos, delim - pos + 1);
+            if(inSentence) {
+                partial[partialSize] = '\0';
+                emitted += emit(partial, partialSize, onSentence);
+            }
+            reset();
+            pos = delim + 1;
+        }
+    }
+    while(pos < end) {
+        //Skip to the start of the next sentence
+        const char* start = (const char*)memchr(pos, '$', end - pos);
+        if(start == NULL) {
+            countDropped(end - pos);
+            break;
+        }
+        countDropped(start - pos);
+        const char* delim = findNMEASentenceDelimiter(start + 1, end);
+        if(delim == end) { //Sentence continues in the next chunk
+            inSentence = true;
+            appendPartial(start, end - start);
+            break;
+        }
+        if(*delim == '$') { //Incomplete sentence followed by a new one
+            countDropped(delim - start);
+            countResync();
+            pos = delim;
+            continue;
+        }
+        emitted += emit(start, delim - start + 1, onSentence);
+        pos = delim + 1;
+    }
+    return emitted;
+}
+
+#endif //__NMEA_FRAMER_H
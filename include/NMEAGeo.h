@@ -0,0 +1,99 @@
+/**
+ * Batch conversion of NMEA coordinates (degrees * 1e7 + 1/1e5 minutes,
+ * see NMEAPosition) to decimal degrees, radians, ECEF and local ENU coordinates.
+ *
+ * The kernels process whole arrays and write one output array per component,
+ * so the loops have no dependencies between elements and can be vectorized
+ * by the compiler. Invalid coordinates (INT32_MAX) are passed through as
+ * INT32_MAX (integer outputs) or NaN (floating point outputs).
+ */
+#ifndef __NMEA_GEO_H
+#define __NMEA_GEO_H
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "NMEASentences.h"
+
+/**
+ * WGS84 ellipsoid
+ */
+#define NMEA_WGS84_A 6378137.0
+#define NMEA_WGS84_F (1.0 / 298.257223563)
+
+/**
+ * Convert a coordinate to 1e-7 degrees, rounded to the nearest value.
+ * Exact for all valid coordinates, i.e. |result| <= 180e7.
+ */
+inline int32_t nmeaCoordinateToDegrees(int32_t coord) {
+    if(coord == INT32_MAX) {
+        return INT32_MAX;
+    }
+    uint32_t value = coord < 0 ? 0u - (uint32_t)coord : (uint32_t)coord;
+    uint32_t degrees = value / 10000000;
+    //1/1e5 minutes to 1e-7 degrees: * 1e7 / (60 * 1e5), rounded
+    uint32_t fraction = ((value - degrees * 10000000) * 100 + 30) / 60;
+    int32_t result = (int32_t)(degrees * 10000000 + fraction);
+    return coord < 0 ? -result : result;
+}
+
+/**
+ * Inverse of nmeaCoordinateToDegrees(), rounded to 1/1e5 minutes
+ */
+inline int32_t nmeaDegreesToCoordinate(int32_t degrees) {
+    if(degrees == INT32_MAX) {
+        return INT32_MAX;
+    }
+    uint32_t value = degrees < 0 ? 0u - (uint32_t)degrees : (uint32_t)degrees;
+    uint32_t whole = value / 10000000;
+    uint32_t minutes = ((value - whole * 10000000) * 6 + 5) / 10;
+    int32_t result = (int32_t)(whole * 10000000 + minutes);
+    return degrees < 0 ? -result : result;
+}
+
+/**
+ * Convert positions to 1e-7 degrees (like UBX-NAV-PVT)
+ */
+void convertNMEAPositionsToDegrees(const NMEAPosition* positions, size_t count,
+    int32_t* latitudes, int32_t* longitudes);
+
+/**
+ * Convert positions to radians
+ */
+void convertNMEAPositionsToRadians(const NMEAPosition* positions, size_t count,
+    double* latitudes, double* longitudes);
+
+/**
+ * Convert positions to earth-centered, earth-fixed WGS84 coordinates in m.
+ * @param altitudes Height above the ellipsoid in mm (e.g. GGA altitude + geoid separation),
+ *  NULL for height 0. INT32_MAX is treated as 0.
+ */
+void convertNMEAPositionsToECEF(const NMEAPosition* positions, const int32_t* altitudes, size_t count,
+    double* x, double* y, double* z);
+
+/**
+ * Local east/north/up frame with its origin at a reference position,
+ * e.g. the first fix of a track. Rotation and origin are computed once
+ * by the constructor, so the conversion is one ECEF conversion and a
+ * matrix multiplication per fix.
+ */
+class NMEALocalFrame {
+public:
+    /**
+     * @param reference Origin of the frame
+     * @param altitude Height of the origin above the ellipsoid in mm
+     */
+    explicit NMEALocalFrame(const NMEAPosition& reference, int32_t altitude = 0);
+
+    /**
+     * Convert positions to east/north/up in m relative to the origin.
+     * @param altitudes See convertNMEAPositionsToECEF()
+     */
+    void toENU(const NMEAPosition* positions, const int32_t* altitudes, size_t count,
+        double* east, double* north, double* up) const;
+private:
+    double originX, originY, originZ;
+    double sinLat, cosLat, sinLon, cosLon;
+};
+
+#endif //__NMEA_GEO_H
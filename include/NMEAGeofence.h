@@ -0,0 +1,233 @@
+/**
+ * Static geofence index: Which polygon and circle fences contain a position?
+ *
+ * Fences and positions use the NMEAPosition encoding. Internally, all
+ * coordinates are converted to 1e-7 degrees (see NMEAGeo.h), so polygon
+ * tests are exact integer arithmetic.
+ */
+#ifndef __NMEA_GEOFENCE_H
+#define __NMEA_GEOFENCE_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "NMEASentences.h"
+
+/**
+ * Target number of grid cells per fence
+ */
+#ifndef NMEA_GEOFENCE_CELLS_PER_FENCE
+#define NMEA_GEOFENCE_CELLS_PER_FENCE 4
+#endif
+#define NMEA_GEOFENCE_MAX_CELLS (1u << 20)
+/**
+ * Grid cells with more fences are subdivided by a second grid level
+ */
+#ifndef NMEA_GEOFENCE_MAX_CELL_FENCES
+#define NMEA_GEOFENCE_MAX_CELL_FENCES 16
+#endif
+/**
+ * Maximum number of rows and columns of a subdivided cell
+ */
+#define NMEA_GEOFENCE_MAX_SUBDIVISION 64
+/**
+ * Maximum width and height of a fence, 90 degrees in 1e-7 degrees.
+ * Keeps the products of the polygon test within 64 bits.
+ */
+#define NMEA_GEOFENCE_MAX_EXTENT 900000000
+
+/**
+ * Fences are added first, then build() creates a uniform grid over their
+ * bounding boxes. Every cell lists the fences whose bounding box overlaps it,
+ * so a query tests only the few fences of one cell. Cells with more than
+ * NMEA_GEOFENCE_MAX_CELL_FENCES fences (e.g. where fences cluster) are
+ * subdivided by a finer grid of their own.
+ *
+ * Fences must not cross the antimeridian. Circles are evaluated on a local
+ * plane, which is accurate for radii up to some 10 km.
+ * Queries are const and may run concurrently once the index is built.
+ */
+class NMEAGeofenceIndex {
+public:
+    NMEAGeofenceIndex();
+
+    /**
+     * Add a polygon. The last vertex is connected to the first one.
+     * @return The fence ID (IDs are assigned in order, starting at 0),
+     *  -1 if the polygon has less than 3 vertices or invalid coordinates,
+     *  -2 if it is larger than NMEA_GEOFENCE_MAX_EXTENT,
+     *  -3 if the index has already been built
+     */
+    int addPolygon(const NMEAPosition* vertices, size_t count);
+
+    /**
+     * Add a circle
+     * @return The fence ID or a negative value like addPolygon()
+     */
+    int addCircle(const NMEAPosition& center, double radiusMeters);
+
+    /**
+     * Build the grid. Fences can not be added afterwards.
+     * @return 0 on success, -1 if there are no fences
+     */
+    int build();
+
+    size_t getNumFences() const {
+        return fences.size();
+    }
+
+    /**
+     * Find the fences containing a position.
+     * @param fences The IDs of up to maxFences containing fences, in ascending order
+     * @return The number of containing fences (may be larger than maxFences),
+     *  0 for invalid positions or if the index has not been built
+     */
+    size_t query(const NMEAPosition& position, uint32_t* fences, size_t maxFences) const;
+
+    /**
+     * Query columns of positions, e.g. the latitude and longitude columns of NMEAFixColumns.
+     * The IDs of row i are written to fences[offsets[i]] .. fences[offsets[i + 1] - 1].
+     * Stops before the first row whose IDs do not fit into fences.
+     * @param offsets Must have space for count + 1 elements
+     * @return The number of rows processed
+     */
+    size_t query(const int32_t* latitudes, const int32_t* longitudes, size_t count,
+        uint32_t* offsets, uint32_t* fences, size_t maxFences) const;
+
+    /**
+     * true if the given fence contains the position
+     */
+    bool contains(uint32_t fence, const NMEAPosition& position) const;
+private:
+    enum FenceType {
+        FencePolygon,
+        FenceCircle
+    };
+
+    struct Fence {
+        FenceType type;
+        //Bounding box, 1e-7 degrees
+        int32_t minLatitude, maxLatitude, minLongitude, maxLongitude;
+        //Polygon vertices in vertices
+        uint32_t firstVertex, numVertices;
+        //Circle
+        int32_t centerLatitude, centerLongitude;
+        double radiusSquared;
+        double metersPerDegreeLongitude; //Per 1e-7 degrees
+    };
+
+    struct Vertex {
+        int32_t latitude, longitude;
+    };
+
+    struct Grid {
+        int32_t latitude, longitude; //Lower left corner
+        uint32_t cellHeight, cellWidth; //1e-7 degrees
+        uint32_t rows, columns;
+        uint32_t firstCell; //Index of cell (0, 0) in cellStart
+    };
+
+    int addFence(const Fence& fence);
+    /**
+     * Test a position in 1e-7 degrees
+     */
+    bool containsDegrees(const Fence& fence, int32_t latitude, int32_t longitude) const;
+    size_t queryDegrees(int32_t latitude, int32_t longitude, uint32_t* result, size_t maxFences) const;
+    /**
+     * Find the cell of a position in a grid
+     * @return false if the position is outside of the grid
+     */
+    static bool findCell(const Grid& grid, int32_t latitude, int32_t longitude, size_t* cell);
+    /**
+     * Rows and columns of the cells of a grid overlapped by a bounding box,
+     * clipped to the grid
+     */
+    static void getCellRange(const Grid& grid, const Fence& fence,
+        uint32_t* row0, uint32_t* row1, uint32_t* column0, uint32_t* column1);
+
+    std::vector<Fence> fences;
+    std::vector<Vertex> vertices;
+    bool built;
+    /**
+     * grids[0] covers all fences, the others subdivide single cells of it
+     */
+    std::vector<Grid> grids;
+    /**
+     * Per cell of grids[0]: The index of the grid subdividing it, 0 if it is not subdivided
+     */
+    std::vector<uint32_t> cellGrid;
+    /**
+     * The fences of cell (row, column) of a grid are cellFences[cellStart[cell] .. cellStart[cell + 1] - 1]
+     * with cell = firstCell + row * columns + column. Subdivided cells have no fences.
+     */
+    std::vector<uint32_t> cellStart;
+    std::vector<uint32_t> cellFences;
+};
+
+/**
+ * Enter/exit tracking for a single source. Keep one tracker per receiver.
+ */
+class NMEAGeofenceTracker {
+public:
+    NMEAGeofenceTracker() : result(16) {}
+
+    /**
+     * Query the fences containing the new position of the source and call
+     * onTransition(uint32_t fence, bool entered) for every fence entered or
+     * exited since the last update. Invalid positions are ignored.
+     * @return The number of transitions
+     */
+    template<typename Callback>
+    size_t update(const NMEAGeofenceIndex& index, const NMEAPosition& position, Callback onTransition);
+
+    /**
+     * IDs of the fences containing the last valid position, in ascending order
+     */
+    const std::vector<uint32_t>& getInside() const {
+        return inside;
+    }
+
+    /**
+     * Forget the current fences without exit transitions
+     */
+    void reset() {
+        inside.clear();
+    }
+private:
+    std::vector<uint32_t> inside;
+    std::vector<uint32_t> result;
+};
+
+template<typename Callback>
+size_t NMEAGeofenceTracker::update(const NMEAGeofenceIndex& index, const NMEAPosition& position, Callback onTransition) {
+    if(position.latitude == INT32_MAX || position.longitude == INT32_MAX) {
+        return 0;
+    }
+    size_t n = index.query(position, result.data(), result.size());
+    if(n > result.size()) {
+        result.resize(n);
+        index.query(position, result.data(), result.size());
+    }
+    //Merge the sorted lists
+    size_t transitions = 0;
+    size_t i = 0, j = 0;
+    while(i < inside.size() || j < n) {
+        if(j == n || (i < inside.size() && inside[i] < result[j])) {
+            onTransition(inside[i++], false);
+            transitions++;
+        } else if(i == inside.size() || result[j] < inside[i]) {
+            onTransition(result[j++], true);
+            transitions++;
+        } else {
+            i++;
+            j++;
+        }
+    }
+    if(transitions != 0) {
+        inside.assign(result.begin(), result.begin() + n);
+    }
+    return transitions;
+}
+
+#endif //__NMEA_GEOFENCE_H
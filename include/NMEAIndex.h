@@ -0,0 +1,90 @@
+/**
+ * Structural indexer for bulk buffers of concatenated NMEA sentences.
+ * Finds all structural characters ($ , * \n) using SIMD instructions
+ * where available and computes the XOR checksum of every sentence,
+ * so that downstream parsing can jump straight to the field offsets.
+ */
+#ifndef __NMEA_INDEX_H
+#define __NMEA_INDEX_H
+
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * Index record of a single sentence in the indexed buffer.
+ * All offsets are relative to the start of the buffer.
+ */
+struct NMEASentenceRecord {
+    uint32_t start; //Offset of the '$'
+    uint32_t end; //Offset of the terminating '\n'
+    uint32_t checksumPos; //Offset of the '*' or UINT32_MAX if there is none
+    uint32_t firstStructural; //Index of the '$' in the structurals array
+    uint16_t numStructurals; //Number of structurals from '$' to '\n' (inclusive)
+    uint8_t checksum; //XOR of all bytes between '$' and '*', 0 if there is no '*'
+};
+
+/**
+ * Caller-provided output arrays of indexNMEABuffer().
+ * Indexing stops early at a sentence boundary if any of the arrays is full.
+ */
+struct NMEAStructuralIndex {
+    /**
+     * Offsets of all structural characters of the complete sentences
+     */
+    uint32_t* structurals;
+    size_t maxStructurals;
+    size_t numStructurals;
+    NMEASentenceRecord* sentences;
+    size_t maxSentences;
+    size_t numSentences;
+};
+
+enum NMEAIndexImplementation {
+    NMEAIndexScalar = 0,
+    NMEAIndexSSE2,
+    NMEAIndexAVX2,
+    NMEAIndexNEON
+};
+
+/**
+ * Index a buffer of concatenated sentences.
+ * A sentence starts at '$' and ends at the next '\n'. Bytes outside of sentences
+ * and sentences interrupted by another '$' are ignored.
+ *
+ * The structurals and sentences arrays are filled from the start,
+ * i.e. any previous content is overwritten. Offsets must fit in 32 bits.
+ * @return The number of bytes that have been consumed: The indexed sentences,
+ *  bytes outside of sentences and a first sentence with more structurals than
+ *  maxStructurals, which can never be indexed and is skipped. Any incomplete sentence
+ *  at the end of the buffer (or sentences that did not fit in the remaining index)
+ *  start at that offset, so the caller can keep the rest and call again.
+ */
+size_t indexNMEABuffer(const char* buf, size_t size, NMEAStructuralIndex* index);
+
+/**
+ * Get the offset of the first character of the given field.
+ * Field 0 is the address field (e.g. GPRMC), i.e. it starts after the '$'.
+ * @return The offset or UINT32_MAX if the sentence has less fields
+ */
+uint32_t getNMEAFieldOffset(const NMEAStructuralIndex* index, const NMEASentenceRecord* sentence, unsigned field);
+
+/**
+ * Get the implementation currently used by indexNMEABuffer().
+ * By default, the fastest implementation supported by the CPU is selected at runtime.
+ */
+NMEAIndexImplementation getNMEAIndexImplementation();
+
+/**
+ * Check if the given implementation is supported by the current CPU
+ * (and has been compiled in).
+ */
+bool isNMEAIndexImplementationSupported(NMEAIndexImplementation impl);
+
+/**
+ * Force indexNMEABuffer() to use the given implementation.
+ * May be called while other threads are indexing.
+ * @return 0 on success, -1 if the implementation is not supported.
+ */
+int setNMEAIndexImplementation(NMEAIndexImplementation impl);
+
+#endif //__NMEA_INDEX_H
@@ -0,0 +1,215 @@
+/**
+ * Event-driven ingestion of many NMEA sources (serial ports, ptys,
+ * TCP/UDP or UNIX sockets) on a single thread.
+ * Requires Linux (epoll).
+ */
+#ifndef __NMEA_INGEST_H
+#define __NMEA_INGEST_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "NMEAFramer.h"
+
+/**
+ * Bytes read from a source at once
+ */
+#ifndef NMEA_INGEST_READ_SIZE
+#define NMEA_INGEST_READ_SIZE (64 * 1024)
+#endif
+
+/**
+ * Maximum number of ready sources handled per poll()
+ */
+#ifndef NMEA_INGEST_MAX_EVENTS
+#define NMEA_INGEST_MAX_EVENTS 256
+#endif
+
+enum NMEASourceType {
+    /**
+     * Byte stream (tty, pty, pipe, TCP). Sentences may span reads.
+     */
+    NMEASourceStream,
+    /**
+     * Datagrams (UDP). Every datagram contains complete sentences,
+     * partial sentences are discarded at the end of a datagram.
+     */
+    NMEASourceDatagram
+};
+
+/**
+ * A complete sentence received from a source
+ */
+struct NMEAIngestSentence {
+    uint32_t sourceId;
+    /**
+     * CLOCK_MONOTONIC time in ns at which the read that completed
+     * the sentence returned
+     */
+    uint64_t timestamp;
+    const char* sentence; //Not NUL-terminated, includes \r\n
+    size_t size;
+};
+
+struct NMEASourceStats {
+    uint64_t bytes;
+    uint64_t reads;
+    uint64_t sentences;
+    uint32_t droppedBytes; //See NMEAFramer::getDroppedBytes()
+};
+
+/**
+ * Monotonic timestamp in ns as used by NMEAIngestSentence
+ */
+uint64_t getNMEAMonotonicTime();
+
+/**
+ * Reads all registered sources from one epoll instance.
+ * Every source has its own NMEAFramer, so sentences of different sources
+ * never mix. Each ready source is read once per poll() with a single
+ * bulk read, so busy sources can not starve the others.
+ *
+ * File descriptors are switched to non-blocking mode but not owned:
+ * they are neither closed by removeSource() nor on end of stream.
+ */
+class NMEAIngestLoop {
+public:
+    NMEAIngestLoop();
+    ~NMEAIngestLoop();
+
+    /**
+     * Create the epoll instance
+     * @return 0 on success, -1 on failure
+     */
+    int open();
+
+    /**
+     * Remove all sources and close the epoll instance
+     */
+    void close();
+
+    /**
+     * Register a readable file descriptor.
+     * @param sourceId ID passed with every sentence of this source, must be unique
+     * @return 0 on success, -1 if it could not be registered, -2 if the ID is in use
+     */
+    int addSource(int fd, uint32_t sourceId, NMEASourceType type = NMEASourceStream);
+
+    /**
+     * Unregister a source. May be called from the callbacks of poll(),
+     * no further sentences of the source are passed to the callback then.
+     * @return 0 on success, -1 if the ID is unknown
+     */
+    int removeSource(uint32_t sourceId);
+
+    size_t getNumSources() const {
+        return sources.size();
+    }
+
+    /**
+     * @return 0 on success, -1 if the ID is unknown
+     */
+    int getSourceStats(uint32_t sourceId, NMEASourceStats* stats) const;
+
+    /**
+     * Wait up to timeoutMs (-1: forever, 0: don't wait) for data and process
+     * every ready source. Sources that reached end of stream or failed are removed
+     * before onClose is called.
+     * @param onSentence Callable as onSentence(const NMEAIngestSentence& sentence)
+     * @param onClose Callable as onClose(uint32_t sourceId, int error),
+     *  error is 0 on end of stream, the errno value otherwise
+     * @return The number of sentences received or -1 if epoll_wait() failed
+     */
+    template<typename SentenceCallback, typename CloseCallback>
+    int poll(int timeoutMs, SentenceCallback onSentence, CloseCallback onClose);
+
+    template<typename SentenceCallback>
+    int poll(int timeoutMs, SentenceCallback onSentence) {
+        return poll(timeoutMs, onSentence, [](uint32_t, int) {});
+    }
+private:
+    struct Source {
+        int fd;
+        uint32_t id;
+        NMEASourceType type;
+        bool removed;
+        NMEAFramer framer;
+        uint64_t bytes;
+        uint64_t reads;
+        uint64_t sentences;
+    };
+
+    /**
+     * epoll_wait() and store the ready sources in readySources
+     * @return The number of ready sources or -1
+     */
+    int wait(int timeoutMs);
+
+    /**
+     * Read once from a ready source.
+     * @return The number of bytes read, 0 if nothing was available,
+     *  -1 on end of stream and errors (errno is set, 0 on end of stream)
+     */
+    ssize_t readSource(Source* source);
+
+    /**
+     * Free the sources removed during the last poll()
+     */
+    void releaseRemoved();
+
+    int epollFd;
+    std::unordered_map<uint32_t, Source*> sources;
+    /**
+     * Sources removed while events may still reference them
+     */
+    std::vector<Source*> removedSources;
+    std::vector<char> buffer;
+    std::vector<void*> readySources;
+};
+
+template<typename SentenceCallback, typename CloseCallback>
+int NMEAIngestLoop::poll(int timeoutMs, SentenceCallback onSentence, CloseCallback onClose) {
+    int n = wait(timeoutMs);
+    if(n < 0) {
+        return -1;
+    }
+    int received = 0;
+    for (int i = 0; i < n; ++i) {
+        Source* source = (Source*)readySources[i];
+        if(source->removed) { //Removed by a callback
+            continue;
+        }
+        ssize_t size = readSource(source);
+        if(size < 0) {
+            int error = errno;
+            uint32_t id = source->id;
+            removeSource(id);
+            onClose(id, error);
+            continue;
+        }
+        NMEAIngestSentence sentence;
+        sentence.sourceId = source->id;
+        sentence.timestamp = getNMEAMonotonicTime();
+        size_t emitted = source->framer.feed(buffer.data(), size, [&](const char* data, size_t dataSize) {
+            if(!source->removed) {
+                sentence.sentence = data;
+                sentence.size = dataSize;
+                onSentence(sentence);
+            }
+        });
+        if(source->type == NMEASourceDatagram) {
+            source->framer.abortSentence();
+        }
+        source->sentences += emitted;
+        received += emitted;
+    }
+    releaseRemoved();
+    return received;
+}
+
+#endif //__NMEA_INGEST_H
@@ -0,0 +1,78 @@
+/**
+ * Memory-mapped, multi-threaded replay of raw NMEA capture files.
+ * Requires a POSIX system (mmap) and C++11 threads.
+ */
+#ifndef __NMEA_REPLAY_H
+#define __NMEA_REPLAY_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+
+#include "NMEADispatch.h"
+
+/**
+ * A successfully parsed sentence
+ */
+struct NMEAReplayRecord {
+    /**
+     * Offset of the '$' of the sentence in the capture
+     */
+    uint64_t offset;
+    NMEAParsedSentence sentence;
+};
+
+struct NMEAReplayStats {
+    uint64_t bytes;
+    uint64_t sentences; //Number of GLL, RMC & GSV sentences
+    uint64_t parseErrors; //Number of GLL, RMC & GSV sentences that could not be parsed
+    double seconds; //Wall clock time of the replay
+
+    double sentencesPerSecond() const {
+        return seconds > 0 ? sentences / seconds : 0;
+    }
+
+    double bytesPerSecond() const {
+        return seconds > 0 ? bytes / seconds : 0;
+    }
+};
+
+/**
+ * Replays a capture by splitting it into chunks realigned to the next '$',
+ * parsing the chunks in parallel and passing the results to a callback
+ * in input order.
+ *
+ * The number of chunks being parsed or waiting to be delivered is bounded,
+ * so the memory usage does not depend on the capture size.
+ */
+class NMEAReplayEngine {
+public:
+    typedef std::function<void(const NMEAReplayRecord&)> Callback;
+
+    /**
+     * @param numThreads Number of parser threads. 0 means one per hardware thread.
+     * @param chunkSize Approximate number of bytes per chunk
+     */
+    explicit NMEAReplayEngine(unsigned numThreads = 0, size_t chunkSize = 4 << 20);
+
+    /**
+     * Map the given file and replay it.
+     * @param stats If not NULL, filled with replay statistics
+     * @return 0 on success, -1 if the file could not be opened, -2 if it could not be mapped
+     */
+    int replayFile(const char* filename, Callback callback, NMEAReplayStats* stats);
+
+    /**
+     * Replay a buffer that is already in memory.
+     */
+    void replayBuffer(const char* buf, size_t size, Callback callback, NMEAReplayStats* stats);
+
+    unsigned getNumThreads() const {
+        return numThreads;
+    }
+private:
+    unsigned numThreads;
+    size_t chunkSize;
+};
+
+#endif //__NMEA_REPLAY_H
@@ -0,0 +1,332 @@
+/**
+ * Lock-free single-producer / single-consumer byte ring
+ * for passing serial data from an ISR or reader thread to the parser.
+ * Uses neither the heap nor exceptions.
+ */
+#ifndef __NMEA_RING_H
+#define __NMEA_RING_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#include "NMEAFramer.h"
+#include "NMEAStats.h"
+
+/*
+ * The ring only loads and stores its 32 bit atomics, it never uses read-modify-write
+ * operations. Aligned 32 bit loads and stores are lock-free wherever int atomics are
+ * at least sometimes lock-free, e.g. on ARMv6-M (Cortex-M0), which has no
+ * read-modify-write instructions and therefore reports ATOMIC_INT_LOCK_FREE == 1.
+ * Note that NMEA_ENABLE_STATS adds fetch_add() calls, which need libatomic there.
+ */
+#if ATOMIC_INT_LOCK_FREE == 0
+#error "NMEARing requires lock-free 32 bit atomic loads and stores"
+#endif
+
+/**
+ * A complete sentence in the ring, from '$' to '\n' (inclusive).
+ * If the sentence wraps around the end of the ring, it consists
+ * of two segments, otherwise second is NULL and secondSize is 0.
+ * The sentence stays valid until it is consumed.
+ */
+struct NMEARingSentence {
+    const char* first;
+    size_t firstSize;
+    const char* second;
+    size_t secondSize;
+    uint32_t position; //Ring position of the '$'
+
+    size_t size() const {
+        return firstSize + secondSize;
+    }
+
+    bool isWrapped() const {
+        return secondSize != 0;
+    }
+
+    char operator[](size_t idx) const {
+        return idx < firstSize ? first[idx] : second[idx - firstSize];
+    }
+
+    /**
+     * Get the sentence as one contiguous buffer. Only wrapped
+     * sentences are copied (into scratch, NUL-terminated).
+     * @param scratch Must have space for NMEA_FRAMER_BUFSIZE bytes
+     */
+    const char* linearize(char* scratch) const {
+        if(secondSize == 0) {
+            return first;
+        }
+        memcpy(scratch, first, firstSize);
+        memcpy(scratch + firstSize, second, secondSize);
+        scratch[firstSize + secondSize] = '\0';
+        return scratch;
+    }
+};
+
+/**
+ * Fixed-capacity ring. The producer (e.g. a UART RX interrupt) appends
+ * bytes with write() or getWriteSpace()/commitWrite(). The consumer views
+ * complete sentences in place with nextSentence() and releases them with consume().
+ *
+ * Positions are free-running 32 bit counters, published with release/acquire
+ * ordering, so each side only writes its own index.
+ *
+ * Framing rules are the same as for NMEAFramer: garbage before '$' is dropped,
+ * a '$' inside a sentence resynchronizes, sentences must end with \r\n and
+ * are at most NMEA_FRAMER_BUFSIZE - 1 bytes long.
+ * Bytes dropped by an overrun may splice two sentences; the checksum
+ * of such a sentence is wrong.
+ *
+ * @tparam Capacity Size of the ring in bytes, must be a power of two
+ */
+template<uint32_t Capacity>
+class NMEARing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(Capacity <= (1u << 31), "Capacity must fit the 32 bit positions");
+public:
+    NMEARing() : head(0), tail(0), overrunBytes(0), overruns(0), highWater(0),
+        droppedBytes(0), resyncs(0), scan(0) {}
+
+    /*
+     * Producer
+     */
+
+    /**
+     * Append as many bytes as fit. The remaining bytes are dropped
+     * and counted as an overrun, so this never blocks (e.g. in an ISR).
+     * @return The number of bytes written
+     */
+    uint32_t write(const char* data, uint32_t size) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t used = t - head.load(std::memory_order_acquire);
+        uint32_t n = size < Capacity - used ? size : Capacity - used;
+        uint32_t offset = t & (Capacity - 1);
+        uint32_t firstSize = n < Capacity - offset ? n : Capacity - offset;
+        memcpy(buffer + offset, data, firstSize);
+        memcpy(buffer, data + firstSize, n - firstSize);
+        tail.store(t + n, std::memory_order_release);
+        if(n < size) {
+            //Only the producer modifies the counters, no read-modify-write needed
+            overrunBytes.store(overrunBytes.load(std::memory_order_relaxed) + (size - n), std::memory_order_relaxed);
+            overruns.store(overruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            NMEA_STATS_ADD(NMEAStatsOverrunBytes, size - n);
+            NMEA_STATS_ADD(NMEAStatsOverruns, 1);
+        }
+        updateHighWater(used + n);
+        return n;
+    }
+
+    /**
+     * Append a single byte, e.g. from a byte-wise UART interrupt.
+     * @return false on overrun
+     */
+    bool put(char c) {
+        return write(&c, 1) == 1;
+    }
+
+    /**
+     * Get the contiguous free space at the write position,
+     * e.g. to read() or DMA into the ring directly.
+     * @return The number of bytes that may be written to *ptr
+     */
+    uint32_t getWriteSpace(char** ptr) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t space = Capacity - (t - head.load(std::memory_order_acquire));
+        uint32_t offset = t & (Capacity - 1);
+        *ptr = buffer + offset;
+        return space < Capacity - offset ? space : Capacity - offset;
+    }
+
+    /**
+     * Publish size bytes written to the space returned by getWriteSpace()
+     */
+    void commitWrite(uint32_t size) {
+        uint32_t t = tail.load(std::memory_order_relaxed) + size;
+        tail.store(t, std::memory_order_release);
+        updateHighWater(t - head.load(std::memory_order_relaxed));
+    }
+
+    /*
+     * Consumer
+     */
+
+    /**
+     * Find the next complete sentence. Each byte is only scanned once,
+     * even if the sentence is completed by later writes.
+     * Returns the same sentence again until it is consumed.
+     * @return false if no complete sentence is available
+     */
+    bool nextSentence(NMEARingSentence* sentence);
+
+    /**
+     * Release a sentence returned by nextSentence() and everything before it
+     */
+    void consume(const NMEARingSentence& sentence) {
+        setHead(sentence.position + (uint32_t)sentence.size());
+    }
+
+    /**
+     * Call onSentence(const NMEARingSentence& sentence) for every complete
+     * sentence and consume it afterwards.
+     * @return The number of sentences
+     */
+    template<typename Callback>
+    size_t readSentences(Callback onSentence) {
+        size_t count = 0;
+        NMEARingSentence sentence;
+        while(nextSentence(&sentence)) {
+            onSentence(sentence);
+            consume(sentence);
+            count++;
+        }
+        return count;
+    }
+
+    /**
+     * Number of bytes in the ring, including incomplete sentences
+     */
+    uint32_t available() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_relaxed);
+    }
+
+    /*
+     * Statistics. May be read from any thread.
+     */
+
+    static constexpr uint32_t capacity() {
+        return Capacity;
+    }
+
+    /**
+     * Number of bytes dropped because the ring was full
+     */
+    uint32_t getOverrunBytes() const {
+        return overrunBytes.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Number of writes that did not fit completely
+     */
+    uint32_t getOverruns() const {
+        return overruns.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Maximum number of bytes that have been in the ring
+     */
+    uint32_t getHighWater() const {
+        return highWater.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Number of bytes the consumer discarded because they were not part
+     * of a valid sentence, see NMEAFramer::getDroppedBytes()
+     */
+    uint32_t getDroppedBytes() const {
+        return droppedBytes.load(std::memory_order_relaxed);
+    }
+
+    uint32_t getResyncs() const {
+        return resyncs.load(std::memory_order_relaxed);
+    }
+private:
+    char at(uint32_t pos) const {
+        return buffer[pos & (Capacity - 1)];
+    }
+
+    void updateHighWater(uint32_t used) {
+        if(used > highWater.load(std::memory_order_relaxed)) {
+            highWater.store(used, std::memory_order_relaxed);
+        }
+    }
+
+    void setHead(uint32_t pos) {
+        head.store(pos, std::memory_order_release);
+    }
+
+    /**
+     * Discard [head, pos) as invalid
+     */
+    void drop(uint32_t h, uint32_t pos) {
+        droppedBytes.store(droppedBytes.load(std::memory_order_relaxed) + (pos - h), std::memory_order_relaxed);
+        NMEA_STATS_ADD(NMEAStatsDroppedBytes, pos - h);
+        setHead(pos);
+    }
+
+    char buffer[Capacity];
+    std::atomic<uint32_t> head; //Written by the consumer
+    std::atomic<uint32_t> tail; //Written by the producer
+    //Written by the producer
+    std::atomic<uint32_t> overrunBytes;
+    std::atomic<uint32_t> overruns;
+    std::atomic<uint32_t> highWater;
+    //Written by the consumer
+    std::atomic<uint32_t> droppedBytes;
+    std::atomic<uint32_t> resyncs;
+    uint32_t scan; //Next position to scan for the end of the sentence at head
+};
+
+template<uint32_t Capacity>
+bool NMEARing<Capacity>::nextSentence(NMEARingSentence* sentence) {
+    //A sentence that fills the ring could never be completed
+    const uint32_t maxSize = NMEA_FRAMER_BUFSIZE - 1 < Capacity ? NMEA_FRAMER_BUFSIZE - 1 : Capacity;
+    uint32_t t = tail.load(std::memory_order_acquire);
+    for(;;) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        //Skip to the start of the next sentence
+        uint32_t start = h;
+        while(start != t && at(start) != '$') {
+            start++;
+        }
+        if(start != h) {
+            drop(h, start);
+            h = start;
+        }
+        if(h == t) {
+            return false;
+        }
+        if((int32_t)(scan - h) <= 0) {
+            scan = h + 1;
+        }
+        //Find the end of the sentence
+        bool restart = false;
+        for (; scan != t; scan++) {
+            char c = at(scan);
+            if(c == '$') { //Incomplete sentence followed by a new one
+                resyncs.store(resyncs.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                NMEA_STATS_ADD(NMEAStatsResyncs, 1);
+                drop(h, scan);
+                restart = true;
+                break;
+            }
+            if(c == '\n') {
+                uint32_t size = scan + 1 - h;
+                if(size < 4 || at(scan - 1) != '\r') {
+                    drop(h, scan + 1);
+                    restart = true;
+                    break;
+                }
+                uint32_t offset = h & (Capacity - 1);
+                sentence->position = h;
+                sentence->first = buffer + offset;
+                sentence->firstSize = size < Capacity - offset ? size : Capacity - offset;
+                sentence->second = sentence->firstSize < size ? buffer : NULL;
+                sentence->secondSize = size - sentence->firstSize;
+                //scan stays at the end, so the sentence is returned again until it is consumed
+                return true;
+            }
+            if(scan + 1 - h >= maxSize) { //Overlong sentence
+                drop(h, scan + 1);
+                restart = true;
+                break;
+            }
+        }
+        if(!restart) {
+            return false;
+        }
+    }
+}
+
+#endif //__NMEA_RING_H
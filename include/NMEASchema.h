@@ -0,0 +1,505 @@
+/**
+ * Declarative compile-time schemas for NMEA sentence parsers.
+ *
+ * A sentence is described as a list of typed fields, e.g.
+ *   typedef NMEASchema<
+ *       NMEAUTCTimeField<NMEA_MEMBER(RMCSentence, utcTime), -2>,
+ *       NMEACharField<NMEA_MEMBER(RMCSentence, status), -3, 'A', 'V'>,
+ *       ...> RMCSchema;
+ * RMCSchema::parse(view, &result) then parses the fields in order.
+ * The field list is expanded at compile time, so every field is handled
+ * by inlined code with a constant field index. There is no runtime interpretation.
+ *
+ * Field conventions:
+ *  - Every field must exist in the sentence, else -1 is returned
+ *    (like a missing ',' in the hand-written parsers). Wrap a field in
+ *    NMEATrailingField<> if it may be absent, e.g. fields added in newer NMEA versions.
+ *  - Fields with a non-zero error code (rc) are required to be valid,
+ *    else rc is returned.
+ *  - Fields with rc = 0 are optional: If they are empty or invalid,
+ *    INT32_MAX (converted to the member type) is stored.
+ *
+ * RMCSchema::decode(view, &result, fieldMask) is the lenient alternative
+ * to parse(): Only the fields selected by fieldMask (bit n = field n,
+ * see nmeaFieldBit()) are decoded, the members of all other fields are
+ * not modified. Error codes are ignored; instead, the mask of the fields
+ * that were present and valid is returned, so a sentence with e.g. an
+ * empty speed still yields a usable position. With a compile-time mask,
+ * RMCSchema::decode<Mask>(view, &result), the code for unselected fields
+ * is not generated at all. Selecting a coordinate also selects its
+ * N/S or E/W direction field, which determines the sign.
+ */
+#ifndef __NMEA_SCHEMA_H
+#define __NMEA_SCHEMA_H
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "NMEA.h"
+
+/**
+ * Accessor for a member of a struct
+ */
+template<typename S, typename T, T S::*Ptr>
+struct NMEAMember {
+    typedef S Struct;
+    typedef T Type;
+    static inline T& get(S* s) {
+        return s->*Ptr;
+    }
+};
+
+/**
+ * Accessor for a member of a member, e.g. RMCSentence::position.latitude
+ */
+template<typename Outer, typename Inner>
+struct NMEANestedMember {
+    typedef typename Outer::Struct Struct;
+    typedef typename Inner::Type Type;
+    static inline Type& get(Struct* s) {
+        return Inner::get(&Outer::get(s));
+    }
+};
+
+#define NMEA_MEMBER(S, member) NMEAMember<S, decltype(S::member), &S::member>
+#define NMEA_NESTED_MEMBER(S, member, Inner, innerMember) \
+    NMEANestedMember<NMEA_MEMBER(S, member), NMEA_MEMBER(Inner, innerMember)>
+
+/**
+ * Validity / field mask bit of field idx. Fields beyond bit 31 can not be selected.
+ */
+constexpr uint32_t nmeaFieldBit(size_t idx) {
+    return idx < 32 ? (uint32_t)1 << idx : 0;
+}
+
+/**
+ * Mask of width consecutive fields starting at idx
+ */
+constexpr uint32_t nmeaFieldBits(size_t idx, size_t width) {
+    return width == 0 ? 0 : nmeaFieldBit(idx) | nmeaFieldBits(idx + 1, width - 1);
+}
+
+/**
+ * Fixed point decimal or integer with an optional leading '-', INT32_MAX if invalid
+ */
+static inline int32_t nmeaSignedFixedPoint(const NMEASentenceView& view, size_t idx, int decimals) {
+    if(view.character(idx) == '-') {
+        int32_t value = parseNMEAFixedPointDecimal(view.field(idx) + 1, view.fieldSize(idx) - 1, decimals);
+        return value == INT32_MAX ? INT32_MAX : -value;
+    }
+    return view.fixedPoint(idx, decimals);
+}
+
+static inline int32_t nmeaSignedInteger(const NMEASentenceView& view, size_t idx) {
+    if(view.character(idx) == '-') {
+        int32_t value = parseNMEAInteger(view.field(idx) + 1, view.fieldSize(idx) - 1);
+        return value == INT32_MAX ? INT32_MAX : -value;
+    }
+    return view.integer(idx);
+}
+
+/**
+ * Store a decoded value and add it to the validity mask if it is valid
+ */
+template<typename M, typename S>
+static inline uint32_t nmeaDecodeStore(S* s, int32_t value, size_t idx, uint32_t valid) {
+    M::get(s) = (typename M::Type)value;
+    return value == INT32_MAX ? valid : valid | nmeaFieldBit(idx);
+}
+
+/**
+ * Return -1 if the sentence does not have the given field
+ */
+#define NMEASchemaRequireField(view, idx) if((idx) >= (view).numFields()) {return -1;}(void)0
+
+/**
+ * Store a decoded value. Returns rc from the calling function if
+ * the value is invalid and the field is required.
+ */
+#define NMEASchemaStore(M, s, value, rc) \
+    if((rc) != 0 && (value) == INT32_MAX) {return (rc);} \
+    M::get(s) = (typename M::Type)(value)
+
+/**
+ * A field that is not decoded
+ */
+struct NMEASkipField {
+    static const size_t width = 1;
+    template<typename S>
+    static inline int parse(const NMEASentenceView& view, size_t idx, S*) {
+        NMEASchemaRequireField(view, idx);
+        return 0;
+    }
+    template<typename S>
+    static inline uint32_t decode(const NMEASentenceView&, size_t, S*, uint32_t, uint32_t valid) {
+        return valid;
+    }
+};
+
+/**
+ * Unsigned fixed point decimal, see parseNMEAFixedPointDecimal()
+ */
+template<typename M, int Decimals, int rc>
+struct NMEAFixedPointField {
+    static const size_t width = 1;
+    template<typename S>
+    static inline int parse(const NMEASentenceView& view, size_t idx, S* s) {
+        NMEASchemaRequireField(view, idx);
+        int32_t value = view.fixedPoint(idx, Decimals);
+        NMEASchemaStore(M, s, value, rc);
+        return 0;
+    }
+    template<typename S>
+    static inline uint32_t decode(const NMEASentenceView& view, size_t idx, S* s, uint32_t, uint32_t valid) {
+        return nmeaDecodeStore<M>(s, view.fixedPoint(idx, Decimals), idx, valid);
+    }
+};
+
+/**
+ * Fixed point decimal with an optional leading '-'
+ */
+template<typename M, int Decimals, int rc>
+struct NMEASignedFixedPointField {
+    static const size_t width = 1;
+    template<typename S>
+    static inline int parse(const NMEASentenceView& view, size_t idx, S* s) {
+        NMEASchemaRequireField(view, idx);
+        int32_t value = nmeaSignedFixedPoint(view, idx, Decimals);
+        NMEASchemaStore(M, s, value, rc);
+        return 0;
+    }
+    template<typename S>
+    static inline uint32_t decode(const NMEASentenceView& view, size_t idx, S* s, uint32_t, uint32_t valid) {
+        return nmeaDecodeStore<M>(s, nmeaSignedFixedPoint(view, idx, Decimals), idx, valid);
+    }
+};
+
+/**
+ * Unsigned integer, see parseNMEAInteger()
+ */
+template<typename M, int rc>
+struct NMEAIntegerField {
+    static const size_t width = 1;
+    template<typename S>
+    static inline int parse(const NMEASentenceView& view, size_t idx, S* s) {
+        NMEASchemaRequireField(view, idx);
+        int32_t value = view.integer(idx);
+        NMEASchemaStore(M, s, value, rc);
+        return 0;
+    }
+    template<typename S>
+    static inline uint32_t decode(const NMEASentenceView& view, size_t idx, S* s, uint32_t, uint32_t valid) {
+        return nmeaDecodeStore<M>(s, view.integer(idx), idx, valid);
+    }
+};
+
+/**
+ * Integer with an optional leading '-'
+ */
+template<typename M, int rc>
+struct NMEASignedIntegerField {
+    static const size_t width = 1;
+    template<typename S>
+    static inline int parse(const NMEASentenceView& view, size_t idx, S* s) {
+        NMEASchemaRequireField(view, idx);
+        int32_t value = nmeaSignedInteger(view, idx);
+        NMEASchemaStore(M, s, value, rc);
+        return 0;
+    }
+    template<typename S>
+    static inline uint32_t decode(const NMEASentenceView& view, size_t idx, S* s, uint32_t, uint32_t valid) {
+        return nmeaDecodeStore<M>(s, nmeaSignedInteger(view, idx), idx, valid);
+    }
+};
+
+template<typename M, int rc>
+struct NMEACoordinateField : public NMEAFixedPointField<M, 5, rc> {};
+
+template<typename M, int rc>
+struct NMEAUTCTimeField : public NMEAFixedPointField<M, 2, rc> {};
+
+/**
+ * N/E/S/W direction, applied to a previously parsed coordinate.
+ * See applyDirectionSignToCoordinate()
+ * When decoding, the sign is only applied if the coordinate (field idx - 1)
+ * has been decoded. A coordinate without a valid direction is invalid.
+ */
+template<typename M, int rc>
+struct NMEADirectionField {
+    static const size_t width = 1;
+    template<typename S>
+    static inline int parse(const NMEASentenceView& view, size_t idx, S* s) {
+        NMEASchemaRequireField(view, idx);
+        if(applyDirectionSignToCoordinate(view.character(idx), &M::get(s))) {
+            return rc;
+        }
+        return 0;
+    }
+    template<typename S>
+    static inline uint32_t decode(const NMEASentenceView& view, size_t idx, S* s, uint32_t, uint32_t valid) {
+        char c = view.character(idx);
+        bool directionValid = c == 'N' || c == 'E' || c == 'S' || c == 'W';
+        uint32_t coordinateBit = nmeaFieldBit(idx - 1);
+        if(valid & coordinateBit) {
+            if(!directionValid) {
+                M::get(s) = INT32_MAX;
+                return valid & ~coordinateBit;
+            }
+            applyDirectionSignToCoordinate(c, &M::get(s));
+        }
+        return directionValid ? valid | nmeaFieldBit(idx) : valid;
+    }
+};
+
+/**
+ * Fields that decode() selects in addition to the mask, given the mask
+ * and the index of the field. None for most fields.
+ */
+template<typename Field>
+struct NMEAImpliedFields {
+    static constexpr uint32_t get(size_t, uint32_t) {
+        return 0;
+    }
+};
+
+/**
+ * The direction of a selected coordinate, without it the sign would be unknown
+ */
+template<typename M, int rc>
+struct NMEAImpliedFields<NMEADirectionField<M, rc> > {
+    static constexpr uint32_t get(size_t idx, uint32_t mask) {
+        return (mask & nmeaFieldBit(idx - 1)) ? nmeaFieldBit(idx) : 0;
+    }
+};
+
+/**
+ * Check if c is one of the given characters. An empty list allows any character.
+ */
+static inline bool isNMEACharAllowed(char) {
+    return false;
+}
+
+template<typename... Chars>
+static inline bool isNMEACharAllowed(char c, char first, Chars... rest) {
+    return c == first || isNMEACharAllowed(c, rest...);
+}
+
+/**
+ * Single character, e.g. a status or mode field.
+ * Stores '\0' for empty fields. If Allowed is not empty,
+ * the character must be one of them, else rc is returned (if non-zero)
+ * or '\0' is stored (if optional or decoded).
+ */
+template<typename M, int rc, char... Allowed>
+struct NMEACharField {
+    static const size_t width = 1;
+    template<typename S>
+    static inline int parse(const NMEASentenceView& view, size_t idx, S* s) {
+        NMEASchemaRequireField(view, idx);
+        char c = view.character(idx);
+        if(sizeof...(Allowed) != 0 && !isNMEACharAllowed(c, Allowed...)) {
+            M::get(s) = rc != 0 ? c : '\0';
+            return rc;
+        }
+        M::get(s) = c;
+        return 0;
+    }
+    template<typename S>
+    static inline uint32_t decode(const NMEASentenceView& view, size_t idx, S* s, uint32_t, uint32_t valid) {
+        char c = view.character(idx);
+        if(c == '\0' || (sizeof...(Allowed) != 0 && !isNMEACharAllowed(c, Allowed...))) {
+            M::get(s) = '\0';
+            return valid;
+        }
+        M::get(s) = c;
+        return valid | nmeaFieldBit(idx);
+    }
+};
+
+/**
+ * N consecutive optional integer fields stored in an array member
+ */
+template<typename M, size_t N>
+struct NMEAIntegerArrayField {
+    static const size_t width = N;
+    template<typename S>
+    static inline int parse(const NMEASentenceView& view, size_t idx, S* s) {
+        NMEASchemaRequireField(view, idx + N - 1);
+        for (size_t i = 0; i < N; ++i) {
+            M::get(s)[i] = view.integer(idx + i);
+        }
+        return 0;
+    }
+    /**
+     * Only the selected elements are decoded
+     */
+    template<typename S>
+    static inline uint32_t decode(const NMEASentenceView& view, size_t idx, S* s, uint32_t mask, uint32_t valid) {
+        for (size_t i = 0; i < N; ++i) {
+            if(mask & nmeaFieldBit(idx + i)) {
+                int32_t value = view.integer(idx + i);
+                M::get(s)[i] = value;
+                valid |= value == INT32_MAX ? 0 : nmeaFieldBit(idx + i);
+            }
+        }
+        return valid;
+    }
+};
+
+/**
+ * A field that may be absent, e.g. because it was added in a newer NMEA version.
+ * If it is absent, it is parsed like an empty field.
+ */
+template<typename Field>
+struct NMEATrailingField {
+    static const size_t width = Field::width;
+    template<typename S>
+    static inline int parse(const NMEASentenceView& view, size_t idx, S* s) {
+        if(idx >= view.numFields()) {
+            NMEASentenceView empty("");
+            return Field::parse(empty, 0, s);
+        }
+        return Field::parse(view, idx, s);
+    }
+    template<typename S>
+    static inline uint32_t decode(const NMEASentenceView& view, size_t idx, S* s, uint32_t mask, uint32_t valid) {
+        //Absent fields are decoded as empty fields anyway
+        return Field::decode(view, idx, s, mask, valid);
+    }
+};
+
+/**
+ * Recursive expansion of a field list. Each field is parsed
+ * at a compile-time offset relative to idx.
+ */
+template<typename... Fields>
+struct NMEAFieldList;
+
+template<>
+struct NMEAFieldList<> {
+    static const size_t width = 0;
+    template<typename S>
+    static inline int parse(const NMEASentenceView&, size_t, S*) {
+        return 0;
+    }
+    template<typename S>
+    static inline uint32_t decode(const NMEASentenceView&, size_t, S*, uint32_t, uint32_t valid) {
+        return valid;
+    }
+    static constexpr uint32_t impliedFields(size_t, uint32_t) {
+        return 0;
+    }
+};
+
+template<typename Field, typename... Rest>
+struct NMEAFieldList<Field, Rest...> {
+    static const size_t width = Field::width + NMEAFieldList<Rest...>::width;
+    template<typename S>
+    static inline int parse(const NMEASentenceView& view, size_t idx, S* s) {
+        int rc = Field::parse(view, idx, s);
+        if(rc != 0) {
+            return rc;
+        }
+        return NMEAFieldList<Rest...>::parse(view, idx + Field::width, s);
+    }
+    /**
+     * Decode the fields selected by mask. For compile-time masks,
+     * the check is folded and unselected fields generate no code.
+     */
+    template<typename S>
+    static inline uint32_t decode(const NMEASentenceView& view, size_t idx, S* s, uint32_t mask, uint32_t valid) {
+        if(mask & nmeaFieldBits(idx, Field::width)) {
+            valid = Field::decode(view, idx, s, mask, valid);
+        }
+        return NMEAFieldList<Rest...>::decode(view, idx + Field::width, s, mask, valid);
+    }
+    /**
+     * Fields implied by mask, see NMEAImpliedFields
+     */
+    static constexpr uint32_t impliedFields(size_t idx, uint32_t mask) {
+        return NMEAImpliedFields<Field>::get(idx, mask) | NMEAFieldList<Rest...>::impliedFields(idx + Field::width, mask);
+    }
+};
+
+/**
+ * Up to MaxCount repetitions of a group of fields at the end of a sentence,
+ * e.g. the satellite infos of GSV. The groups are parsed into the elements
+ * of ArrayM; CountM is set to the number of groups present.
+ * A group is present if its first field exists.
+ */
+template<typename ArrayM, typename CountM, size_t MaxCount, typename... GroupFields>
+struct NMEARepeatedGroupField {
+    typedef NMEAFieldList<GroupFields...> Group;
+    static const size_t width = Group::width * MaxCount;
+    template<typename S>
+    static inline int parse(const NMEASentenceView& view, size_t idx, S* s) {
+        CountM::get(s) = 0;
+        for (size_t i = 0; i < MaxCount; ++i) {
+            size_t base = idx + i * Group::width;
+            if(base >= view.numFields()) {
+                break;
+            }
+            CountM::get(s)++;
+            int rc = Group::parse(view, base, &ArrayM::get(s)[i]);
+            if(rc != 0) {
+                return rc;
+            }
+        }
+        return 0;
+    }
+    /**
+     * CountM is always set if any field of the groups is selected.
+     * Group elements beyond the count are not modified.
+     */
+    template<typename S>
+    static inline uint32_t decode(const NMEASentenceView& view, size_t idx, S* s, uint32_t mask, uint32_t valid) {
+        CountM::get(s) = 0;
+        for (size_t i = 0; i < MaxCount; ++i) {
+            size_t base = idx + i * Group::width;
+            if(base >= view.numFields()) {
+                break;
+            }
+            CountM::get(s)++;
+            valid = Group::decode(view, base, &ArrayM::get(s)[i], mask, valid);
+        }
+        return valid;
+    }
+};
+
+/**
+ * A sentence schema. Field 0 (the address field) is not part of the schema.
+ */
+template<typename... Fields>
+struct NMEASchema {
+    /**
+     * @return 0 on success, the rc of the first invalid field or -1 if a field is missing
+     */
+    template<typename S>
+    static inline int parse(const NMEASentenceView& view, S* result) {
+        return NMEAFieldList<Fields...>::parse(view, 1, result);
+    }
+
+    /**
+     * Mask of all fields of the schema
+     */
+    static constexpr uint32_t allFields = nmeaFieldBits(1, NMEAFieldList<Fields...>::width);
+
+    /**
+     * Decode the fields selected by fieldMask, see the file comment.
+     * Never fails.
+     * @return The mask of the selected fields that are present and valid
+     */
+    template<typename S>
+    static inline uint32_t decode(const NMEASentenceView& view, S* result, uint32_t fieldMask) {
+        fieldMask |= NMEAFieldList<Fields...>::impliedFields(1, fieldMask);
+        return NMEAFieldList<Fields...>::decode(view, 1, result, fieldMask, 0);
+    }
+
+    template<uint32_t FieldMask, typename S>
+    static inline uint32_t decode(const NMEASentenceView& view, S* result) {
+        return NMEAFieldList<Fields...>::decode(view, 1, result,
+            FieldMask | NMEAFieldList<Fields...>::impliedFields(1, FieldMask), 0);
+    }
+};
+
+#endif //__NMEA_SCHEMA_H
@@ -0,0 +1,183 @@
+/**
+ * Sparse time index over raw NMEA capture files, stored in a sidecar file.
+ * Requires a POSIX system (file descriptors, mmap).
+ *
+ * Sidecar layout (little endian):
+ *  - "NMEASEK1", uint32 interval in seconds, uint32 reserved
+ *  - Entries: uint64 time key (see makeNMEATimeKey()), uint64 capture offset
+ *
+ * Seeking requires the receiver time of the capture to be non-decreasing.
+ * The builder stops at the first RMC sentence whose time goes backwards.
+ */
+#ifndef __NMEA_SEEK_INDEX_H
+#define __NMEA_SEEK_INDEX_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "NMEA.h"
+#include "NMEADispatch.h"
+#include "NMEATrack.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "The seek index is written and mapped in host byte order and requires a little endian host"
+#endif
+
+#define NMEA_SEEK_INDEX_DEFAULT_INTERVAL 10
+
+struct NMEASeekIndexEntry {
+    uint64_t key; //Time key of the RMC sentence
+    uint64_t offset; //Offset of the '$' of the RMC sentence in the capture
+};
+
+/**
+ * Builds the sidecar index of a capture. An entry is recorded for the first
+ * RMC sentence with a valid checksum, date and time, and then whenever
+ * the receiver time has advanced by at least the interval since the last entry.
+ *
+ * The capture may still be appended to: update() only indexes complete lines
+ * and continues where the previous call stopped. An existing sidecar is
+ * continued, so the index can also be updated by separate processes over time.
+ */
+class NMEASeekIndexBuilder {
+public:
+    explicit NMEASeekIndexBuilder(uint32_t intervalSeconds = NMEA_SEEK_INDEX_DEFAULT_INTERVAL);
+    ~NMEASeekIndexBuilder();
+
+    /**
+     * @return 0 on success, -1 if the capture could not be opened,
+     *  -2 if the index could not be opened or created,
+     *  -3 if the existing index is invalid or has a different interval
+     */
+    int open(const char* captureFilename, const char* indexFilename);
+
+    /**
+     * Index the lines appended to the capture since the last call.
+     * @return The number of new entries, -1 on I/O errors,
+     *  -2 if the receiver time goes backwards at getIndexedBytes().
+     *  Entries added before are kept, but the rest of the capture can not be indexed.
+     */
+    int update();
+
+    void close();
+
+    /**
+     * Number of capture bytes that have been indexed
+     */
+    uint64_t getIndexedBytes() const {
+        return scanOffset;
+    }
+private:
+    int addEntry(uint64_t key, uint64_t offset);
+
+    uint32_t interval;
+    int captureFd;
+    int indexFd;
+    uint64_t scanOffset; //Start of the first line that has not been indexed
+    bool hasEntry;
+    int64_t lastSeconds; //Receiver time of the last entry
+    uint64_t lastKey; //Time key of the last valid RMC sentence, 0 if none
+    std::vector<char> buffer;
+};
+
+/**
+ * Time-based access to a capture using its sidecar index.
+ * Both files are memory mapped, so a lookup only touches the index
+ * entries of the binary search and the capture pages being parsed.
+ */
+class NMEACaptureSeeker {
+public:
+    NMEACaptureSeeker();
+    ~NMEACaptureSeeker();
+
+    /**
+     * @return 0 on success, -1 if a file could not be opened, -2 if it could not be mapped,
+     *  -3 if the index is invalid
+     */
+    int open(const char* captureFilename, const char* indexFilename);
+
+    void close();
+
+    size_t getNumEntries() const {
+        return numEntries;
+    }
+
+    const NMEASeekIndexEntry& getEntry(size_t idx) const {
+        return entries[idx];
+    }
+
+    /**
+     * Get the offset to start parsing at to find the sentences at the given time,
+     * i.e. the offset of the last entry with a key <= key, 0 if there is none.
+     * Binary search, relies on the ascending keys written by the builder.
+     */
+    uint64_t findOffset(uint64_t key) const;
+
+    /**
+     * Call callback(const char* sentence, size_t size, uint64_t key) for every
+     * sentence of the epochs with a time key in [fromKey, toKey]. The key of an
+     * epoch is that of its RMC sentence; other sentences belong to the epoch
+     * of the preceding RMC sentence. Sentences are not NUL-terminated.
+     * Parsing starts at findOffset(fromKey) and stops at the first RMC after toKey,
+     * so RMC sentences must have non-decreasing keys (see NMEASeekIndexBuilder::update()).
+     * @return The number of sentences passed to the callback
+     */
+    template<typename Callback>
+    size_t query(uint64_t fromKey, uint64_t toKey, Callback callback) const;
+
+    const char* getCapture() const {
+        return capture;
+    }
+
+    size_t getCaptureSize() const {
+        return captureSize;
+    }
+private:
+    const char* capture;
+    size_t captureSize;
+    const uint8_t* indexMap;
+    size_t indexSize;
+    const NMEASeekIndexEntry* entries;
+    size_t numEntries;
+};
+
+/**
+ * Get the time key of an RMC sentence, NMEA_TIME_KEY_INVALID if it has
+ * no valid date and time or a wrong checksum.
+ */
+uint64_t getNMEARMCTimeKey(const char* sentence, size_t size);
+
+template<typename Callback>
+size_t NMEACaptureSeeker::query(uint64_t fromKey, uint64_t toKey, Callback callback) const {
+    size_t count = 0;
+    const char* pos = capture + findOffset(fromKey);
+    const char* end = capture + captureSize;
+    uint64_t key = NMEA_TIME_KEY_INVALID;
+    while(pos < end) {
+        const char* start = (const char*)memchr(pos, '$', end - pos);
+        if(start == NULL) {
+            break;
+        }
+        const char* eol = (const char*)memchr(start, '\n', end - start);
+        eol = eol == NULL ? end : eol + 1;
+        if(getNMEASentenceType(start, eol - start) == NMEASentenceRMC) {
+            uint64_t rmcKey = getNMEARMCTimeKey(start, eol - start);
+            if(rmcKey != NMEA_TIME_KEY_INVALID) {
+                if(rmcKey > toKey) {
+                    break;
+                }
+                key = rmcKey;
+            }
+        }
+        if(key != NMEA_TIME_KEY_INVALID && key >= fromKey) {
+            callback(start, eol - start, key);
+            count++;
+        }
+        pos = eol;
+    }
+    return count;
+}
+
+#endif //__NMEA_SEEK_INDEX_H
@@ -17,6 +17,11 @@ std::ostream& operator<<(std::ostream &os, NMEAPosition const &m);
 std::ostream& operator<<(std::ostream &os, RMCSentence const &m);
 std::ostream& operator<<(std::ostream &os, GSVSatInfo const &m);
 std::ostream& operator<<(std::ostream &os, GSVSentence const &m);
+std::ostream& operator<<(std::ostream &os, GGASentence const &m);
+std::ostream& operator<<(std::ostream &os, GSASentence const &m);
+std::ostream& operator<<(std::ostream &os, VTGSentence const &m);
+std::ostream& operator<<(std::ostream &os, ZDASentence const &m);
+std::ostream& operator<<(std::ostream &os, GSTSentence const &m);
 
 bool operator==(NMEAPosition const &a, NMEAPosition const &b);
 bool operator!=(NMEAPosition const &a, NMEAPosition const &b);
@@ -26,5 +31,15 @@ bool operator==(RMCSentence const &a, RMCSentence const &b);
 bool operator!=(RMCSentence const &a, RMCSentence const &b);
 bool operator==(GSVSentence const &a, GSVSentence const &b);
 bool operator!=(GSVSentence const &a, GSVSentence const &b);
+bool operator==(GGASentence const &a, GGASentence const &b);
+bool operator!=(GGASentence const &a, GGASentence const &b);
+bool operator==(GSASentence const &a, GSASentence const &b);
+bool operator!=(GSASentence const &a, GSASentence const &b);
+bool operator==(VTGSentence const &a, VTGSentence const &b);
+bool operator!=(VTGSentence const &a, VTGSentence const &b);
+bool operator==(ZDASentence const &a, ZDASentence const &b);
+bool operator!=(ZDASentence const &a, ZDASentence const &b);
+bool operator==(GSTSentence const &a, GSTSentence const &b);
+bool operator!=(GSTSentence const &a, GSTSentence const &b);
 
 #endif //__NMEA_SENTENCE_OPERATORS_H
\ No newline at end of file
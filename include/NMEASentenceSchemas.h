@@ -0,0 +1,113 @@
+/**
+ * Schemas of the sentences in NMEASentences.h, see NMEASchema.h.
+ * Error codes are assigned in field order, starting at -2 (-1 = missing field).
+ *
+ * Include this header to decode with a compile-time field mask, e.g.
+ *   NMEARMCSchema::decode<NMEA_RMC_POSITION>(view, &result)
+ * The parse*Sentence*() functions of NMEASentences.h do not need it.
+ */
+#ifndef __NMEA_SENTENCE_SCHEMAS_H
+#define __NMEA_SENTENCE_SCHEMAS_H
+
+#include "NMEASentences.h"
+#include "NMEASchema.h"
+
+typedef NMEASchema<
+    NMEACoordinateField<NMEA_MEMBER(NMEAPosition, latitude), -2>,
+    NMEADirectionField<NMEA_MEMBER(NMEAPosition, latitude), -3>,
+    NMEACoordinateField<NMEA_MEMBER(NMEAPosition, longitude), -4>,
+    NMEADirectionField<NMEA_MEMBER(NMEAPosition, longitude), -5>
+> NMEAGLLSchema;
+
+typedef NMEA_NESTED_MEMBER(RMCSentence, position, NMEAPosition, latitude) NMEARMCLatitude;
+typedef NMEA_NESTED_MEMBER(RMCSentence, position, NMEAPosition, longitude) NMEARMCLongitude;
+
+typedef NMEASchema<
+    NMEAUTCTimeField<NMEA_MEMBER(RMCSentence, utcTime), -2>,
+    NMEACharField<NMEA_MEMBER(RMCSentence, status), -3, 'A', 'V'>,
+    NMEACoordinateField<NMEARMCLatitude, -4>,
+    NMEADirectionField<NMEARMCLatitude, -5>,
+    NMEACoordinateField<NMEARMCLongitude, -6>,
+    NMEADirectionField<NMEARMCLongitude, -7>,
+    NMEAFixedPointField<NMEA_MEMBER(RMCSentence, speed), 3, -8>,
+    NMEAFixedPointField<NMEA_MEMBER(RMCSentence, course), 3, -9>,
+    NMEAIntegerField<NMEA_MEMBER(RMCSentence, date), -10>,
+    NMEASkipField, //Magnetic variation
+    NMEASkipField, //Magnetic variation direction
+    NMEACharField<NMEA_MEMBER(RMCSentence, posMode), -11, 'N', 'E', 'A', 'D'>
+> NMEARMCSchema;
+
+typedef NMEASchema<
+    NMEAIntegerField<NMEA_MEMBER(GSVSentence, numMsgs), -2>,
+    NMEAIntegerField<NMEA_MEMBER(GSVSentence, msgNum), -3>,
+    NMEAIntegerField<NMEA_MEMBER(GSVSentence, numSats), -4>,
+    NMEARepeatedGroupField<NMEA_MEMBER(GSVSentence, satellites), NMEA_MEMBER(GSVSentence, numSatInfos), 4,
+        NMEAIntegerField<NMEA_MEMBER(GSVSatInfo, id), -5>,
+        NMEAIntegerField<NMEA_MEMBER(GSVSatInfo, azimuth), -6>,
+        NMEAIntegerField<NMEA_MEMBER(GSVSatInfo, elevation), -7>,
+        NMEAIntegerField<NMEA_MEMBER(GSVSatInfo, signal), 0> //UINT8_MAX if not used in fix
+    >
+> NMEAGSVSchema;
+
+typedef NMEA_NESTED_MEMBER(GGASentence, position, NMEAPosition, latitude) NMEAGGALatitude;
+typedef NMEA_NESTED_MEMBER(GGASentence, position, NMEAPosition, longitude) NMEAGGALongitude;
+
+typedef NMEASchema<
+    NMEAUTCTimeField<NMEA_MEMBER(GGASentence, utcTime), -2>,
+    NMEACoordinateField<NMEAGGALatitude, -3>,
+    NMEADirectionField<NMEAGGALatitude, -4>,
+    NMEACoordinateField<NMEAGGALongitude, -5>,
+    NMEADirectionField<NMEAGGALongitude, -6>,
+    NMEAIntegerField<NMEA_MEMBER(GGASentence, quality), -7>,
+    NMEAIntegerField<NMEA_MEMBER(GGASentence, numSatellites), -8>,
+    NMEAFixedPointField<NMEA_MEMBER(GGASentence, hdop), 2, 0>,
+    NMEASignedFixedPointField<NMEA_MEMBER(GGASentence, altitude), 3, 0>,
+    NMEASkipField, //Altitude unit (M)
+    NMEASignedFixedPointField<NMEA_MEMBER(GGASentence, geoidSeparation), 3, 0>,
+    NMEASkipField //Geoid separation unit (M)
+    //Differential age and station ID are ignored
+> NMEAGGASchema;
+
+typedef NMEASchema<
+    NMEACharField<NMEA_MEMBER(GSASentence, opMode), -2, 'M', 'A'>,
+    NMEAIntegerField<NMEA_MEMBER(GSASentence, navMode), -3>,
+    NMEAIntegerArrayField<NMEA_MEMBER(GSASentence, satellites), 12>,
+    NMEAFixedPointField<NMEA_MEMBER(GSASentence, pdop), 2, 0>,
+    NMEAFixedPointField<NMEA_MEMBER(GSASentence, hdop), 2, 0>,
+    NMEAFixedPointField<NMEA_MEMBER(GSASentence, vdop), 2, 0>,
+    NMEATrailingField<NMEAIntegerField<NMEA_MEMBER(GSASentence, systemId), 0> >
+> NMEAGSASchema;
+
+typedef NMEASchema<
+    NMEAFixedPointField<NMEA_MEMBER(VTGSentence, courseTrue), 3, 0>,
+    NMEASkipField, //T
+    NMEAFixedPointField<NMEA_MEMBER(VTGSentence, courseMagnetic), 3, 0>,
+    NMEASkipField, //M
+    NMEAFixedPointField<NMEA_MEMBER(VTGSentence, speedKnots), 3, 0>,
+    NMEASkipField, //N
+    NMEAFixedPointField<NMEA_MEMBER(VTGSentence, speedKmh), 3, 0>,
+    NMEASkipField, //K
+    NMEACharField<NMEA_MEMBER(VTGSentence, posMode), -2, 'N', 'E', 'A', 'D'>
+> NMEAVTGSchema;
+
+typedef NMEASchema<
+    NMEAUTCTimeField<NMEA_MEMBER(ZDASentence, utcTime), -2>,
+    NMEAIntegerField<NMEA_MEMBER(ZDASentence, day), -3>,
+    NMEAIntegerField<NMEA_MEMBER(ZDASentence, month), -4>,
+    NMEAIntegerField<NMEA_MEMBER(ZDASentence, year), -5>,
+    NMEASignedIntegerField<NMEA_MEMBER(ZDASentence, localZoneHours), 0>,
+    NMEAIntegerField<NMEA_MEMBER(ZDASentence, localZoneMinutes), 0>
+> NMEAZDASchema;
+
+typedef NMEASchema<
+    NMEAUTCTimeField<NMEA_MEMBER(GSTSentence, utcTime), -2>,
+    NMEAFixedPointField<NMEA_MEMBER(GSTSentence, rangeRms), 3, 0>,
+    NMEAFixedPointField<NMEA_MEMBER(GSTSentence, stdMajor), 3, 0>,
+    NMEAFixedPointField<NMEA_MEMBER(GSTSentence, stdMinor), 3, 0>,
+    NMEAFixedPointField<NMEA_MEMBER(GSTSentence, orientation), 3, 0>,
+    NMEAFixedPointField<NMEA_MEMBER(GSTSentence, stdLatitude), 3, 0>,
+    NMEAFixedPointField<NMEA_MEMBER(GSTSentence, stdLongitude), 3, 0>,
+    NMEAFixedPointField<NMEA_MEMBER(GSTSentence, stdAltitude), 3, 0>
+> NMEAGSTSchema;
+
+#endif //__NMEA_SENTENCE_SCHEMAS_H
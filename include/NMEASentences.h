@@ -7,6 +7,8 @@
 
 #include <cstdint>
 
+#include "NMEA.h"
+
 /**
  * Represents the current WGS84 2D position to 1/100000 minute resolution
  */
@@ -72,8 +74,159 @@ struct GSVSentence {
     GSVSatInfo satellites[4];
 };
 
+struct GGASentence {
+    uint32_t utcTime; //hhmmss.ss
+    NMEAPosition position;
+    /**
+     * Fix quality: 0 = No fix, 1 = Autonomous GNSS fix, 2 = Differential fix,
+     *  4 = RTK fixed, 5 = RTK float, 6 = Dead reckoning
+     */
+    uint8_t quality;
+    uint8_t numSatellites; //Satellites used in fix
+    int32_t hdop; //1/100, INT32_MAX if invalid
+    int32_t altitude; //Altitude above mean sea level in mm, INT32_MAX if invalid
+    int32_t geoidSeparation; //Geoid separation in mm, INT32_MAX if invalid
+};
+
+struct GSASentence {
+    char opMode; //M = Manual, A = Automatic 2D/3D
+    uint8_t navMode; //1 = No fix, 2 = 2D fix, 3 = 3D fix
+    /**
+     * IDs of the satellites used in fix. INT32_MAX for unused entries.
+     */
+    int32_t satellites[12];
+    int32_t pdop, hdop, vdop; //1/100, INT32_MAX if invalid
+    /**
+     * GNSS system ID (NMEA 4.10+), INT32_MAX if not present
+     */
+    int32_t systemId;
+};
+
+struct VTGSentence {
+    int32_t courseTrue; //1/1000 degrees, INT32_MAX if invalid
+    int32_t courseMagnetic; //1/1000 degrees, INT32_MAX if invalid
+    int32_t speedKnots; //1/1000 knots, INT32_MAX if invalid
+    int32_t speedKmh; //1/1000 km/h, INT32_MAX if invalid
+    char posMode; //See RMCSentence::posMode
+};
+
+struct ZDASentence {
+    uint32_t utcTime; //hhmmss.ss
+    uint8_t day; //1-31
+    uint8_t month; //1-12
+    uint16_t year; //4 digits
+    int32_t localZoneHours; //-13..13, INT32_MAX if invalid
+    int32_t localZoneMinutes; //0-59, INT32_MAX if invalid
+};
+
+/**
+ * Pseudorange error statistics. All values INT32_MAX if invalid.
+ */
+struct GSTSentence {
+    uint32_t utcTime; //hhmmss.ss
+    int32_t rangeRms; //RMS of the pseudorange residuals in mm
+    int32_t stdMajor; //Standard deviation of the semi-major axis in mm
+    int32_t stdMinor; //Standard deviation of the semi-minor axis in mm
+    int32_t orientation; //Orientation of the semi-major axis in 1/1000 degrees
+    int32_t stdLatitude; //Standard deviation of latitude in mm
+    int32_t stdLongitude; //Standard deviation of longitude in mm
+    int32_t stdAltitude; //Standard deviation of altitude in mm
+};
+
 int parseGLLSentence(const char* buf, NMEAPosition* position);
 int parseRMCSentence(const char* buf, RMCSentence* result);
 int parseGSVSentence(const char* buf, GSVSentence* result);
+int parseGGASentence(const char* buf, GGASentence* result);
+int parseGSASentence(const char* buf, GSASentence* result);
+int parseVTGSentence(const char* buf, VTGSentence* result);
+int parseZDASentence(const char* buf, ZDASentence* result);
+int parseGSTSentence(const char* buf, GSTSentence* result);
+
+/**
+ * Parse sentences from an already indexed view.
+ * Use these if the view has been built anyway, e.g. to dispatch by sentence type.
+ */
+int parseGLLSentence(const NMEASentenceView& view, NMEAPosition* position);
+int parseRMCSentence(const NMEASentenceView& view, RMCSentence* result);
+int parseGSVSentence(const NMEASentenceView& view, GSVSentence* result);
+int parseGGASentence(const NMEASentenceView& view, GGASentence* result);
+int parseGSASentence(const NMEASentenceView& view, GSASentence* result);
+int parseVTGSentence(const NMEASentenceView& view, VTGSentence* result);
+int parseZDASentence(const NMEASentenceView& view, ZDASentence* result);
+int parseGSTSentence(const NMEASentenceView& view, GSTSentence* result);
+
+/**
+ * Field masks for parse*SentenceFields(). Bit n selects field n of the
+ * sentence (field 0 is the address field), e.g. NMEA_FIELD(7) is the RMC speed.
+ * Coordinates must be selected together with their direction field.
+ */
+#define NMEA_FIELD(n) (1u << (n))
+#define NMEA_ALL_FIELDS 0xfffffffeu
+
+#define NMEA_GLL_POSITION (NMEA_FIELD(1) | NMEA_FIELD(2) | NMEA_FIELD(3) | NMEA_FIELD(4))
+
+#define NMEA_RMC_TIME NMEA_FIELD(1)
+#define NMEA_RMC_STATUS NMEA_FIELD(2)
+#define NMEA_RMC_POSITION (NMEA_FIELD(3) | NMEA_FIELD(4) | NMEA_FIELD(5) | NMEA_FIELD(6))
+#define NMEA_RMC_SPEED NMEA_FIELD(7)
+#define NMEA_RMC_COURSE NMEA_FIELD(8)
+#define NMEA_RMC_DATE NMEA_FIELD(9)
+#define NMEA_RMC_POS_MODE NMEA_FIELD(12)
+
+#define NMEA_GSV_NUM_MSGS NMEA_FIELD(1)
+#define NMEA_GSV_MSG_NUM NMEA_FIELD(2)
+#define NMEA_GSV_NUM_SATS NMEA_FIELD(3)
+#define NMEA_GSV_SATELLITES 0x000ffff0u //Fields 4-19
+
+#define NMEA_GGA_TIME NMEA_FIELD(1)
+#define NMEA_GGA_POSITION (NMEA_FIELD(2) | NMEA_FIELD(3) | NMEA_FIELD(4) | NMEA_FIELD(5))
+#define NMEA_GGA_QUALITY NMEA_FIELD(6)
+#define NMEA_GGA_NUM_SATELLITES NMEA_FIELD(7)
+#define NMEA_GGA_HDOP NMEA_FIELD(8)
+#define NMEA_GGA_ALTITUDE NMEA_FIELD(9)
+#define NMEA_GGA_GEOID_SEPARATION NMEA_FIELD(11)
+
+#define NMEA_GSA_OP_MODE NMEA_FIELD(1)
+#define NMEA_GSA_NAV_MODE NMEA_FIELD(2)
+#define NMEA_GSA_SATELLITES 0x00007ff8u //Fields 3-14
+#define NMEA_GSA_PDOP NMEA_FIELD(15)
+#define NMEA_GSA_HDOP NMEA_FIELD(16)
+#define NMEA_GSA_VDOP NMEA_FIELD(17)
+#define NMEA_GSA_SYSTEM_ID NMEA_FIELD(18)
+
+#define NMEA_VTG_COURSE_TRUE NMEA_FIELD(1)
+#define NMEA_VTG_COURSE_MAGNETIC NMEA_FIELD(3)
+#define NMEA_VTG_SPEED_KNOTS NMEA_FIELD(5)
+#define NMEA_VTG_SPEED_KMH NMEA_FIELD(7)
+#define NMEA_VTG_POS_MODE NMEA_FIELD(9)
+
+#define NMEA_ZDA_TIME NMEA_FIELD(1)
+#define NMEA_ZDA_DAY NMEA_FIELD(2)
+#define NMEA_ZDA_MONTH NMEA_FIELD(3)
+#define NMEA_ZDA_YEAR NMEA_FIELD(4)
+#define NMEA_ZDA_LOCAL_ZONE (NMEA_FIELD(5) | NMEA_FIELD(6))
+
+#define NMEA_GST_TIME NMEA_FIELD(1)
+#define NMEA_GST_RANGE_RMS NMEA_FIELD(2)
+#define NMEA_GST_ERROR_ELLIPSE (NMEA_FIELD(3) | NMEA_FIELD(4) | NMEA_FIELD(5))
+#define NMEA_GST_POSITION_ERRORS (NMEA_FIELD(6) | NMEA_FIELD(7) | NMEA_FIELD(8))
+
+/**
+ * Lenient parsers that only decode the fields selected by fieldMask.
+ * Selecting a coordinate also selects its direction (N/S, E/W) field.
+ * Members of unselected fields are not modified, invalid fields are set
+ * to INT32_MAX ('\0' for characters) like optional fields of parse*Sentence().
+ * These never fail, e.g. an RMC sentence with an empty speed still yields
+ * its position.
+ * @return The mask of the selected fields that are present and valid
+ */
+uint32_t parseGLLSentenceFields(const NMEASentenceView& view, uint32_t fieldMask, NMEAPosition* position);
+uint32_t parseRMCSentenceFields(const NMEASentenceView& view, uint32_t fieldMask, RMCSentence* result);
+uint32_t parseGSVSentenceFields(const NMEASentenceView& view, uint32_t fieldMask, GSVSentence* result);
+uint32_t parseGGASentenceFields(const NMEASentenceView& view, uint32_t fieldMask, GGASentence* result);
+uint32_t parseGSASentenceFields(const NMEASentenceView& view, uint32_t fieldMask, GSASentence* result);
+uint32_t parseVTGSentenceFields(const NMEASentenceView& view, uint32_t fieldMask, VTGSentence* result);
+uint32_t parseZDASentenceFields(const NMEASentenceView& view, uint32_t fieldMask, ZDASentence* result);
+uint32_t parseGSTSentenceFields(const NMEASentenceView& view, uint32_t fieldMask, GSTSentence* result);
 
 #endif //__NMEA_SENTENCES_H
\ No newline at end of file
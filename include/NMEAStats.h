@@ -0,0 +1,181 @@
+/**
+ * Optional process-wide instrumentation of the framers and parsers.
+ *
+ * Disabled unless NMEA_ENABLE_STATS is defined. When disabled, the
+ * NMEA_STATS_* macros expand to nothing and getNMEAStats() returns zeros,
+ * so instrumented code has no overhead.
+ *
+ * Only the framers and dispatchNMEASentence() are instrumented. Sentences
+ * parsed by calling the parse*Sentence() functions directly are not counted,
+ * so that the parsers themselves stay free of instrumentation.
+ *
+ * Counters are relaxed atomics spread over NMEA_STATS_SHARDS cache-line
+ * sized shards. Every thread updates the shard it was assigned on first use,
+ * so threads rarely share a cache line. getNMEAStats() sums the shards and
+ * may be called from any thread at any time, without locks.
+ */
+#ifndef __NMEA_STATS_H
+#define __NMEA_STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * Number of sentence type slots, indexed by NMEASentenceType (see NMEADispatch.h)
+ */
+#define NMEA_STATS_NUM_TYPES 16
+/**
+ * Number of error code slots per type: errors[type][n] counts return code -n,
+ * the last slot also counts all codes below -(NMEA_STATS_NUM_ERRORS - 1)
+ */
+#define NMEA_STATS_NUM_ERRORS 16
+/**
+ * Latency bucket n counts durations in [2^(n-1), 2^n) ns, bucket 0 counts 0 ns.
+ * The last bucket also counts all longer durations.
+ */
+#define NMEA_STATS_NUM_LATENCY_BUCKETS 32
+
+#ifndef NMEA_STATS_SHARDS
+#define NMEA_STATS_SHARDS 8
+#endif
+
+enum NMEAStatsCounter {
+    /**
+     * Sentences with a wrong checksum (checkNMEAChecksum() returned -2)
+     */
+    NMEAStatsChecksumErrors = 0,
+    /**
+     * Incomplete sentences discarded because a new '$' was encountered
+     */
+    NMEAStatsResyncs,
+    /**
+     * Bytes discarded by the framers (garbage, overlong or truncated sentences)
+     */
+    NMEAStatsDroppedBytes,
+    /**
+     * Bytes lost because a buffer was full (NMEARing overruns)
+     */
+    NMEAStatsOverrunBytes,
+    /**
+     * Writes into a full NMEARing
+     */
+    NMEAStatsOverruns,
+    /**
+     * UBX frames with an invalid checksum
+     */
+    NMEAStatsUBXChecksumErrors,
+    /**
+     * Lines rejected by UBloxDriver::readLine()
+     */
+    NMEAStatsLineErrors,
+    NMEAStatsNumCounters
+};
+
+/**
+ * Sum of all shards at the time of getNMEAStats()
+ */
+struct NMEAStatsSnapshot {
+    /**
+     * Sentences passed to dispatchNMEASentence() by detected type,
+     * including types that are not enabled
+     */
+    uint64_t sentences[NMEA_STATS_NUM_TYPES];
+    /**
+     * Parser errors of dispatchNMEASentence() by sentence type and negated return code
+     */
+    uint64_t errors[NMEA_STATS_NUM_TYPES][NMEA_STATS_NUM_ERRORS];
+    uint64_t counters[NMEAStatsNumCounters];
+    /**
+     * Duration of the parser calls of dispatchNMEASentence() (log2 buckets)
+     */
+    uint64_t latency[NMEA_STATS_NUM_LATENCY_BUCKETS];
+
+    uint64_t totalSentences() const;
+    uint64_t totalErrors() const;
+    /**
+     * Errors with return code rc (< 0) over all sentence types
+     */
+    uint64_t totalErrors(int rc) const;
+    /**
+     * Upper bound of the latency bucket containing the given quantile (0..1)
+     * in ns, 0 if no latency has been recorded
+     */
+    uint64_t latencyQuantile(double quantile) const;
+};
+
+/**
+ * true if compiled with NMEA_ENABLE_STATS
+ */
+bool isNMEAStatsEnabled();
+
+/**
+ * Sum the counters of all threads. The counters are read individually,
+ * i.e. a snapshot taken during updates may be slightly inconsistent.
+ */
+void getNMEAStats(NMEAStatsSnapshot* snapshot);
+
+/**
+ * Reset all counters to zero. Updates of other threads while resetting
+ * may be lost or kept.
+ */
+void resetNMEAStats();
+
+/**
+ * Slot of return code rc in NMEAStatsSnapshot::errors
+ */
+inline unsigned getNMEAStatsErrorSlot(int rc) {
+    return rc < -(NMEA_STATS_NUM_ERRORS - 1) ? NMEA_STATS_NUM_ERRORS - 1 : (unsigned)-rc;
+}
+
+#ifdef NMEA_ENABLE_STATS
+
+struct alignas(64) NMEAStatsShard {
+    std::atomic<uint64_t> sentences[NMEA_STATS_NUM_TYPES];
+    std::atomic<uint64_t> errors[NMEA_STATS_NUM_TYPES][NMEA_STATS_NUM_ERRORS];
+    std::atomic<uint64_t> counters[NMEAStatsNumCounters];
+    std::atomic<uint64_t> latency[NMEA_STATS_NUM_LATENCY_BUCKETS];
+};
+
+extern NMEAStatsShard nmeaStatsShards[NMEA_STATS_SHARDS];
+
+/**
+ * Shard of the calling thread
+ */
+NMEAStatsShard& getNMEAStatsShard();
+
+/**
+ * Monotonic time in ns for latency measurements
+ */
+uint64_t getNMEAStatsTime();
+
+inline void addNMEAStatsLatency(uint64_t ns) {
+    unsigned bucket = ns == 0 ? 0 : 64 - __builtin_clzll(ns);
+    bucket = bucket < NMEA_STATS_NUM_LATENCY_BUCKETS ? bucket : NMEA_STATS_NUM_LATENCY_BUCKETS - 1;
+    getNMEAStatsShard().latency[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void addNMEAStatsError(unsigned type, int rc) {
+    getNMEAStatsShard().errors[type % NMEA_STATS_NUM_TYPES][getNMEAStatsErrorSlot(rc)]
+        .fetch_add(1, std::memory_order_relaxed);
+}
+
+#define NMEA_STATS_ADD(counter, n) \
+    getNMEAStatsShard().counters[counter].fetch_add((n), std::memory_order_relaxed)
+#define NMEA_STATS_SENTENCE(type) \
+    getNMEAStatsShard().sentences[(type) % NMEA_STATS_NUM_TYPES].fetch_add(1, std::memory_order_relaxed)
+#define NMEA_STATS_ERROR(type, rc) addNMEAStatsError((type), (rc))
+#define NMEA_STATS_TIMER_START(name) uint64_t name = getNMEAStatsTime()
+#define NMEA_STATS_TIMER_STOP(name) addNMEAStatsLatency(getNMEAStatsTime() - (name))
+
+#else
+
+#define NMEA_STATS_ADD(counter, n) ((void)0)
+#define NMEA_STATS_SENTENCE(type) ((void)0)
+#define NMEA_STATS_ERROR(type, rc) ((void)0)
+#define NMEA_STATS_TIMER_START(name) ((void)0)
+#define NMEA_STATS_TIMER_STOP(name) ((void)0)
+
+#endif //NMEA_ENABLE_STATS
+
+#endif //__NMEA_STATS_H
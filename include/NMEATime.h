@@ -0,0 +1,98 @@
+/**
+ * Conversion of NMEA UTC times (hhmmss.ss) and RMC dates (ddmmyy)
+ * to nanoseconds since the Unix epoch.
+ */
+#ifndef __NMEA_TIME_H
+#define __NMEA_TIME_H
+
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * Result of invalid or unconvertible times
+ */
+#define NMEA_EPOCH_INVALID INT64_MIN
+
+#define NMEA_NS_PER_SECOND 1000000000ll
+#define NMEA_NS_PER_DAY (86400 * NMEA_NS_PER_SECOND)
+/**
+ * The GPS week number wraps every 1024 weeks
+ */
+#define NMEA_GPS_ROLLOVER_DAYS (1024 * 7)
+
+/**
+ * Days since 1970-01-01 of a date in the proleptic Gregorian calendar
+ */
+int64_t getNMEACivilDays(int year, int month, int day);
+
+/**
+ * Converts the time stamps of a single receiver.
+ *
+ * The start of the day of the last date is cached (and so is the start of
+ * the last minute), so a conversion is usually a few multiplications.
+ *
+ * Sentences without a date (GGA, GLL, GST) use the day of the last date.
+ * Once the time jumps back by more than 12 hours, midnight has passed
+ * and the next day is used (and vice versa, for late sentences from before
+ * midnight after the date has already changed).
+ *
+ * Receivers with an outdated firmware report dates 1024 weeks in the
+ * past after a GPS week number rollover. If minDate is given, dates
+ * before it are moved forward by multiples of 1024 weeks.
+ */
+class NMEAEpochConverter {
+public:
+    /**
+     * @param minDate Earliest plausible date (ddmmyy, years 2000-2099),
+     *  e.g. the release date of the application. INT32_MAX = no correction.
+     */
+    explicit NMEAEpochConverter(int32_t minDate = INT32_MAX);
+
+    /**
+     * Convert a date and time, e.g. of a RMC sentence.
+     * If date is INT32_MAX, the time is converted like toEpochNs(utcTime).
+     * @return Nanoseconds since 1970-01-01, NMEA_EPOCH_INVALID if the date or time is invalid
+     */
+    int64_t toEpochNs(int32_t date, uint32_t utcTime);
+
+    /**
+     * Convert a time of a sentence without a date.
+     * @return NMEA_EPOCH_INVALID if the time is invalid or no date has been converted yet
+     */
+    int64_t toEpochNs(uint32_t utcTime);
+
+    /**
+     * Convert columns of dates and times in order, e.g. the utcTime and
+     * date columns of NMEAFixColumns (see NMEABatch.h).
+     * @param dates May be NULL if the rows have no dates
+     * @return The number of valid results
+     */
+    size_t toEpochNs(const int32_t* dates, const uint32_t* utcTimes, size_t count, int64_t* out);
+
+    /**
+     * Forget the last date, e.g. after a receiver restart
+     */
+    void reset();
+private:
+    /**
+     * Nanoseconds since midnight, -1 if utcTime is invalid
+     */
+    int64_t timeOfDayNs(uint32_t utcTime);
+    /**
+     * Start of the day of a ddmmyy date in ns, NMEA_EPOCH_INVALID if the date is invalid
+     */
+    int64_t dayStartNs(int32_t date) const;
+
+    int64_t minDays;
+    //Cache of the last date
+    int32_t cachedDate;
+    int64_t cachedDayStart;
+    //Cache of the last hhmm
+    uint32_t cachedMinute;
+    int64_t cachedMinuteNs;
+    //Day of the sentences without date
+    int64_t dayStart; //NMEA_EPOCH_INVALID if no date has been seen
+    int64_t lastTimeOfDay;
+};
+
+#endif //__NMEA_TIME_H
@@ -0,0 +1,207 @@
+/**
+ * Compact block-based binary storage for parsed fixes.
+ * Requires a POSIX system (file descriptors, mmap).
+ *
+ * File layout (all integers little endian):
+ *  - "NMEATRK1"
+ *  - Blocks: uint32 numFixes, uint32 payload size, payload.
+ *    The payload stores the RMCSentence fields column by column as zigzag varint
+ *    deltas to the previous fix of the same block, so every block can be
+ *    decoded on its own.
+ *  - Index: One NMEATrackBlockInfo per block
+ *  - Trailer: uint64 index offset, uint32 number of blocks, uint32 reserved, "NMEAIDX1"
+ */
+#ifndef __NMEA_TRACK_H
+#define __NMEA_TRACK_H
+
+#include <cstdint>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "NMEASentences.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "The track index is stored in host byte order and requires a little endian host"
+#endif
+
+#define NMEA_TRACK_DEFAULT_BLOCK_SIZE 1024
+/**
+ * utcTime, date, latitude, longitude, speed, course, status, posMode
+ */
+#define NMEA_TRACK_NUM_COLUMNS 8
+/**
+ * Time key of fixes without a valid date or time
+ */
+#define NMEA_TIME_KEY_INVALID UINT64_MAX
+
+/**
+ * Build a time key that sorts chronologically (for years 2000-2099)
+ * from an RMC date (ddmmyy) and UTC time (hhmmss.ss).
+ * The key is yymmddhhmmssss as a decimal number.
+ * @return NMEA_TIME_KEY_INVALID if date or time is INT32_MAX
+ */
+inline uint64_t makeNMEATimeKey(int32_t date, uint32_t utcTime) {
+    if(date == INT32_MAX || utcTime == INT32_MAX) {
+        return NMEA_TIME_KEY_INVALID;
+    }
+    uint32_t yymmdd = (date % 100) * 10000 + (date / 100 % 100) * 100 + date / 10000;
+    return (uint64_t)yymmdd * 100000000 + utcTime;
+}
+
+/**
+ * Index entry of a block
+ */
+struct NMEATrackBlockInfo {
+    uint64_t offset; //File offset of the block header
+    /**
+     * Range of the valid time keys in the block.
+     * NMEA_TIME_KEY_INVALID/0 if no fix of the block has a valid key.
+     */
+    uint64_t minKey, maxKey;
+    uint32_t numFixes;
+    uint32_t size; //Payload size
+};
+
+static_assert(sizeof(NMEATrackBlockInfo) == 32, "Track index entry size");
+
+/**
+ * Streaming writer. Only the current block and the index
+ * (32 bytes per block) are kept in memory.
+ * The file is only readable after close() has written the index.
+ */
+class NMEATrackWriter {
+public:
+    explicit NMEATrackWriter(uint32_t fixesPerBlock = NMEA_TRACK_DEFAULT_BLOCK_SIZE);
+    ~NMEATrackWriter();
+
+    /**
+     * Create or truncate a track file
+     * @return 0 on success, -1 if the file could not be opened, -2 on write errors
+     */
+    int open(const char* filename);
+
+    /**
+     * Append a fix. Fixes should be added in chronological order
+     * so that blocks cover disjoint time ranges.
+     * @return 0 on success, -2 on write errors
+     */
+    int add(const RMCSentence& fix);
+
+    /**
+     * Write the last block and the index, then close the file.
+     * @return 0 on success, -2 on write errors
+     */
+    int close();
+
+    uint64_t getNumFixes() const {
+        return numFixes;
+    }
+private:
+    int flushBlock();
+    int writeAll(const void* data, size_t size);
+
+    int fd;
+    uint32_t fixesPerBlock;
+    uint64_t offset; //Current file offset
+    uint64_t numFixes;
+    NMEATrackBlockInfo block; //Info of the current block
+    int32_t previous[NMEA_TRACK_NUM_COLUMNS];
+    std::vector<uint8_t> columns[NMEA_TRACK_NUM_COLUMNS];
+    std::vector<NMEATrackBlockInfo> index;
+};
+
+/**
+ * Reads a memory-mapped track file. Only the blocks overlapping
+ * a queried time range are decoded.
+ */
+class NMEATrackReader {
+public:
+    NMEATrackReader();
+    ~NMEATrackReader();
+
+    /**
+     * Map a track file
+     * @return 0 on success, -1 if the file could not be opened, -2 if it could not be mapped,
+     *  -3 if it is not a valid track file
+     */
+    int open(const char* filename);
+
+    /**
+     * Read a track that is already in memory. data must stay valid until close().
+     * @return 0 on success, -3 if it is not a valid track
+     */
+    int openBuffer(const uint8_t* data, size_t size);
+
+    void close();
+
+    size_t getNumBlocks() const {
+        return numBlocks;
+    }
+
+    const NMEATrackBlockInfo& getBlockInfo(size_t idx) const {
+        return index[idx];
+    }
+
+    uint64_t getNumFixes() const;
+
+    /**
+     * Decode a single block.
+     * @param out Must have space for getBlockInfo(idx).numFixes fixes
+     * @return The number of fixes or -1 if the block is corrupt
+     */
+    int decodeBlock(size_t idx, RMCSentence* out) const;
+
+    /**
+     * Call callback(const RMCSentence&) for every fix with a time key
+     * (see makeNMEATimeKey()) in [fromKey, toKey], in file order.
+     * The first block is found by binary search and the scan stops after the
+     * last block that can contain the range, so for chronological tracks
+     * only the blocks overlapping the range are visited.
+     * @return The number of fixes passed to the callback or -1 if a block is corrupt
+     */
+    template<typename Callback>
+    int64_t query(uint64_t fromKey, uint64_t toKey, Callback callback);
+private:
+    const uint8_t* data;
+    size_t size;
+    bool mapped;
+    const NMEATrackBlockInfo* index;
+    size_t numBlocks;
+    std::vector<RMCSentence> decoded; //Decode buffer of query()
+    /**
+     * Running maximum of the block maxKeys from the start and running minimum of
+     * the block minKeys from the end. Both are sorted even if blocks
+     * have no valid key or the track is not chronological.
+     */
+    std::vector<uint64_t> maxKeyUpTo;
+    std::vector<uint64_t> minKeyFrom;
+};
+
+template<typename Callback>
+int64_t NMEATrackReader::query(uint64_t fromKey, uint64_t toKey, Callback callback) {
+    int64_t count = 0;
+    //All blocks before first end before fromKey
+    size_t first = std::lower_bound(maxKeyUpTo.begin(), maxKeyUpTo.end(), fromKey) - maxKeyUpTo.begin();
+    for (size_t i = first; i < numBlocks && minKeyFrom[i] <= toKey; ++i) {
+        const NMEATrackBlockInfo& info = index[i];
+        if(info.numFixes == 0 || info.maxKey < fromKey || info.minKey > toKey) {
+            continue;
+        }
+        decoded.resize(info.numFixes);
+        int n = decodeBlock(i, decoded.data());
+        if(n < 0) {
+            return -1;
+        }
+        for (int j = 0; j < n; ++j) {
+            uint64_t key = makeNMEATimeKey(decoded[j].date, decoded[j].utcTime);
+            if(key >= fromKey && key <= toKey) {
+                callback(decoded[j]);
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+#endif //__NMEA_TRACK_H
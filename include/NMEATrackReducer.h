@@ -0,0 +1,119 @@
+/**
+ * Streaming reduction of the fixes of a single receiver before storage or upload:
+ * duplicate removal, rate limiting and online line simplification.
+ */
+#ifndef __NMEA_TRACK_REDUCER_H
+#define __NMEA_TRACK_REDUCER_H
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "NMEASentences.h"
+#include "NMEATime.h"
+
+/**
+ * Maximum number of fixes held back by the line simplification.
+ * Bounds the memory, the output delay and the work per fix.
+ */
+#ifndef NMEA_REDUCER_WINDOW
+#define NMEA_REDUCER_WINDOW 64
+#endif
+
+struct NMEAReducerStats {
+    uint64_t input; //Fixes passed to add()
+    uint64_t invalid; //Without a valid position
+    uint64_t duplicates; //Within the duplicate distance of the previous fix
+    uint64_t rateLimited; //Less than the minimum interval after the previous fix
+    uint64_t simplified; //Removed by the line simplification
+    uint64_t output; //Emitted fixes
+
+    /**
+     * Input fixes per output fix, 0 if nothing has been emitted
+     */
+    double reductionRatio() const {
+        return output == 0 ? 0.0 : (double)input / output;
+    }
+};
+
+/**
+ * Reduces a fix stream in three steps:
+ *  1. Fixes closer than dedupMeters to the previously accepted fix are dropped,
+ *     with dedupMeters = 0 only exact duplicates.
+ *  2. Fixes less than minIntervalMs after the previously accepted fix are dropped.
+ *     Fixes without a valid date and time are not rate limited.
+ *  3. Opening window line simplification (an online variant of Douglas-Peucker):
+ *     Fixes are held back as long as all of them are within toleranceMeters of the
+ *     line from the last emitted fix to the newest one. Otherwise, the fix before
+ *     the newest one is emitted and starts the next line.
+ *     The first fix is emitted immediately.
+ *
+ * Distances are computed on a local plane around the last emitted fix,
+ * which is accurate for the short segments of a track.
+ * Uses no dynamic memory. Use one instance per receiver.
+ */
+class NMEATrackReducer {
+public:
+    explicit NMEATrackReducer(double toleranceMeters, double dedupMeters = 0, uint32_t minIntervalMs = 0);
+
+    /**
+     * Add the next fix of the stream
+     * @param out Set to the emitted fix, if any
+     * @return 1 if a fix has been emitted, 0 if not,
+     *  -1 if the fix has been ignored because its position is invalid
+     */
+    int add(const RMCSentence& fix, RMCSentence* out);
+
+    /**
+     * Emit the last fix held back by the line simplification,
+     * e.g. at the end of the stream or before a longer pause.
+     * @return 1 if a fix has been emitted, 0 if no fix is held back
+     */
+    int flush(RMCSentence* out);
+
+    /**
+     * Start a new track. The statistics are kept.
+     */
+    void reset();
+
+    const NMEAReducerStats& getStats() const {
+        return stats;
+    }
+private:
+    struct Point {
+        RMCSentence fix;
+        double x, y; //Meters east/north of the anchor
+    };
+
+    /**
+     * Project a fix onto the plane around the anchor
+     */
+    void project(const RMCSentence& fix, double* x, double* y) const;
+    /**
+     * true if all held back fixes are within the tolerance of the line to (x, y)
+     */
+    bool fitsLine(double x, double y) const;
+    /**
+     * Emit the newest held back fix and make it the anchor
+     */
+    void emitLast(RMCSentence* out);
+    void setAnchor(const RMCSentence& fix);
+
+    double tolerance;
+    double dedupDistance;
+    int64_t minInterval; //ns
+    NMEAEpochConverter epoch;
+    NMEAReducerStats stats;
+    //Last accepted fix
+    bool hasLast;
+    RMCSentence last;
+    int64_t lastTime;
+    //Start of the current line
+    bool hasAnchor;
+    int32_t anchorLatitude, anchorLongitude; //1e-7 degrees
+    double metersPerDegreeLongitude; //Per 1e-7 degrees
+    //Fixes held back, relative to the anchor
+    Point window[NMEA_REDUCER_WINDOW];
+    size_t windowSize;
+};
+
+#endif //__NMEA_TRACK_REDUCER_H
@@ -0,0 +1,236 @@
+/**
+ * Resumable framer for streams that mix NMEA sentences
+ * and binary UBX messages on the same port.
+ */
+#ifndef __NMEA_UBX_FRAMER_H
+#define __NMEA_UBX_FRAMER_H
+
+#include <cstdint>
+#include <cstring>
+
+#include "NMEAFramer.h"
+#include "UBX.h"
+
+/**
+ * Maximum size of a UBX frame (including header and checksum).
+ * Longer frames are dropped. The default fits UBX-NAV-SAT
+ * with 84 satellites.
+ */
+#ifndef UBX_FRAMER_BUFSIZE
+#define UBX_FRAMER_BUFSIZE 1024
+#endif
+
+/**
+ * Demultiplexes UBX frames (0xB5 0x62 ...) from NMEA text lines.
+ * Text between UBX frames is passed through an NMEAFramer.
+ * UBX_SYNC_CHAR_1 can not occur in NMEA text, so it interrupts any partial sentence.
+ *
+ * Like NMEAFramer, UBX frames fully contained in a chunk are passed
+ * to the callback in place. Only frames spanning chunks are copied.
+ * Frames with an invalid checksum or length are dropped and the stream is
+ * rescanned from the byte after the sync char. This also applies to frames
+ * spanning chunks, so the output does not depend on the chunk boundaries.
+ */
+class NMEAUBXFramer {
+public:
+    NMEAUBXFramer() : ubxSize(0), droppedBytes(0), checksumErrors(0) {}
+
+    /**
+     * Process a chunk of the stream.
+     * @param onSentence Callable as onSentence(const char* sentence, size_t size)
+     * @param onMessage Callable as onMessage(const UBXMessage& message)
+     * @return The number of complete sentences and messages emitted from this chunk
+     */
+    template<typename NMEACallback, typename UBXCallback>
+    size_t feed(const char* data, size_t size, NMEACallback onSentence, UBXCallback onMessage);
+
+    /**
+     * Discard any partially received sentence or message.
+     */
+    void reset() {
+        nmea.reset();
+        ubxSize = 0;
+    }
+
+    /**
+     * Number of bytes that were not part of a valid sentence or message
+     */
+    uint32_t getDroppedBytes() const {
+        return droppedBytes + nmea.getDroppedBytes();
+    }
+
+    /**
+     * Number of UBX frames dropped because of an invalid checksum
+     */
+    uint32_t getChecksumErrors() const {
+        return checksumErrors;
+    }
+
+    const NMEAFramer& getNMEAFramer() const {
+        return nmea;
+    }
+private:
+    /**
+     * Verify the checksum of a complete frame and emit it.
+     */
+    template<typename UBXCallback>
+    bool emit(const uint8_t* frame, size_t size, UBXCallback& onMessage) {
+        uint16_t checksum = computeUBXChecksum(frame + 2, size - 4);
+        if(frame[size - 2] != (uint8_t)checksum || frame[size - 1] != (uint8_t)(checksum >> 8)) {
+            checksumErrors++;
+            NMEA_STATS_ADD(NMEAStatsUBXChecksumErrors, 1);
+            return false;
+        }
+        UBXMessage msg = {frame[2], frame[3], (uint16_t)(size - UBX_FRAME_OVERHEAD), frame + UBX_HEADER_SIZE};
+        onMessage(msg);
+        return true;
+    }
+
+    /**
+     * Handle a frame starting with UBX_SYNC_CHAR_1 at sync.
+     * @return The position to continue scanning at
+     */
+    template<typename UBXCallback>
+    const char* startFrame(const char* sync, const char* end, UBXCallback& onMessage, size_t* emitted);
+
+    /**
+     * Continue a frame from a previous chunk. If the frame is invalid,
+     * the buffered bytes after its sync char are rescanned.
+     * @return The position to continue scanning at. If ubxSize is not 0
+     *  afterwards, a new frame has been started and must be continued.
+     */
+    template<typename NMEACallback, typename UBXCallback>
+    const char* continueFrame(const char* pos, const char* end,
+        NMEACallback& onSentence, UBXCallback& onMessage, size_t* emitted);
+
+    /**
+     * Split text and UBX frames, starting outside of a frame
+     * @return The number of sentences and messages emitted
+     */
+    template<typename NMEACallback, typename UBXCallback>
+    size_t scan(const char* pos, const char* end, NMEACallback& onSentence, UBXCallback& onMessage);
+
+    /**
+     * Drop the sync char of the buffered invalid frame and rescan the remaining buffered bytes
+     */
+    template<typename NMEACallback, typename UBXCallback>
+    void rescanFrame(NMEACallback& onSentence, UBXCallback& onMessage, size_t* emitted) {
+        size_t size = ubxSize;
+        countDropped(1);
+        ubxSize = 0;
+        //A partial frame at the end is moved to the start of ubx by startFrame()
+        *emitted += scan((const char*)ubx + 1, (const char*)ubx + size, onSentence, onMessage);
+    }
+
+    void countDropped(size_t size) {
+        droppedBytes += size;
+        NMEA_STATS_ADD(NMEAStatsDroppedBytes, size);
+    }
+
+    NMEAFramer nmea;
+    uint8_t ubx[UBX_FRAMER_BUFSIZE];
+    /**
+     * Number of bytes of a partial frame in the ubx buffer, 0 if none
+     */
+    size_t ubxSize;
+    uint32_t droppedBytes;
+    uint32_t checksumErrors;
+};
+
+template<typename UBXCallback>
+const char* NMEAUBXFramer::startFrame(const char* sync, const char* end, UBXCallback& onMessage, size_t* emitted) {
+    const uint8_t* frame = (const uint8_t*)sync;
+    size_t available = end - sync;
+    if(available >= 2 && frame[1] != UBX_SYNC_CHAR_2) {
+        countDropped(1);
+        return sync + 1;
+    }
+    if(available >= UBX_HEADER_SIZE) {
+        size_t frameSize = (frame[4] | (frame[5] << 8)) + UBX_FRAME_OVERHEAD;
+        if(frameSize > UBX_FRAMER_BUFSIZE) {
+            countDropped(1);
+            return sync + 1;
+        }
+        if(available >= frameSize) { //Complete frame in this chunk
+            if(emit(frame, frameSize, onMessage)) {
+                (*emitted)++;
+                return sync + frameSize;
+            }
+            countDropped(1);
+            return sync + 1;
+        }
+    }
+    //Frame continues in the next chunk. When rescanning, frame is inside ubx.
+    memmove(ubx, frame, available);
+    ubxSize = available;
+    return end;
+}
+
+template<typename NMEACallback, typename UBXCallback>
+const char* NMEAUBXFramer::continueFrame(const char* pos, const char* end,
+    NMEACallback& onSentence, UBXCallback& onMessage, size_t* emitted) {
+    //Complete the header
+    while(ubxSize < UBX_HEADER_SIZE && pos < end) {
+        ubx[ubxSize++] = (uint8_t)*pos++;
+        if(ubxSize == 2 && ubx[1] != UBX_SYNC_CHAR_2) {
+            //Rescan the second byte
+            countDropped(1);
+            ubxSize = 0;
+            return pos - 1;
+        }
+    }
+    if(ubxSize < UBX_HEADER_SIZE) {
+        return end;
+    }
+    size_t frameSize = (ubx[4] | (ubx[5] << 8)) + UBX_FRAME_OVERHEAD;
+    if(frameSize > UBX_FRAMER_BUFSIZE) {
+        rescanFrame(onSentence, onMessage, emitted);
+        return pos;
+    }
+    size_t n = frameSize - ubxSize;
+    if(n > (size_t)(end - pos)) {
+        n = end - pos;
+    }
+    memcpy(ubx + ubxSize, pos, n);
+    ubxSize += n;
+    pos += n;
+    if(ubxSize == frameSize) {
+        if(emit(ubx, frameSize, onMessage)) {
+            (*emitted)++;
+            ubxSize = 0;
+        } else {
+            rescanFrame(onSentence, onMessage, emitted);
+        }
+    }
+    return pos;
+}
+
+template<typename NMEACallback, typename UBXCallback>
+size_t NMEAUBXFramer::feed(const char* data, size_t size, NMEACallback onSentence, UBXCallback onMessage) {
+    const char* pos = data;
+    const char* end = data + size;
+    size_t emitted = 0;
+    //Rescanning an invalid frame may start another one
+    while(ubxSize != 0 && pos < end) {
+        pos = continueFrame(pos, end, onSentence, onMessage, &emitted);
+    }
+    return emitted + scan(pos, end, onSentence, onMessage);
+}
+
+template<typename NMEACallback, typename UBXCallback>
+size_t NMEAUBXFramer::scan(const char* pos, const char* end, NMEACallback& onSentence, UBXCallback& onMessage) {
+    size_t emitted = 0;
+    while(pos < end) {
+        const char* sync = (const char*)memchr(pos, UBX_SYNC_CHAR_1, end - pos);
+        const char* textEnd = sync == NULL ? end : sync;
+        emitted += nmea.feed(pos, textEnd - pos, onSentence);
+        if(sync == NULL) {
+            break;
+        }
+        nmea.abortSentence();
+        pos = startFrame(sync, end, onMessage, &emitted);
+    }
+    return emitted;
+}
+
+#endif //__NMEA_UBX_FRAMER_H
@@ -0,0 +1,127 @@
+/**
+ * Integer-only text output primitives shared by the
+ * sentence encoders and the formatters.
+ */
+#ifndef __NMEA_WRITER_H
+#define __NMEA_WRITER_H
+
+#include <cstdint>
+#include <cstdlib>
+
+static const char nmeaDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const char nmeaHexDigits[] = "0123456789ABCDEF";
+
+static const uint32_t nmeaPowersOf10[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+static inline int countNMEADigits(uint32_t value) {
+    int digits = 1;
+    while(digits < 10 && value >= nmeaPowersOf10[digits]) {
+        digits++;
+    }
+    return digits;
+}
+
+/**
+ * Writes text into a buffer and computes the NMEA checksum on the fly.
+ * The caller is responsible for the buffer being large enough.
+ */
+struct NMEAWriter {
+    char* pos;
+    uint8_t checksum;
+
+    inline void put(char c) {
+        *pos++ = c;
+        checksum ^= (uint8_t)c;
+    }
+
+    /**
+     * Write a NUL-terminated string (without the NUL)
+     */
+    inline void putString(const char* str) {
+        while(*str != '\0') {
+            put(*str++);
+        }
+    }
+
+    /**
+     * Write exactly width digits (with leading zeros), two at a time
+     */
+    inline void putDigits(uint32_t value, int width) {
+        char* end = pos + width;
+        char* p = end;
+        while(width >= 2) {
+            const char* pair = nmeaDigitPairs + 2 * (value % 100);
+            value /= 100;
+            *--p = pair[1];
+            *--p = pair[0];
+            checksum ^= pair[0] ^ pair[1];
+            width -= 2;
+        }
+        if(width != 0) {
+            char c = (char)('0' + value % 10);
+            *--p = c;
+            checksum ^= c;
+        }
+        pos = end;
+    }
+
+    /**
+     * Write at least minWidth digits
+     */
+    inline void putUnsigned(uint32_t value, int minWidth = 1) {
+        int digits = countNMEADigits(value);
+        putDigits(value, digits > minWidth ? digits : minWidth);
+    }
+
+    inline void putSigned(int32_t value) {
+        uint32_t magnitude = (uint32_t)value;
+        if(value < 0) {
+            put('-');
+            magnitude = 0u - magnitude;
+        }
+        putUnsigned(magnitude);
+    }
+
+    /**
+     * Write a fixed point decimal with the given number of decimals.
+     * Nothing is written for INT32_MAX.
+     */
+    template<int Decimals>
+    inline void putFixedPoint(int32_t value, int minIntegerDigits = 1) {
+        if(value == INT32_MAX) {
+            return;
+        }
+        uint32_t magnitude = (uint32_t)value;
+        if(value < 0) {
+            put('-');
+            magnitude = 0u - magnitude;
+        }
+        putUnsigned(magnitude / nmeaPowersOf10[Decimals], minIntegerDigits);
+        put('.');
+        putDigits(magnitude % nmeaPowersOf10[Decimals], Decimals);
+    }
+
+    /**
+     * Write a character unless it is '\0'
+     */
+    inline void putChar(char c) {
+        if(c != '\0') {
+            put(c);
+        }
+    }
+};
+
+#endif //__NMEA_WRITER_H
@@ -0,0 +1,89 @@
+/**
+ * Single-writer / multi-reader sequence lock
+ */
+#ifndef __SEQLOCK_H
+#define __SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Publishes values of a trivially copyable type T from a single writer
+ * to any number of readers. The writer never blocks, and readers never
+ * block the writer; a reader retries if the value was modified while
+ * it was being copied, so it never sees a half-updated value.
+ *
+ * The value is stored as relaxed atomic words, so concurrent
+ * reads and writes are not data races.
+ */
+template<typename T>
+class SeqLock {
+public:
+    SeqLock() : sequence(0) {
+        for (size_t i = 0; i < NumWords; ++i) {
+            words[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Publish a new value. Must only be called from a single thread.
+     */
+    void store(const T& value) {
+        uint64_t buf[NumWords] = {};
+        memcpy(buf, &value, sizeof(T));
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        //Odd sequence: Write in progress
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < NumWords; ++i) {
+            words[i].store(buf[i], std::memory_order_relaxed);
+        }
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * Try to read the value once.
+     * @return false if a write was in progress. out is undefined in that case.
+     */
+    bool tryLoad(T* out) const {
+        uint32_t before = sequence.load(std::memory_order_acquire);
+        if(before & 1) {
+            return false;
+        }
+        uint64_t buf[NumWords];
+        for (size_t i = 0; i < NumWords; ++i) {
+            buf[i] = words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(sequence.load(std::memory_order_relaxed) != before) {
+            return false;
+        }
+        memcpy(out, buf, sizeof(T));
+        return true;
+    }
+
+    /**
+     * Read a consistent value, retrying while the writer is active.
+     */
+    T load() const {
+        T value;
+        while(!tryLoad(&value)) {
+        }
+        return value;
+    }
+
+    /**
+     * Number of values stored so far. Readers can use this to detect new values.
+     */
+    uint32_t getVersion() const {
+        return sequence.load(std::memory_order_acquire) / 2;
+    }
+private:
+    static const size_t NumWords = (sizeof(T) + 7) / 8;
+
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint64_t> words[NumWords];
+};
+
+#endif //__SEQLOCK_H
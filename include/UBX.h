@@ -0,0 +1,200 @@
+/**
+ * UBX binary protocol: Frame format, message structures and
+ * configuration message builders.
+ * Reference: u-blox 8 / M8 Receiver Description incl. Protocol Specification,
+ *  section 32 "UBX Protocol"
+ */
+#ifndef __UBX_H
+#define __UBX_H
+
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "UBX messages are decoded in place and require a little endian host"
+#endif
+
+#define UBX_SYNC_CHAR_1 0xB5
+#define UBX_SYNC_CHAR_2 0x62
+/**
+ * Sync chars, class, ID and 2 length bytes
+ */
+#define UBX_HEADER_SIZE 6
+/**
+ * Header plus 2 checksum bytes
+ */
+#define UBX_FRAME_OVERHEAD 8
+
+#define UBX_CLASS_NAV 0x01
+#define UBX_CLASS_ACK 0x05
+#define UBX_CLASS_CFG 0x06
+
+#define UBX_ID_NAV_PVT 0x07
+#define UBX_ID_NAV_TIMEUTC 0x21
+#define UBX_ID_NAV_SAT 0x35
+#define UBX_ID_CFG_PRT 0x00
+#define UBX_ID_CFG_MSG 0x01
+#define UBX_ID_CFG_RATE 0x08
+
+/**
+ * Protocol masks for UBX-CFG-PRT
+ */
+#define UBX_PROTO_UBX 0x01
+#define UBX_PROTO_NMEA 0x02
+
+/**
+ * A complete, checksum-verified UBX message.
+ * payload points into the frame passed to the framer callback
+ * and is only valid during the callback.
+ */
+struct UBXMessage {
+    uint8_t msgClass;
+    uint8_t msgId;
+    uint16_t size; //Payload size
+    const uint8_t* payload;
+};
+
+/**
+ * UBX-NAV-PVT: Navigation position velocity time solution
+ */
+struct __attribute__((packed)) UBXNavPVT {
+    static const uint8_t msgClass = UBX_CLASS_NAV;
+    static const uint8_t msgId = UBX_ID_NAV_PVT;
+
+    uint32_t iTOW; //GPS time of week in ms
+    uint16_t year; //UTC
+    uint8_t month, day, hour, min, sec;
+    uint8_t valid; //Bit 0: validDate, 1: validTime, 2: fullyResolved
+    uint32_t tAcc; //Time accuracy estimate in ns
+    int32_t nano; //Fraction of second in ns, -1e9..1e9
+    uint8_t fixType; //0 = No fix, 1 = Dead reckoning, 2 = 2D, 3 = 3D, 4 = GNSS + DR, 5 = Time only
+    uint8_t flags; //Bit 0: gnssFixOK
+    uint8_t flags2;
+    uint8_t numSV; //Satellites used in solution
+    int32_t lon, lat; //1e-7 degrees
+    int32_t height; //Height above ellipsoid in mm
+    int32_t hMSL; //Height above mean sea level in mm
+    uint32_t hAcc, vAcc; //Accuracy estimates in mm
+    int32_t velN, velE, velD; //NED velocity in mm/s
+    int32_t gSpeed; //Ground speed in mm/s
+    int32_t headMot; //Heading of motion in 1e-5 degrees
+    uint32_t sAcc; //Speed accuracy estimate in mm/s
+    uint32_t headAcc; //Heading accuracy estimate in 1e-5 degrees
+    uint16_t pDOP; //1/100
+    uint8_t reserved1[6];
+    int32_t headVeh; //Heading of vehicle in 1e-5 degrees
+    int16_t magDec; //Magnetic declination in 1e-2 degrees
+    uint16_t magAcc; //Magnetic declination accuracy in 1e-2 degrees
+};
+
+/**
+ * UBX-NAV-TIMEUTC: UTC time solution
+ */
+struct __attribute__((packed)) UBXNavTimeUTC {
+    static const uint8_t msgClass = UBX_CLASS_NAV;
+    static const uint8_t msgId = UBX_ID_NAV_TIMEUTC;
+
+    uint32_t iTOW; //GPS time of week in ms
+    uint32_t tAcc; //Time accuracy estimate in ns
+    int32_t nano; //Fraction of second in ns, -1e9..1e9
+    uint16_t year;
+    uint8_t month, day, hour, min, sec;
+    uint8_t valid; //Bit 0: validTOW, 1: validWKN, 2: validUTC
+};
+
+/**
+ * UBX-NAV-SAT: Satellite information.
+ * The header is followed by numSvs UBXNavSatSv blocks, see getUBXNavSatSvs().
+ */
+struct __attribute__((packed)) UBXNavSat {
+    static const uint8_t msgClass = UBX_CLASS_NAV;
+    static const uint8_t msgId = UBX_ID_NAV_SAT;
+
+    uint32_t iTOW; //GPS time of week in ms
+    uint8_t version;
+    uint8_t numSvs;
+    uint8_t reserved1[2];
+};
+
+struct __attribute__((packed)) UBXNavSatSv {
+    uint8_t gnssId; //0 = GPS, 1 = SBAS, 2 = Galileo, 3 = BeiDou, 5 = QZSS, 6 = GLONASS
+    uint8_t svId;
+    uint8_t cno; //Carrier to noise ratio in dBHz
+    int8_t elev; //Elevation in degrees, -90..90
+    int16_t azim; //Azimuth in degrees, 0..360
+    int16_t prRes; //Pseudorange residual in 0.1 m
+    uint32_t flags; //Bits 0..2: quality indicator, bit 3: svUsed
+};
+
+static_assert(sizeof(UBXNavPVT) == 92, "UBX-NAV-PVT payload size");
+static_assert(sizeof(UBXNavTimeUTC) == 20, "UBX-NAV-TIMEUTC payload size");
+static_assert(sizeof(UBXNavSat) == 8, "UBX-NAV-SAT header size");
+static_assert(sizeof(UBXNavSatSv) == 12, "UBX-NAV-SAT block size");
+
+/**
+ * Decode a message in place, without copying.
+ * @return A pointer to the payload or NULL if the message is not of type T
+ *  or too short
+ */
+template<typename T>
+inline const T* decodeUBXMessage(const UBXMessage& msg) {
+    if(msg.msgClass != T::msgClass || msg.msgId != T::msgId || msg.size < sizeof(T)) {
+        return NULL;
+    }
+    return reinterpret_cast<const T*>(msg.payload);
+}
+
+/**
+ * Get the satellite blocks of a UBX-NAV-SAT message in place.
+ * @return The number of blocks present in the payload,
+ *  0 if the message is not a valid UBX-NAV-SAT message
+ */
+inline size_t getUBXNavSatSvs(const UBXMessage& msg, const UBXNavSatSv** svs) {
+    const UBXNavSat* sat = decodeUBXMessage<UBXNavSat>(msg);
+    if(sat == NULL) {
+        return 0;
+    }
+    size_t available = (msg.size - sizeof(UBXNavSat)) / sizeof(UBXNavSatSv);
+    *svs = reinterpret_cast<const UBXNavSatSv*>(msg.payload + sizeof(UBXNavSat));
+    return sat->numSvs < available ? sat->numSvs : available;
+}
+
+/**
+ * Compute the 8-bit Fletcher checksum over class, ID, length and payload.
+ * @return CK_A in the low byte, CK_B in the high byte, i.e. the two bytes
+ *  in stream order when stored little endian
+ */
+uint16_t computeUBXChecksum(const uint8_t* data, size_t size);
+
+/**
+ * Build a complete UBX frame (sync chars, header, payload, checksum).
+ * @param out Must have size + UBX_FRAME_OVERHEAD bytes available
+ * @return The frame size
+ */
+size_t buildUBXMessage(uint8_t msgClass, uint8_t msgId, const void* payload, uint16_t size, uint8_t* out);
+
+/**
+ * UBX-CFG-PRT for UART1, 8N1.
+ * The receiver switches to the new baudrate after acknowledging the message.
+ * @param inProtoMask Accepted protocols, e.g. UBX_PROTO_UBX | UBX_PROTO_NMEA
+ * @param outProtoMask Output protocols, e.g. UBX_PROTO_UBX for UBX-only output
+ * @param out Must have 28 bytes available
+ */
+size_t buildUBXCfgPrtUART(uint32_t baudrate, uint16_t inProtoMask, uint16_t outProtoMask, uint8_t* out);
+
+/**
+ * UBX-CFG-RATE: Measurement rate, aligned to GPS time
+ * @param measRateMs Measurement period in ms, e.g. 100 for 10 Hz
+ * @param navRate Number of measurements per navigation solution
+ * @param out Must have 14 bytes available
+ */
+size_t buildUBXCfgRate(uint16_t measRateMs, uint16_t navRate, uint8_t* out);
+
+/**
+ * UBX-CFG-MSG: Output rate of a message on the current port
+ * @param rate Output once every rate navigation solutions, 0 = disabled
+ * @param out Must have 11 bytes available
+ */
+size_t buildUBXCfgMsg(uint8_t msgClass, uint8_t msgId, uint8_t rate, uint8_t* out);
+
+#endif //__UBX_H
@@ -1,5 +1,5 @@
 /**
- * UBLOX NMEA driver. Does not support binary protocol for simplicity
+ * UBLOX NMEA/UBX driver.
  * Reference: https://www.u-blox.com/sites/default/files/products/documents/u-blox7-V14_ReceiverDescrProtSpec_(GPS.G7-SW-12001)_Public.pdf
  */
 #ifndef __UBLOX_H
@@ -9,52 +9,229 @@
 #include <string.h>
 #include <ctype.h>
 
+#include "NMEA.h"
+#include "NMEAFramer.h"
+#include "NMEADispatch.h"
+#include "NMEAUBXFramer.h"
+#include "NMEARing.h"
+#include "NMEAStats.h"
+#include "UBX.h"
+
+#define UBLOX_BUFSIZE 256
+#define UBLOX_READ_CHUNKSIZE 256
+
+/**
+ * Low-level driver hooks, defined by the application if it uses UBloxLLDTransport
+ */
 void ubloxLLDWrite(void* serialDriver, const char* buf, size_t size);
 size_t ubloxLLDRead(void* serialDriver, char* buf, size_t size);
 
-#define UBLOX_BUFSIZE 256
-static char rxbuf[UBLOX_BUFSIZE];
+/**
+ * Transport that forwards to the ubloxLLDRead()/ubloxLLDWrite() hooks,
+ * for low-level drivers that are only available as C functions.
+ */
+struct UBloxLLDTransport {
+    explicit UBloxLLDTransport(void* serialDriver = NULL) : serialDriver(serialDriver) {}
+
+    size_t read(char* buf, size_t size) {
+        return ubloxLLDRead(serialDriver, buf, size);
+    }
+
+    void write(const char* buf, size_t size) {
+        ubloxLLDWrite(serialDriver, buf, size);
+    }
+
+    void* serialDriver;
+};
 
 /**
- * Read until \n. Returns the size if a whole line
- * has been read and the first character is $, i.e.
- * the buffer possibly contains some kind of valid NMEA message.
- * In case of read errors, returns 0.
- * In case of success, returns the number of valid
- * characters in the buffer, including \r\n.
- * When a non-zero value is returned, the buffer contains a valid cstring.
+ * Driver for a single receiver. All state (line buffer, framers) is owned
+ * by the instance, so any number of receivers can be driven concurrently,
+ * e.g. one per thread, without locking.
+ *
+ * The transport is a compile-time policy with the members
+ *  - size_t read(char* buf, size_t size): Read up to size bytes,
+ *    return the number of bytes read (0 on errors)
+ *  - void write(const char* buf, size_t size): Write all bytes
+ * so calls to it can be inlined.
+ *
+ * @tparam BufSize Size of the line buffer used by readLine()
  */
-size_t ubloxReadLine(void* port) {
-    for(size_t i = 0; i < (UBLOX_BUFSIZE - 1); i++) {
-        if(ubloxLLDRead(port, &rxbuf[i], 1) == 0) {
-            return 0;
-        }
-        if(i == 0 && rxbuf[0] != '$') {
-            return 0;
-        }
-        if(rxbuf[i] == '\n') {
-            //Frame finished. Perform some validity checks
-            if(i < 3) { //'$' + 1+ byte content + \r\n
+template<typename Transport, size_t BufSize = UBLOX_BUFSIZE>
+class UBloxDriver {
+    static_assert(BufSize >= 5, "The line buffer must fit '$', content, \\r\\n and NUL");
+public:
+    explicit UBloxDriver(const Transport& transport = Transport()) : transport(transport) {
+        rxbuf[0] = '\0';
+    }
+
+    Transport& getTransport() {
+        return transport;
+    }
+
+    /**
+     * Read until \n. Returns the size if a whole line
+     * has been read and the first character is $, i.e.
+     * the buffer possibly contains some kind of valid NMEA message.
+     * In case of read errors, returns 0.
+     * In case of success, returns the number of valid
+     * characters in the buffer, including \r\n.
+     * When a non-zero value is returned, getLine() is a valid cstring.
+     */
+    size_t readLine() {
+        for(size_t i = 0; i < (BufSize - 1); i++) {
+            if(transport.read(&rxbuf[i], 1) == 0) {
                 return 0;
             }
-            if(rxbuf[i - 1] != '\r') { //End must be \r\n
+            if(i == 0 && rxbuf[0] != '$') {
+                NMEA_STATS_ADD(NMEAStatsLineErrors, 1);
                 return 0;
             }
-            //Return valid frame
-            rxbuf[i + 1] = '\0'; //Ensure buffer contains a cstring
-            return i + 1;
+            if(rxbuf[i] == '\n') {
+                //Frame finished. Perform some validity checks
+                if(i < 3) { //'$' + 1+ byte content + \r\n
+                    NMEA_STATS_ADD(NMEAStatsLineErrors, 1);
+                    return 0;
+                }
+                if(rxbuf[i - 1] != '\r') { //End must be \r\n
+                    NMEA_STATS_ADD(NMEAStatsLineErrors, 1);
+                    return 0;
+                }
+                //Return valid frame
+                rxbuf[i + 1] = '\0'; //Ensure buffer contains a cstring
+                return i + 1;
+            }
         }
+        //Buffer full but no LF founds
+        NMEA_STATS_ADD(NMEAStatsLineErrors, 1);
+        return 0;
     }
-    //Buffer full but no LF founds
-    return 0;
-}
 
-void parseUBloxMessage(size_t size) {
-    if(strncmp("$GPGLL,", rxbuf, size)) {
-        GPSPosition pos;
-        parseGLLMessage(size, &pos);
+    /**
+     * The line read by the last successful readLine()
+     */
+    const char* getLine() const {
+        return rxbuf;
+    }
+
+    /**
+     * Parse the line read by readLine() using dispatchNMEASentence().
+     * @param enabledTypes Combination of NMEA_TYPE_MASK(...) values
+     * @return 0 on success, 1 if the sentence type is unknown or not enabled, -n else.
+     */
+    int parseMessage(size_t size, uint32_t enabledTypes, NMEAParsedSentence* result) const {
+        return dispatchNMEASentence(rxbuf, size, enabledTypes, result);
     }
-}
+
+    /**
+     * Read a chunk of up to UBLOX_READ_CHUNKSIZE bytes using a single
+     * read() call and pass it to the framer of this driver.
+     * Calls onSentence(const char* sentence, size_t size) for every
+     * complete sentence. Partial sentences are kept in the framer
+     * and completed by subsequent calls.
+     *
+     * In contrast to readLine(), the transport should return
+     * as soon as any data is available, not only if the buffer is full.
+     * @return The number of sentences processed
+     */
+    template<typename Callback>
+    size_t readSentences(Callback onSentence) {
+        char chunk[UBLOX_READ_CHUNKSIZE];
+        size_t size = transport.read(chunk, sizeof(chunk));
+        return framer.feed(chunk, size, onSentence);
+    }
+
+    /**
+     * Like readSentences(), but for ports that output both NMEA and UBX.
+     * Calls onSentence(const char* sentence, size_t size) for every complete sentence
+     * and onMessage(const UBXMessage& message) for every complete UBX message.
+     * Uses a framer separate from readSentences().
+     * @return The number of sentences and messages processed
+     */
+    template<typename NMEACallback, typename UBXCallback>
+    size_t readMessages(NMEACallback onSentence, UBXCallback onMessage) {
+        char chunk[UBLOX_READ_CHUNKSIZE];
+        size_t size = transport.read(chunk, sizeof(chunk));
+        return ubxFramer.feed(chunk, size, onSentence, onMessage);
+    }
+
+    /**
+     * Read with a single read() call directly into the free space of
+     * a ring (see NMEARing), e.g. from a reader thread. The parser task
+     * consumes the sentences with ring.readSentences().
+     * @return The number of bytes read, 0 if the ring is full
+     */
+    template<typename Ring>
+    size_t readIntoRing(Ring& ring) {
+        char* space;
+        uint32_t size = ring.getWriteSpace(&space);
+        if(size == 0) {
+            return 0;
+        }
+        size_t n = transport.read(space, size);
+        ring.commitWrite((uint32_t)n);
+        return n;
+    }
+
+    const NMEAFramer& getFramer() const {
+        return framer;
+    }
+
+    const NMEAUBXFramer& getUBXFramer() const {
+        return ubxFramer;
+    }
+
+    /**
+     * Send a sentence given as $...* and append the checksum and \r\n
+     */
+    void sendNMEAMsgAndChecksum(const char* msg, size_t size) {
+        //Write the msg itself
+        transport.write(msg, size);
+        //Compute and send checksum (over the content between $ and *)
+        uint16_t chksum = computeHexNMEAChecksum(msg, size);
+        transport.write((const char*)&chksum, 2);
+        transport.write("\r\n", 2);
+    }
+
+    void configure() {
+        /**
+         * Port ID: 1 = UART
+         * Inproto / outproto: NMEA only
+         * Baudrate: 115200
+         * Autobauding off
+         * Flags: None
+         */
+        static const char msg[] = "$PUBX,41,1,0001,0001,115200,0*";
+        //Send message, then compute and send checksum
+        sendNMEAMsgAndChecksum(msg, sizeof(msg) - 1);
+    }
+
+    /**
+     * Switch UART1 to UBX-only output and configure a high navigation rate.
+     * Enables UBX-NAV-PVT for every solution.
+     * CFG-PRT is sent last, as the receiver switches to the new baudrate right
+     * after it. The host must switch its port to the same baudrate after this call.
+     * @param measRateMs Measurement period in ms, e.g. 100 for 10 Hz
+     * @param satInterval Output UBX-NAV-SAT every satInterval solutions, 0 = disabled
+     */
+    void configureBinary(uint32_t baudrate, uint16_t measRateMs, uint8_t satInterval) {
+        uint8_t msg[32];
+        size_t size = buildUBXCfgRate(measRateMs, 1, msg);
+        transport.write((const char*)msg, size);
+        size = buildUBXCfgMsg(UBX_CLASS_NAV, UBX_ID_NAV_PVT, 1, msg);
+        transport.write((const char*)msg, size);
+        size = buildUBXCfgMsg(UBX_CLASS_NAV, UBX_ID_NAV_SAT, satInterval, msg);
+        transport.write((const char*)msg, size);
+        //Accept both protocols so NMEA configuration (PUBX) keeps working
+        size = buildUBXCfgPrtUART(baudrate, UBX_PROTO_UBX | UBX_PROTO_NMEA, UBX_PROTO_UBX, msg);
+        transport.write((const char*)msg, size);
+    }
+private:
+    Transport transport;
+    char rxbuf[BufSize];
+    NMEAFramer framer;
+    NMEAUBXFramer ubxFramer;
+};
 
 /**
  * Compute the UBlox checksum and place both
@@ -66,39 +243,10 @@ void parseUBloxMessage(size_t size) {
  * @param payloadSize The number of valid bytes in payload.
  *    This must be <= the number of available bytes in payload minus two.
  */
-void calcChecksum(char* payload, size_t payloadSize) {
-  uint8_t checksum[2] = {0, 0};
-  for (size_t i = 0; i < payloadSize ;i++) {
-    checksum[0] += payload[i];
-    checksum[1] += checksum[0];
-  }
-  memcpy(payload + payloadSize, checksum, 2);
+inline void calcChecksum(char* payload, size_t payloadSize) {
+    uint16_t checksum = computeUBXChecksum((const uint8_t*)payload, payloadSize);
+    payload[payloadSize] = (char)(uint8_t)checksum;
+    payload[payloadSize + 1] = (char)(uint8_t)(checksum >> 8);
 }
 
-/**
- * Takes
- */
-void sendNMEAMsgAndChecksum(void* serialPort, const char* msg, size_t size) {
-    //Write the msg itself
-    ubloxLLDWrite(serialPort, msg, size);
-    //Compute and send checksum
-    uint16_t chksum = computeHexNMEAChecksum(msg + 1, size - 2); //
-    ubloxLLDWrite(serialPort, (const char*)&chksum, 2);
-    ubloxLLDWrite(serialPort, "\r\n", 2);
-}
-
-void configureUBLOX(void* port) {
-    /**
-     * Port ID: 1 = UART
-     * Inproto / outproto: NMEA only
-     * Baudrate: 115200
-     * Autobauding off
-     * Flags: None
-     */
-    static const char msg[] = "$PUBX,41,1,0001,0001,115200,0*";
-    //Send message, then compute and send checksum
-    sendNMEAMsgAndChecksum(port, msg, strlen(msg));
-}
-
-
-#endif //__UBLOX_H
\ No newline at end of file
+#endif //__UBLOX_H
@@ -0,0 +1,133 @@
+#include "EpochAggregator.h"
+#include "NMEA.h"
+
+#include <cstring>
+
+/**
+ * Reset all fields except the GSV information
+ */
+static void resetFix(NMEAFix* fix, uint32_t utcTime) {
+    fix->utcTime = utcTime;
+    fix->date = INT32_MAX;
+    fix->position.latitude = fix->position.longitude = INT32_MAX;
+    fix->speed = fix->course = INT32_MAX;
+    fix->status = fix->posMode = '\0';
+    fix->sentenceMask &= NMEA_TYPE_MASK(NMEASentenceGSV);
+}
+
+EpochAggregator::EpochAggregator(uint32_t completeMask)
+    : completeMask(completeMask), open(false), hasPublished(false), lastPublishedTime(0) {
+    memset(&current, 0, sizeof(current));
+    resetFix(&current, INT32_MAX);
+}
+
+int EpochAggregator::publish() {
+    if(!open) {
+        return 0;
+    }
+    current.epoch = latest.getVersion();
+    latest.store(current);
+    lastPublishedTime = current.utcTime;
+    hasPublished = true;
+    open = false;
+    //GSV received from now on belongs to the next epoch
+    memset(current.satsInView, 0, sizeof(current.satsInView));
+    current.sentenceMask = 0;
+    return 1;
+}
+
+int EpochAggregator::publishIfComplete() {
+    if(open && (current.sentenceMask & completeMask) == completeMask) {
+        return publish();
+    }
+    return 0;
+}
+
+/**
+ * Make sure the epoch for the given time is open.
+ * @param use Set to false if the epoch has already been published,
+ *  i.e. the sentence arrived after the epoch was complete.
+ * @return The number of epochs published
+ */
+int EpochAggregator::enterEpoch(uint32_t utcTime, bool* use) {
+    int published = 0;
+    if(open && utcTime != current.utcTime) { //Next timestamp ends the epoch
+        published = publish();
+    }
+    *use = true;
+    if(!open) {
+        if(hasPublished && utcTime == lastPublishedTime) {
+            *use = false;
+            return published;
+        }
+        resetFix(&current, utcTime);
+        open = true;
+    }
+    return published;
+}
+
+int EpochAggregator::add(const char* sentence, size_t size) {
+    if(checkNMEAChecksum(sentence, size) == -2) {
+        return -1;
+    }
+    NMEASentenceType type = getNMEASentenceType(sentence, size);
+    NMEASentenceView view(sentence, size);
+    int published = 0;
+    bool use;
+    switch(type) {
+        case NMEASentenceRMC: {
+            RMCSentence rmc;
+            if(parseRMCSentence(view, &rmc) != 0) {
+                return -1;
+            }
+            published = enterEpoch(rmc.utcTime, &use);
+            if(use) {
+                current.date = rmc.date;
+                current.position = rmc.position;
+                current.speed = rmc.speed;
+                current.course = rmc.course;
+                current.status = rmc.status;
+                current.posMode = rmc.posMode;
+            }
+            break;
+        }
+        case NMEASentenceGLL: {
+            NMEAPosition position;
+            //GLL has time and status after the position
+            uint32_t utcTime = view.utcTime(5);
+            if(parseGLLSentence(view, &position) != 0 || utcTime == INT32_MAX) {
+                return -1;
+            }
+            published = enterEpoch(utcTime, &use);
+            if(use) {
+                current.position = position;
+                if(current.status == '\0') {
+                    current.status = view.character(6);
+                }
+            }
+            break;
+        }
+        case NMEASentenceGSV: {
+            GSVSentence gsv;
+            if(parseGSVSentence(view, &gsv) != 0) {
+                return -1;
+            }
+            int slot = GSVAssembler::getTalkerSlot(sentence + 1);
+            if(slot >= 0) {
+                current.satsInView[slot] = gsv.numSats;
+            }
+            //Only the last message completes the GSV part of the epoch
+            use = gsv.msgNum == gsv.numMsgs;
+            break;
+        }
+        default: return -1;
+    }
+    if(use) {
+        current.sentenceMask |= NMEA_TYPE_MASK(type);
+    }
+    return published + publishIfComplete();
+}
+
+int EpochAggregator::flush() {
+    return publish();
+}
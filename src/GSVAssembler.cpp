@@ -0,0 +1,78 @@
+#include "GSVAssembler.h"
+
+#include <cstring>
+
+GSVAssembler::GSVAssembler() : discardedSequences(0) {
+    for (int i = 0; i < GSV_NUM_TALKER_SLOTS; ++i) {
+        slots[i].published = -1;
+        slots[i].numMsgs = 0;
+        slots[i].nextMsgNum = 0;
+    }
+}
+
+int GSVAssembler::getTalkerSlot(const char* talker) {
+    if(talker[0] != 'G') {
+        return -1;
+    }
+    switch(talker[1]) {
+        case 'P': return GSVTalkerGP;
+        case 'L': return GSVTalkerGL;
+        case 'A': return GSVTalkerGA;
+        case 'B': return GSVTalkerGB;
+        default: return -1;
+    }
+}
+
+int GSVAssembler::add(const NMEAParsedSentence& sentence) {
+    if(sentence.type != NMEASentenceGSV) {
+        return -2;
+    }
+    return add(sentence.talker, sentence.gsv);
+}
+
+int GSVAssembler::add(const char* talker, const GSVSentence& sentence) {
+    int slotIdx = getTalkerSlot(talker);
+    if(slotIdx < 0) {
+        return -1;
+    }
+    if(sentence.msgNum == 0 || sentence.msgNum > sentence.numMsgs) {
+        return -2;
+    }
+    Slot& slot = slots[slotIdx];
+    //The view that is not published is being assembled
+    GSVSkyView& view = slot.views[slot.published == 0 ? 1 : 0];
+    if(sentence.msgNum == 1) {
+        if(slot.nextMsgNum != 0) { //Previous sequence is incomplete
+            discardedSequences++;
+        }
+        //Start new sequence
+        slot.numMsgs = sentence.numMsgs;
+        view.numSats = sentence.numSats;
+        view.numSatInfos = 0;
+        memset(view.present, 0, sizeof(view.present));
+    } else if(sentence.msgNum != slot.nextMsgNum || sentence.numMsgs != slot.numMsgs) {
+        if(slot.nextMsgNum != 0) {
+            discardedSequences++;
+        }
+        slot.nextMsgNum = 0;
+        return -3;
+    }
+    for (int i = 0; i < sentence.numSatInfos; ++i) {
+        const GSVSatInfo& sat = sentence.satellites[i];
+        if(sat.id > GSV_MAX_SATELLITE_ID) {
+            continue;
+        }
+        if(!view.hasSatellite(sat.id)) {
+            view.present[sat.id / 64] |= (uint64_t)1 << (sat.id % 64);
+            view.numSatInfos++;
+        }
+        view.satellites[sat.id] = sat;
+    }
+    if(sentence.msgNum == sentence.numMsgs) { //Sequence complete
+        slot.published = slot.published == 0 ? 1 : 0;
+        slot.nextMsgNum = 0;
+        return 1;
+    }
+    slot.nextMsgNum = sentence.msgNum + 1;
+    return 0;
+}
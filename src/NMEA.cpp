@@ -1,59 +1,190 @@
 #include "NMEA.h"
+#include "NMEAStats.h"
 
 #include <cctype>
 #include <cstring>
 
 
-int32_t parseNMEAInteger(const char* src) {
-    //There must be at least one digit at the start
-    if(!isdigit(*src)) {
-        return INT32_MAX;
+/**
+ * Field terminator for NUL-terminated fields
+ */
+struct CStringFieldEnd {
+    bool operator()(const char* src) const {
+        return *src == ',' || *src == '\0' || *src == '*';
+    }
+    /**
+     * true if src is beyond the end of the buffer
+     */
+    bool atLimit(const char*) const {
+        return false;
+    }
+    /**
+     * true if 8 bytes may be loaded from src.
+     * As we don't know where the string ends, this is never the case by default.
+     * With NMEA_CSTRING_SWAR, loads that don't cross a page boundary are allowed,
+     * as they can't fault even if they read past the terminator.
+     */
+    bool canLoad8(const char* src) const {
+#ifdef NMEA_CSTRING_SWAR
+        return ((uintptr_t)src & 4095) <= 4096 - 8;
+#else
+        (void)src;
+        return false;
+#endif
+    }
+};
+
+/**
+ * Field terminator for size-delimited fields
+ */
+struct SizedFieldEnd {
+    const char* end;
+    bool operator()(const char* src) const {
+        return src == end || *src == ',' || *src == '\0' || *src == '*';
     }
-    int32_t ret = 0;
-    for(;*src != ',' && *src != '\0' && *src != '*';src++) {
-        if(!isdigit(*src)) {
-            return INT32_MAX;
+    bool atLimit(const char* src) const {
+        return src == end;
+    }
+    bool canLoad8(const char* src) const {
+        return end - src >= 8;
+    }
+};
+
+static const uint32_t powersOf10[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+};
+
+/**
+ * Multiply by 10^exponent, wrapping around like repeated multiplication by 10
+ */
+static inline uint32_t multiplyPow10(uint32_t value, int exponent) {
+    for(; exponent > 8; exponent -= 8) {
+        value *= powersOf10[8];
+    }
+    return value * powersOf10[exponent];
+}
+
+/**
+ * Parse up to 8 decimal digits at src.
+ * Loads 8 bytes at once and validates and converts them using SWAR
+ * arithmetic if possible, else (e.g. near the end of the buffer)
+ * falls back to a per-character loop.
+ * @return The number of digits parsed. *value is the parsed value.
+ */
+template<typename FieldEnd>
+static inline unsigned parseDigits8(const char* src, FieldEnd atEnd, uint32_t* value) {
+#if !defined(NMEA_DISABLE_SWAR) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if(atEnd.canLoad8(src)) {
+        uint64_t word;
+        memcpy(&word, src, 8);
+        //Digit characters become 0..9, all others become >= 10
+        uint64_t digits = word ^ 0x3030303030303030ULL;
+        //Highest bit of each byte set if it is not a digit
+        uint64_t nonDigits = (((digits & 0x7F7F7F7F7F7F7F7FULL) + 0x7676767676767676ULL) | digits)
+                             & 0x8080808080808080ULL;
+        unsigned n = nonDigits ? (__builtin_ctzll(nonDigits) >> 3) : 8;
+        if(n == 0) {
+            *value = 0;
+            return 0;
         }
-        ret = (ret * 10) + (*src - '0');
+        //Discard non-digits and align, so that the missing digits become leading zeros
+        digits <<= 8 * (8 - n);
+        //Combine pairs of digits, then pairs of pairs, ...
+        digits = ((digits & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+        digits = ((digits & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+        *value = (uint32_t)(((digits & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32);
+        return n;
+    }
+#endif
+    uint32_t ret = 0;
+    unsigned n = 0;
+    for(; n < 8 && !atEnd.atLimit(src + n) && isdigit(src[n]); n++) {
+        ret = (ret * 10) + (src[n] - '0');
     }
-    return ret;
+    *value = ret;
+    return n;
 }
 
-int32_t parseNMEAFixedPointDecimal(const char* src, int decimals) {
+/**
+ * Parse a run of decimal digits of any length.
+ * Overflows wrap around.
+ * @param ndigits Set to the number of digits parsed
+ * @return Pointer to the first non-digit character
+ */
+template<typename FieldEnd>
+static inline const char* parseDigitRun(const char* src, FieldEnd atEnd, uint32_t* value, int* ndigits) {
+    uint32_t ret = 0;
+    int total = 0;
+    for(;;) {
+        uint32_t chunk;
+        unsigned n = parseDigits8(src, atEnd, &chunk);
+        ret = ret * powersOf10[n] + chunk;
+        total += n;
+        src += n;
+        if(n < 8) {
+            break;
+        }
+    }
+    *value = ret;
+    *ndigits = total;
+    return src;
+}
+
+template<typename FieldEnd>
+static inline int32_t parseInteger(const char* src, FieldEnd atEnd) {
+    uint32_t ret;
+    int ndigits;
+    src = parseDigitRun(src, atEnd, &ret, &ndigits);
+    //There must be at least one digit at the start, and only digits until the end
+    if(ndigits == 0 || !atEnd(src)) {
+        return INT32_MAX;
+    }
+    return (int32_t)ret;
+}
+
+template<typename FieldEnd>
+static inline int32_t parseFixedPointDecimal(const char* src, FieldEnd atEnd, int decimals) {
+    uint32_t integer, fraction;
+    int integerDigits, fractionDigits;
+    src = parseDigitRun(src, atEnd, &integer, &integerDigits);
     //There must be at least one digit at the start
-    if(!isdigit(*src)) {
+    if(integerDigits == 0) {
         return INT32_MAX;
     }
-    int32_t ret = 0;
-    int digitsSinceDot = -1; //0 if dot was just encountered
-    for(;*src != ',' && *src != '\0' && *src != '*';src++) {
-        if(*src == '.') {
-            if(digitsSinceDot != -1) {
-                //Already seen dot, two dots are illegal
-                return INT32_MAX;
-            }
-            digitsSinceDot = 0;
-            continue;
-        }
-        // Fail if not a digit
-        if(!isdigit(*src)) {
-            return INT32_MAX;
-        }
-        //Parse digit
-        ret = (ret * 10) + (*src - '0');
-        if(digitsSinceDot != -1) { //Dot has been encountered
-            digitsSinceDot++;
-        }
+    //No dot found but expected one, or not a digit
+    if(atEnd(src) || *src != '.') {
+        return INT32_MAX;
     }
-    if(digitsSinceDot == -1) { //No dot found but expected one
+    src = parseDigitRun(src + 1, atEnd, &fraction, &fractionDigits);
+    //Two dots are illegal, as are any other non-digits
+    if(!atEnd(src)) {
         return INT32_MAX;
     }
+    uint32_t ret = multiplyPow10(integer, fractionDigits) + fraction;
     //If there are not enough digits after the dot, we need to add the
     // appropriate number of zeros at the end.
-    while(digitsSinceDot++ < decimals) {
-        ret *= 10;
+    if(fractionDigits < decimals) {
+        ret = multiplyPow10(ret, decimals - fractionDigits);
     }
-    return ret;
+    return (int32_t)ret;
+}
+
+int32_t parseNMEAInteger(const char* src) {
+    return parseInteger(src, CStringFieldEnd());
+}
+
+int32_t parseNMEAInteger(const char* src, size_t size) {
+    SizedFieldEnd atEnd = {src + size};
+    return parseInteger(src, atEnd);
+}
+
+int32_t parseNMEAFixedPointDecimal(const char* src, int decimals) {
+    return parseFixedPointDecimal(src, CStringFieldEnd(), decimals);
+}
+
+int32_t parseNMEAFixedPointDecimal(const char* src, size_t size, int decimals) {
+    SizedFieldEnd atEnd = {src + size};
+    return parseFixedPointDecimal(src, atEnd, decimals);
 }
 
 int32_t parseNMEACoordinate(const char* src) {
@@ -103,25 +234,60 @@ uint16_t computeHexNMEAChecksum(const char* payload, size_t size) {
     return hexLUT[checksum & 0x0F] << 8 | hexLUT[(checksum & 0xF0) >> 4];
 }
 
-/*NMEAArgs parseNMEAArguments(const char* buf) {
-    NMEAArgs ret;
-    //Parse buffer
-    size_t argIndex = 0;
-    size_t lastComma = 0; //
-    while(*buf++ != '\0') {
-        if(buf[0] == '*' //End of arguments, checksum follows
-            || buf[0] == '\0') { //Buffer OVF prevention
-            return ret;
-        } else if(buf[i] == ',') {
-            ret.args[argIndex].size = i - lastComma;
-            lastComma = i;
-            ret.args[argIndex++].offset = i + 1;
-            ret.nargs = argIndex;
-            if(argIndex >= MAX_NMEA_ARGS) {
-                //Ignore additional arguments
-                return ret;
+static int parseHexDigit(char c) {
+    if(c >= '0' && c <= '9') {
+        return c - '0';
+    } else if(c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    } else if(c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+int checkNMEAChecksum(const char* sentence, size_t size) {
+    const char* star = (const char*)memchr(sentence, '*', size);
+    if(star == NULL || (size_t)(star - sentence) + 3 > size) {
+        return -1;
+    }
+    int hi = parseHexDigit(star[1]);
+    int lo = parseHexDigit(star[2]);
+    if(hi < 0 || lo < 0) {
+        return -1;
+    }
+    uint8_t checksum = computeNMEAChecksum(sentence, star - sentence + 1);
+    if(checksum != ((hi << 4) | lo)) {
+        NMEA_STATS_ADD(NMEAStatsChecksumErrors, 1);
+        return -2;
+    }
+    return 0;
+}
+
+NMEASentenceView::NMEASentenceView(const char* sentence) : buf(sentence), nfields(0) {
+    index(NULL);
+}
+
+NMEASentenceView::NMEASentenceView(const char* sentence, size_t size) : buf(sentence), nfields(0) {
+    index(sentence + size);
+}
+
+void NMEASentenceView::index(const char* end) {
+    const char* pos = buf;
+    if(pos != end && *pos == '$') {
+        pos++;
+    }
+    size_t fieldStart = pos - buf;
+    for(;; pos++) {
+        char c = (pos == end) ? '\0' : *pos;
+        if(c == ',' || c == '*' || c == '\0' || c == '\r' || c == '\n') {
+            fields[nfields].offset = (uint16_t)fieldStart;
+            fields[nfields].size = (uint16_t)(pos - buf - fieldStart);
+            nfields++;
+            if(c != ',' || nfields == NMEA_MAX_FIELDS) {
+                //End of arguments or ignore additional arguments
+                return;
             }
+            fieldStart = pos - buf + 1;
         }
     }
-    return ret;
-}*/
+}
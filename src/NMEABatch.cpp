@@ -0,0 +1,87 @@
+#include "NMEABatch.h"
+#include "NMEA.h"
+#include "NMEASentences.h"
+#include "NMEADispatch.h"
+
+#include <cstring>
+
+/**
+ * Parse a single sentence into row idx.
+ * @return true if a row has been written
+ */
+static inline bool parseRow(const char* line, size_t size, NMEAFixColumns* columns, size_t idx) {
+    NMEASentenceType type = getNMEASentenceType(line, size);
+    if(type != NMEASentenceRMC && type != NMEASentenceGLL) {
+        return false;
+    }
+    NMEASentenceView view(line, size);
+    uint8_t status;
+    RMCSentence rmc;
+    if(type == NMEASentenceRMC) {
+        status = NMEA_ROW_RMC;
+        if(parseRMCSentence(view, &rmc) == 0) {
+            status |= NMEA_ROW_VALID;
+        }
+    } else {
+        status = NMEA_ROW_GLL;
+        if(parseGLLSentence(view, &rmc.position) == 0) {
+            status |= NMEA_ROW_VALID;
+        }
+        //GLL has time and status after the position
+        rmc.utcTime = view.utcTime(5);
+        rmc.status = view.character(6);
+        rmc.speed = rmc.course = rmc.date = INT32_MAX;
+    }
+    if(checkNMEAChecksum(line, size) == -2) {
+        status = (status & ~NMEA_ROW_VALID) | NMEA_ROW_CHECKSUM_ERROR;
+    }
+    if(!(status & NMEA_ROW_VALID)) {
+        //Partially parsed fields are not reliable
+        rmc.utcTime = INT32_MAX;
+        rmc.position.latitude = rmc.position.longitude = INT32_MAX;
+        rmc.speed = rmc.course = rmc.date = INT32_MAX;
+    } else if(rmc.status == 'A') {
+        status |= NMEA_ROW_FIX;
+    }
+    columns->status[idx] = status;
+    if(columns->utcTime) {
+        columns->utcTime[idx] = rmc.utcTime;
+    }
+    if(columns->latitude) {
+        columns->latitude[idx] = rmc.position.latitude;
+    }
+    if(columns->longitude) {
+        columns->longitude[idx] = rmc.position.longitude;
+    }
+    if(columns->speed) {
+        columns->speed[idx] = rmc.speed;
+    }
+    if(columns->course) {
+        columns->course[idx] = rmc.course;
+    }
+    if(columns->date) {
+        columns->date[idx] = rmc.date;
+    }
+    return true;
+}
+
+size_t parseNMEAFixBatch(const char* buf, size_t size, NMEAFixColumns* columns, size_t* consumed) {
+    const char* pos = buf;
+    const char* end = buf + size;
+    size_t rows = 0;
+    while(pos < end && rows < columns->capacity) {
+        const char* eol = (const char*)memchr(pos, '\n', end - pos);
+        if(eol == NULL) { //Incomplete line
+            break;
+        }
+        const char* start = (const char*)memchr(pos, '$', eol - pos);
+        if(start != NULL) {
+            rows += parseRow(start, eol - start, columns, rows);
+        }
+        pos = eol + 1;
+    }
+    if(consumed != NULL) {
+        *consumed = pos - buf;
+    }
+    return rows;
+}
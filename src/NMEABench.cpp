@@ -0,0 +1,407 @@
+/**
+ * Micro-benchmark suite for the NMEA parsers and formatters.
+ * Usage: nmeabench [--json] [--sentences N] [--seed S] [--filter name]
+ *
+ * Reports per-call latency percentiles, throughput and cycles/byte for each
+ * benchmarked function on a deterministic synthetic corpus, and for some the
+ * speedup (calls/s ratio) over a bench-local baseline implementation.
+ * With --json, one JSON object per benchmark is printed per line.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define NMEA_BENCH_HAVE_TSC
+#endif
+
+#include "NMEA.h"
+#include "NMEASentences.h"
+#include "NMEACorpus.h"
+#include "NMEAFormat.h"
+#include "NMEASentenceOperators.h"
+#include "NMEATime.h"
+#include "NMEAGeo.h"
+#include "NMEAGeofence.h"
+
+using namespace std;
+
+/**
+ * Number of inputs processed per timed batch.
+ * Timing batches instead of single calls keeps the clock overhead out of the results.
+ */
+#define BENCH_BATCH_SIZE 64
+#define BENCH_REPETITIONS 5
+/**
+ * Positions per call of the batch coordinate conversions
+ */
+#define BENCH_POSITION_BLOCK 64
+
+/**
+ * Prevent the compiler from optimizing away results
+ */
+static volatile int64_t benchSink;
+
+struct Benchmark {
+    string name;
+    /**
+     * Inputs, each one a NUL-terminated string
+     */
+    vector<string> inputs;
+    function<int64_t(const string&)> run;
+    /**
+     * Name of a benchmark of the same work to report the speedup against, if any
+     */
+    string baseline;
+};
+
+struct BenchmarkResult {
+    double p50, p90, p99, max; //ns per call
+    double callsPerSecond;
+    double bytesPerSecond;
+    double cyclesPerByte; //TSC cycles, 0 if unavailable
+};
+
+static inline uint64_t readCycles() {
+#ifdef NMEA_BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static double percentile(vector<double>& sorted, double p) {
+    size_t idx = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[idx];
+}
+
+static BenchmarkResult runBenchmark(const Benchmark& bench) {
+    vector<double> latencies;
+    size_t totalBytes = 0;
+    for (const string& input : bench.inputs) {
+        totalBytes += input.size();
+    }
+    double bestSeconds = 1e30;
+    uint64_t bestCycles = 0;
+    for (int rep = 0; rep < BENCH_REPETITIONS; ++rep) {
+        latencies.clear();
+        int64_t sink = 0;
+        auto start = chrono::steady_clock::now();
+        uint64_t startCycles = readCycles();
+        for (size_t i = 0; i < bench.inputs.size(); i += BENCH_BATCH_SIZE) {
+            size_t end = min(bench.inputs.size(), i + BENCH_BATCH_SIZE);
+            auto batchStart = chrono::steady_clock::now();
+            for (size_t j = i; j < end; ++j) {
+                sink += bench.run(bench.inputs[j]);
+            }
+            auto batchEnd = chrono::steady_clock::now();
+            latencies.push_back(chrono::duration<double, nano>(batchEnd - batchStart).count() / (end - i));
+        }
+        uint64_t cycles = readCycles() - startCycles;
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        benchSink = sink;
+        if(seconds < bestSeconds) {
+            bestSeconds = seconds;
+            bestCycles = cycles;
+        }
+    }
+    sort(latencies.begin(), latencies.end());
+    BenchmarkResult result;
+    result.p50 = percentile(latencies, 0.5);
+    result.p90 = percentile(latencies, 0.9);
+    result.p99 = percentile(latencies, 0.99);
+    result.max = latencies.back();
+    result.callsPerSecond = bench.inputs.size() / bestSeconds;
+    result.bytesPerSecond = totalBytes / bestSeconds;
+    result.cyclesPerByte = totalBytes ? (double)bestCycles / totalBytes : 0;
+    return result;
+}
+
+/**
+ * Store a parsed structure as benchmark input for the formatter benchmarks.
+ * For these, MB/s refers to the size of the structure.
+ */
+template<typename T>
+static string structInput(const T& value) {
+    return string((const char*)&value, sizeof(T));
+}
+
+template<typename T>
+static const T& inputStruct(const string& s) {
+    return *(const T*)s.data();
+}
+
+/**
+ * The iostream-based RMC formatter that operator<< used before NMEAFormat,
+ * kept as the baseline of the formatter benchmarks
+ */
+static ostream& printBaselineCoordinate(ostream& os, int32_t coord) {
+    div_t degmin = div(coord, 10000000);
+    div_t minutes = div(degmin.rem, 100000);
+    os << degmin.quot << "°" << minutes.quot << '.' << minutes.rem << '"';
+    return os;
+}
+
+static ostream& printBaselineRMC(ostream& os, const RMCSentence& m) {
+    os << "RMC { ";
+    div_t year = div(m.date, 100);
+    div_t month = div(year.quot, 100);
+    os << setfill('0') << "20" << setw(2) << year.rem
+       << '-' << setw(2) << month.rem << "-" << setw(2)
+       << month.quot << ' ';
+    div_t subseconds = div(m.utcTime, 100);
+    div_t seconds = div(subseconds.quot, 100);
+    div_t minutes = div(seconds.quot, 100);
+    os << minutes.quot << ':' << minutes.rem << ':' << seconds.rem << '.' << subseconds.rem << ", ";
+    os << "NMEAPosition { ";
+    printBaselineCoordinate(os, abs(m.position.latitude)) << (m.position.latitude < 0 ? 'S' : 'N') << ' ';
+    printBaselineCoordinate(os, abs(m.position.longitude)) << (m.position.longitude < 0 ? 'W' : 'E') << " }";
+    os << m.status << '/' << m.posMode << ", ";
+    os << (m.speed / 1000.0) << " kt, " << (m.course / 1000.0) << "° }";
+    return os;
+}
+
+/**
+ * 5000 circles and triangles within +-0.1 degrees of center, like a fleet's fence set.
+ * If clustered, 90 % of them are small fences within +-0.005 degrees (e.g. the bays
+ * of a depot) and the others are spread over +-0.5 degrees.
+ */
+static void buildBenchGeofences(NMEAGeofenceIndex* index, const NMEAPosition& center, bool clustered) {
+    int32_t latitude = nmeaCoordinateToDegrees(center.latitude);
+    int32_t longitude = nmeaCoordinateToDegrees(center.longitude);
+    uint32_t random = 1;
+    for (int i = 0; i < 5000; ++i) {
+        bool small = clustered && i % 10 != 0;
+        int32_t spread = !clustered ? 1000000 : (small ? 50000 : 5000000);
+        random = random * 1103515245 + 12345;
+        int32_t lat = latitude + (int32_t)((random >> 8) % (2 * spread)) - spread;
+        random = random * 1103515245 + 12345;
+        int32_t lon = longitude + (int32_t)((random >> 8) % (2 * spread)) - spread;
+        if(i % 2 == 0) {
+            NMEAPosition c = {nmeaDegreesToCoordinate(lat), nmeaDegreesToCoordinate(lon)};
+            index->addCircle(c, small ? 5.0 + random % 20 : 50.0 + random % 500);
+        } else {
+            int32_t size = small ? 100 + random % 300 : 1000 + random % 5000;
+            NMEAPosition triangle[3] = {{nmeaDegreesToCoordinate(lat), nmeaDegreesToCoordinate(lon)},
+                {nmeaDegreesToCoordinate(lat + size), nmeaDegreesToCoordinate(lon)},
+                {nmeaDegreesToCoordinate(lat), nmeaDegreesToCoordinate(lon + size)}};
+            index->addPolygon(triangle, 3);
+        }
+    }
+    index->build();
+}
+
+/**
+ * Build the benchmarks from a corpus of sentences
+ */
+static vector<Benchmark> buildBenchmarks(const vector<string>& sentences, const vector<NMEASentenceType>& types) {
+    Benchmark coordinate = {"parseNMEACoordinate", {}, [](const string& s) {
+        return (int64_t)parseNMEACoordinate(s.c_str());
+    }, ""};
+    Benchmark checksum = {"computeNMEAChecksum", {}, [](const string& s) {
+        //Checksum from '$' to '*'
+        return (int64_t)computeNMEAChecksum(s.c_str(), s.size() - 4);
+    }, ""};
+    Benchmark rmc = {"parseRMCSentence", {}, [](const string& s) {
+        RMCSentence result;
+        return (int64_t)parseRMCSentence(s.c_str(), &result) + result.position.latitude;
+    }, ""};
+    Benchmark rmcPosition = {"parseRMCFields position", {}, [](const string& s) {
+        RMCSentence result;
+        return (int64_t)parseRMCSentenceFields(NMEASentenceView(s.c_str()), NMEA_RMC_POSITION, &result)
+            + result.position.latitude;
+    }, ""};
+    Benchmark gsv = {"parseGSVSentence", {}, [](const string& s) {
+        GSVSentence result;
+        return (int64_t)parseGSVSentence(s.c_str(), &result) + result.numSatInfos;
+    }, ""};
+    Benchmark rmcBaseline = {"iostream RMC baseline", {}, [](const string& s) {
+        ostringstream os;
+        printBaselineRMC(os, inputStruct<RMCSentence>(s));
+        return (int64_t)os.tellp();
+    }, ""};
+    Benchmark rmcStream = {"operator<<(RMCSentence)", {}, [](const string& s) {
+        ostringstream os;
+        os << inputStruct<RMCSentence>(s);
+        return (int64_t)os.tellp();
+    }, "iostream RMC baseline"};
+    Benchmark rmcText = {"formatRMCSentence text", {}, [](const string& s) {
+        char buf[NMEA_FORMAT_MAX_SIZE];
+        return (int64_t)formatRMCSentence(inputStruct<RMCSentence>(s), NMEAFormatText, buf, sizeof(buf));
+    }, "iostream RMC baseline"};
+    Benchmark rmcJSON = {"formatRMCSentence json", {}, [](const string& s) {
+        char buf[NMEA_FORMAT_MAX_SIZE];
+        return (int64_t)formatRMCSentence(inputStruct<RMCSentence>(s), NMEAFormatJSON, buf, sizeof(buf));
+    }, ""};
+    Benchmark rmcCSV = {"formatRMCSentence csv", {}, [](const string& s) {
+        char buf[NMEA_FORMAT_MAX_SIZE];
+        return (int64_t)formatRMCSentence(inputStruct<RMCSentence>(s), NMEAFormatCSV, buf, sizeof(buf));
+    }, ""};
+    Benchmark epoch = {"NMEAEpochConverter", {}, [](const string& s) {
+        //One receiver: consecutive fixes share the cached day and minute
+        static NMEAEpochConverter converter;
+        const RMCSentence& rmc = inputStruct<RMCSentence>(s);
+        return converter.toEpochNs(rmc.date, rmc.utcTime);
+    }, ""};
+    //Blocks of positions, e.g. a track
+    Benchmark degrees = {"positions to degrees", {}, [](const string& s) {
+        int32_t lat[BENCH_POSITION_BLOCK], lon[BENCH_POSITION_BLOCK];
+        size_t n = s.size() / sizeof(NMEAPosition);
+        convertNMEAPositionsToDegrees((const NMEAPosition*)s.data(), n, lat, lon);
+        return (int64_t)lat[0] + lon[n - 1];
+    }, ""};
+    Benchmark enu = {"positions to ENU", {}, [](const string& s) {
+        double east[BENCH_POSITION_BLOCK], north[BENCH_POSITION_BLOCK], up[BENCH_POSITION_BLOCK];
+        size_t n = s.size() / sizeof(NMEAPosition);
+        const NMEAPosition* positions = (const NMEAPosition*)s.data();
+        NMEALocalFrame frame(positions[0]);
+        frame.toENU(positions, NULL, n, east, north, up);
+        return (int64_t)(east[n - 1] + north[n - 1] + up[n - 1]);
+    }, ""};
+    /**
+     * Geofences around the start of the track, built on the first RMC
+     */
+    static NMEAGeofenceIndex fenceIndex;
+    Benchmark geofence = {"geofence query", {}, [](const string& s) {
+        uint32_t fences[16];
+        return (int64_t)fenceIndex.query(inputStruct<NMEAPosition>(s), fences, 16);
+    }, ""};
+    /**
+     * Positions within a dense cluster of fences around the start of the track
+     */
+    static NMEAGeofenceIndex clusteredIndex;
+    Benchmark clusteredGeofence = {"geofence query clustered", {}, [](const string& s) {
+        uint32_t fences[16];
+        return (int64_t)clusteredIndex.query(inputStruct<NMEAPosition>(s), fences, 16);
+    }, ""};
+    string positionBlock;
+    NMEAPosition clusterCenter = {};
+    for (size_t i = 0; i < sentences.size(); ++i) {
+        const string& s = sentences[i];
+        checksum.inputs.push_back(s);
+        if(types[i] == NMEASentenceRMC) {
+            rmc.inputs.push_back(s);
+            rmcPosition.inputs.push_back(s);
+            RMCSentence parsed;
+            if(parseRMCSentence(s.c_str(), &parsed) == 0) {
+                rmcBaseline.inputs.push_back(structInput(parsed));
+                if(fenceIndex.getNumFences() == 0) {
+                    buildBenchGeofences(&fenceIndex, parsed.position, false);
+                    buildBenchGeofences(&clusteredIndex, parsed.position, true);
+                    clusterCenter = parsed.position;
+                }
+                geofence.inputs.push_back(structInput(parsed.position));
+                positionBlock += structInput(parsed.position);
+                if(positionBlock.size() == BENCH_POSITION_BLOCK * sizeof(NMEAPosition)) {
+                    degrees.inputs.push_back(positionBlock);
+                    positionBlock.clear();
+                }
+            }
+            //Latitude field of RMC
+            NMEASentenceView view(s.c_str());
+            if(view.fieldSize(3) != 0) {
+                coordinate.inputs.push_back(string(view.field(3), view.fieldSize(3)));
+            }
+        } else if(types[i] == NMEASentenceGSV) {
+            gsv.inputs.push_back(s);
+        }
+    }
+    rmcStream.inputs = rmcText.inputs = rmcJSON.inputs = rmcCSV.inputs = epoch.inputs = rmcBaseline.inputs;
+    enu.inputs = degrees.inputs;
+    uint32_t random = 7;
+    for (size_t i = 0; i < geofence.inputs.size(); ++i) {
+        random = random * 1103515245 + 12345;
+        int32_t lat = nmeaCoordinateToDegrees(clusterCenter.latitude) + (int32_t)((random >> 8) % 120000) - 60000;
+        random = random * 1103515245 + 12345;
+        int32_t lon = nmeaCoordinateToDegrees(clusterCenter.longitude) + (int32_t)((random >> 8) % 120000) - 60000;
+        NMEAPosition position = {nmeaDegreesToCoordinate(lat), nmeaDegreesToCoordinate(lon)};
+        clusteredGeofence.inputs.push_back(structInput(position));
+    }
+    return {coordinate, checksum, rmc, rmcPosition, gsv, rmcBaseline, rmcStream, rmcText, rmcJSON, rmcCSV, epoch, degrees, enu, geofence, clusteredGeofence};
+}
+
+int main(int argc, char** argv) {
+    bool json = false;
+    size_t numSentences = 200000;
+    uint32_t seed = 1;
+    const char* filter = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if(strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if(strcmp(argv[i], "--sentences") == 0 && i + 1 < argc) {
+            numSentences = strtoul(argv[++i], NULL, 10);
+        } else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoul(argv[++i], NULL, 10);
+        } else if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--json] [--sentences N] [--seed S] [--filter name]\n", argv[0]);
+            return 1;
+        }
+    }
+    //Generate corpus
+    NMEACorpusGenerator generator(seed);
+    vector<string> sentences;
+    vector<NMEASentenceType> types;
+    char buf[128];
+    for (size_t i = 0; i < numSentences; ++i) {
+        NMEASentenceType type;
+        size_t size = generator.next(buf, sizeof(buf), &type);
+        sentences.push_back(string(buf, size));
+        types.push_back(type);
+    }
+    if(!json) {
+        printf("%-24s %10s %10s %10s %10s %14s %10s %12s %10s\n", "benchmark", "p50 [ns]", "p90 [ns]",
+            "p99 [ns]", "max [ns]", "calls/s", "MB/s", "cycles/byte", "speedup");
+    }
+    vector<Benchmark> benchmarks = buildBenchmarks(sentences, types);
+    //Baselines also run if only the benchmarks compared against them are selected
+    map<string, bool> selected;
+    for (const Benchmark& bench : benchmarks) {
+        if(filter == NULL || bench.name.find(filter) != string::npos) {
+            selected[bench.name] = true;
+            if(!bench.baseline.empty()) {
+                selected[bench.baseline] = true;
+            }
+        }
+    }
+    map<string, BenchmarkResult> results;
+    for (const Benchmark& bench : benchmarks) {
+        if(!selected[bench.name] || bench.inputs.empty()) {
+            continue;
+        }
+        BenchmarkResult r = runBenchmark(bench);
+        results[bench.name] = r;
+        //Ratio of the calls per second, 0 without a baseline
+        double speedup = 0;
+        if(!bench.baseline.empty() && results.count(bench.baseline)) {
+            speedup = r.callsPerSecond / results[bench.baseline].callsPerSecond;
+        }
+        if(json) {
+            printf("{\"benchmark\":\"%s\",\"seed\":%u,\"inputs\":%zu,\"p50_ns\":%.2f,\"p90_ns\":%.2f,"
+                   "\"p99_ns\":%.2f,\"max_ns\":%.2f,\"calls_per_s\":%.0f,\"bytes_per_s\":%.0f,\"cycles_per_byte\":%.3f",
+                bench.name.c_str(), seed, bench.inputs.size(), r.p50, r.p90, r.p99, r.max,
+                r.callsPerSecond, r.bytesPerSecond, r.cyclesPerByte);
+            if(speedup != 0) {
+                printf(",\"baseline\":\"%s\",\"speedup\":%.2f", bench.baseline.c_str(), speedup);
+            }
+            printf("}\n");
+        } else {
+            printf("%-24s %10.1f %10.1f %10.1f %10.1f %14.0f %10.1f %12.3f", bench.name.c_str(),
+                r.p50, r.p90, r.p99, r.max, r.callsPerSecond, r.bytesPerSecond / 1e6, r.cyclesPerByte);
+            if(speedup != 0) {
+                printf(" %9.1fx", speedup);
+            }
+            printf("\n");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include "NMEACorpus.h"
+#include "NMEA.h"
+
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+static const char* talkers[] = {"GP", "GN", "GL", "GA", "GB"};
+
+NMEACorpusGenerator::NMEACorpusGenerator(uint32_t seed, unsigned emptyFieldPercent, unsigned corruptChecksumPercent)
+    : state(seed * 0x9E3779B97F4A7C15ULL + 1), emptyFieldPercent(emptyFieldPercent),
+      corruptChecksumPercent(corruptChecksumPercent),
+      utcTime(0), date(10926), latitude(0), longitude(0), speed(0), course(0) {
+    //Start somewhere between 60°S..60°N
+    latitude = (int32_t)(random() % (120u * 60 * 100000)) - 60 * 60 * 100000;
+    longitude = (int32_t)(random() % (360u * 60 * 100000)) - 180 * 60 * 100000;
+    utcTime = random() % (24 * 3600 * 100);
+}
+
+uint32_t NMEACorpusGenerator::random() {
+    //xorshift64*
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return (uint32_t)((state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+void NMEACorpusGenerator::advance() {
+    //10 Hz, random walk
+    utcTime = (utcTime + 10) % (24 * 3600 * 100);
+    latitude += (int32_t)(random() % 201) - 100;
+    longitude += (int32_t)(random() % 201) - 100;
+    speed = random() % 30000;
+    course = random() % 360000;
+}
+
+/**
+ * Format a coordinate given in 1/1e5 minutes as [d]ddmm.mmmmm
+ */
+static int formatCoordinate(char* buf, size_t size, int32_t minutes1e5, int degreeDigits) {
+    uint32_t value = minutes1e5 < 0 ? -minutes1e5 : minutes1e5;
+    uint32_t degrees = value / (60 * 100000);
+    uint32_t minutes = value % (60 * 100000);
+    return snprintf(buf, size, "%0*u%02u.%05u", degreeDigits, degrees, minutes / 100000, minutes % 100000);
+}
+
+size_t NMEACorpusGenerator::next(char* buf, size_t size, NMEASentenceType* type) {
+    //Typical receiver output: More GSV than position sentences
+    uint32_t r = random() % 4;
+    NMEASentenceType t = r == 0 ? NMEASentenceRMC : (r == 1 ? NMEASentenceGLL : NMEASentenceGSV);
+    if(type != NULL) {
+        *type = t;
+    }
+    return next(t, buf, size);
+}
+
+size_t NMEACorpusGenerator::next(NMEASentenceType type, char* buf, size_t size) {
+    char sentence[128];
+    char lat[16] = "", lon[16] = "";
+    char time[16] = "";
+    const char* talker = talkers[random() % (sizeof(talkers) / sizeof(talkers[0]))];
+    int len;
+    if(type == NMEASentenceRMC || type == NMEASentenceGLL) {
+        advance();
+        if(!percent(emptyFieldPercent)) {
+            formatCoordinate(lat, sizeof(lat), latitude, 2);
+            formatCoordinate(lon, sizeof(lon), longitude, 3);
+        }
+        snprintf(time, sizeof(time), "%02d%02d%02d.%02d", utcTime / 360000,
+            (utcTime / 6000) % 60, (utcTime / 100) % 60, utcTime % 100);
+    }
+    const char* latDir = lat[0] ? (latitude < 0 ? "S" : "N") : "";
+    const char* lonDir = lon[0] ? (longitude < 0 ? "W" : "E") : "";
+    switch(type) {
+        case NMEASentenceRMC: {
+            char spd[16] = "", crs[16] = "";
+            if(!percent(emptyFieldPercent)) {
+                snprintf(spd, sizeof(spd), "%d.%03d", speed / 1000, speed % 1000);
+            }
+            if(!percent(emptyFieldPercent)) {
+                snprintf(crs, sizeof(crs), "%d.%02d", course / 1000, (course % 1000) / 10);
+            }
+            bool fix = lat[0] != '\0';
+            len = snprintf(sentence, sizeof(sentence), "$%sRMC,%s,%c,%s,%s,%s,%s,%s,%s,%06d,,,%c",
+                talker, time, fix ? 'A' : 'V', lat, latDir, lon, lonDir, spd, crs, date, fix ? 'A' : 'N');
+            break;
+        }
+        case NMEASentenceGLL: {
+            bool fix = lat[0] != '\0';
+            len = snprintf(sentence, sizeof(sentence), "$%sGLL,%s,%s,%s,%s,%s,%c,%c",
+                talker, lat, latDir, lon, lonDir, time, fix ? 'A' : 'V', fix ? 'A' : 'N');
+            break;
+        }
+        default: { //GSV
+            unsigned numSats = 1 + random() % 16;
+            unsigned numMsgs = (numSats + 3) / 4;
+            unsigned msgNum = 1 + random() % numMsgs;
+            unsigned satsInMsg = msgNum < numMsgs ? 4 : numSats - 4 * (numMsgs - 1);
+            len = snprintf(sentence, sizeof(sentence), "$%sGSV,%u,%u,%02u", talker, numMsgs, msgNum, numSats);
+            for (unsigned i = 0; i < satsInMsg; ++i) {
+                char snr[8] = "";
+                if(!percent(emptyFieldPercent * 10)) {
+                    snprintf(snr, sizeof(snr), "%02u", random() % 50);
+                }
+                //Separate statements, as the evaluation order of arguments is unspecified
+                unsigned id = 1 + random() % 32;
+                unsigned elevation = random() % 91;
+                unsigned azimuth = random() % 360;
+                len += snprintf(sentence + len, sizeof(sentence) - len, ",%02u,%02u,%03u,%s",
+                    id, elevation, azimuth, snr);
+            }
+        }
+    }
+    uint8_t checksum = computeNMEAChecksum(sentence, len + 1);
+    if(percent(corruptChecksumPercent)) {
+        checksum ^= 1 + random() % 255;
+    }
+    if((size_t)len + 6 > size) {
+        return 0;
+    }
+    memcpy(buf, sentence, len);
+    snprintf(buf + len, size - len, "*%02X\r\n", checksum);
+    return len + 5;
+}
+
+string NMEACorpusGenerator::generate(size_t numSentences) {
+    string corpus;
+    char buf[128];
+    for (size_t i = 0; i < numSentences; ++i) {
+        size_t size = next(buf, sizeof(buf));
+        corpus.append(buf, size);
+    }
+    return corpus;
+}
@@ -0,0 +1,58 @@
+#include "NMEADispatch.h"
+#include "NMEA.h"
+#include "NMEAStats.h"
+
+NMEASentenceType getNMEASentenceType(const char* sentence, size_t size) {
+    //$ + 2 talker characters + 3 formatter characters + ','
+    if(size < 7 || sentence[0] != '$' || sentence[1] == 'P'
+        || (sentence[6] != ',' && sentence[6] != '*')) {
+        return NMEASentenceUnknown;
+    }
+    switch(nmeaFormatterCode(sentence + 3)) {
+        case nmeaFormatterCode("GLL"): return NMEASentenceGLL;
+        case nmeaFormatterCode("RMC"): return NMEASentenceRMC;
+        case nmeaFormatterCode("GSV"): return NMEASentenceGSV;
+        case nmeaFormatterCode("GGA"): return NMEASentenceGGA;
+        case nmeaFormatterCode("GSA"): return NMEASentenceGSA;
+        case nmeaFormatterCode("VTG"): return NMEASentenceVTG;
+        case nmeaFormatterCode("ZDA"): return NMEASentenceZDA;
+        case nmeaFormatterCode("GST"): return NMEASentenceGST;
+        default: return NMEASentenceUnknown;
+    }
+}
+
+/**
+ * Parse a sentence of a known type
+ */
+static inline int parseNMEASentenceOfType(NMEASentenceType type, const char* sentence, size_t size, NMEAParsedSentence* result) {
+    NMEASentenceView view(sentence, size);
+    switch(type) {
+        case NMEASentenceGLL: return parseGLLSentence(view, &result->gll);
+        case NMEASentenceRMC: return parseRMCSentence(view, &result->rmc);
+        case NMEASentenceGSV: return parseGSVSentence(view, &result->gsv);
+        case NMEASentenceGGA: return parseGGASentence(view, &result->gga);
+        case NMEASentenceGSA: return parseGSASentence(view, &result->gsa);
+        case NMEASentenceVTG: return parseVTGSentence(view, &result->vtg);
+        case NMEASentenceZDA: return parseZDASentence(view, &result->zda);
+        case NMEASentenceGST: return parseGSTSentence(view, &result->gst);
+        default: return 1;
+    }
+}
+
+int dispatchNMEASentence(const char* sentence, size_t size, uint32_t enabledTypes, NMEAParsedSentence* result) {
+    NMEASentenceType type = getNMEASentenceType(sentence, size);
+    NMEA_STATS_SENTENCE(type);
+    if(type == NMEASentenceUnknown || !(enabledTypes & NMEA_TYPE_MASK(type))) {
+        return 1;
+    }
+    result->type = type;
+    result->talker[0] = sentence[1];
+    result->talker[1] = sentence[2];
+    NMEA_STATS_TIMER_START(start);
+    int rc = parseNMEASentenceOfType(type, sentence, size, result);
+    NMEA_STATS_TIMER_STOP(start);
+    if(rc < 0) {
+        NMEA_STATS_ERROR(type, rc);
+    }
+    return rc;
+}
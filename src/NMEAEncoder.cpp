@@ -0,0 +1,121 @@
+#include "NMEAEncoder.h"
+#include "NMEAWriter.h"
+
+/**
+ * Write a coordinate as (d)ddmm.mmmmm followed by the direction field
+ */
+static inline void putNMEACoordinate(NMEAWriter& w, int32_t value, int degreeDigits, char positive, char negative) {
+    if(value == INT32_MAX) {
+        w.put(',');
+        return;
+    }
+    w.putFixedPoint<5>(value < 0 ? -value : value, degreeDigits + 2);
+    w.put(',');
+    w.put(value < 0 ? negative : positive);
+}
+
+/**
+ * Start a sentence with $, talker and formatter
+ */
+static inline void beginNMEASentence(NMEAWriter& w, const char* talker, const char* formatter) {
+    *w.pos++ = '$';
+    w.put(talker[0]);
+    w.put(talker[1]);
+    w.put(formatter[0]);
+    w.put(formatter[1]);
+    w.put(formatter[2]);
+}
+
+/**
+ * Finish the sentence with *HH\r\n and a NUL terminator.
+ * @return The size of the sentence
+ */
+static inline size_t endNMEASentence(NMEAWriter& w, const char* buf) {
+    char* pos = w.pos;
+    pos[0] = '*';
+    pos[1] = nmeaHexDigits[w.checksum >> 4];
+    pos[2] = nmeaHexDigits[w.checksum & 0x0F];
+    pos[3] = '\r';
+    pos[4] = '\n';
+    pos[5] = '\0';
+    return pos + 5 - buf;
+}
+
+size_t encodeGLLSentence(const char* talker, const NMEAPosition& position, uint32_t utcTime, char* buf, size_t size) {
+    if(size < NMEA_ENCODER_MAX_SIZE) {
+        return 0;
+    }
+    bool valid = position.latitude != INT32_MAX && position.longitude != INT32_MAX;
+    NMEAWriter w = {buf, 0};
+    beginNMEASentence(w, talker, "GLL");
+    w.put(',');
+    putNMEACoordinate(w, position.latitude, 2, 'N', 'S');
+    w.put(',');
+    putNMEACoordinate(w, position.longitude, 3, 'E', 'W');
+    w.put(',');
+    w.putFixedPoint<2>((int32_t)utcTime, 6);
+    w.put(',');
+    w.put(valid ? 'A' : 'V');
+    w.put(',');
+    w.put(valid ? 'A' : 'N');
+    return endNMEASentence(w, buf);
+}
+
+size_t encodeRMCSentence(const char* talker, const RMCSentence& sentence, char* buf, size_t size) {
+    if(size < NMEA_ENCODER_MAX_SIZE) {
+        return 0;
+    }
+    NMEAWriter w = {buf, 0};
+    beginNMEASentence(w, talker, "RMC");
+    w.put(',');
+    w.putFixedPoint<2>((int32_t)sentence.utcTime, 6);
+    w.put(',');
+    w.putChar(sentence.status);
+    w.put(',');
+    putNMEACoordinate(w, sentence.position.latitude, 2, 'N', 'S');
+    w.put(',');
+    putNMEACoordinate(w, sentence.position.longitude, 3, 'E', 'W');
+    w.put(',');
+    w.putFixedPoint<3>(sentence.speed, 1);
+    w.put(',');
+    w.putFixedPoint<3>(sentence.course, 1);
+    w.put(',');
+    if(sentence.date != INT32_MAX) {
+        w.putUnsigned((uint32_t)sentence.date, 6);
+    }
+    //Empty magnetic variation
+    w.put(',');
+    w.put(',');
+    w.put(',');
+    w.putChar(sentence.posMode);
+    return endNMEASentence(w, buf);
+}
+
+size_t encodeGSVSentence(const char* talker, const GSVSentence& sentence, char* buf, size_t size) {
+    if(size < NMEA_ENCODER_MAX_SIZE) {
+        return 0;
+    }
+    NMEAWriter w = {buf, 0};
+    beginNMEASentence(w, talker, "GSV");
+    w.put(',');
+    w.putUnsigned(sentence.numMsgs, 1);
+    w.put(',');
+    w.putUnsigned(sentence.msgNum, 1);
+    w.put(',');
+    w.putUnsigned(sentence.numSats, 2);
+    for (int i = 0; i < sentence.numSatInfos && i < 4; ++i) {
+        const GSVSatInfo& sat = sentence.satellites[i];
+        w.put(',');
+        w.putUnsigned(sat.id, 2);
+        //Field order as parsed by parseGSVSentence()
+        w.put(',');
+        w.putUnsigned(sat.azimuth, 2);
+        w.put(',');
+        w.putUnsigned(sat.elevation, 3);
+        w.put(',');
+        if(sat.signal != UINT8_MAX) {
+            w.putUnsigned(sat.signal, 2);
+        }
+    }
+    return endNMEASentence(w, buf);
+}
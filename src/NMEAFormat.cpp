@@ -0,0 +1,366 @@
+#include "NMEAFormat.h"
+#include "NMEAWriter.h"
+#include "NMEAGeo.h"
+
+#define NMEA_DEGREE_SIGN "\xC2\xB0"
+
+/**
+ * Finish a record with a NUL terminator
+ * @return The size of the record
+ */
+static inline size_t endRecord(NMEAWriter& w, const char* buf) {
+    *w.pos = '\0';
+    return w.pos - buf;
+}
+
+/**
+ * Write the absolute value of a coordinate as xx°yy.zzzzz"
+ */
+static inline void putCoordinateText(NMEAWriter& w, int32_t coord) {
+    uint32_t value = coord < 0 ? 0u - (uint32_t)coord : (uint32_t)coord;
+    w.putUnsigned(value / 10000000);
+    w.putString(NMEA_DEGREE_SIGN);
+    value %= 10000000;
+    w.putUnsigned(value / 100000);
+    w.put('.');
+    w.putDigits(value % 100000, 5);
+    w.put('"');
+}
+
+/**
+ * Write a coordinate as decimal degrees with 7 decimals. The minutes are converted
+ * to degrees, so the value is rounded to 1e-7 degrees.
+ * Nothing is written for INT32_MAX.
+ */
+static inline void putCoordinateDecimal(NMEAWriter& w, int32_t coord) {
+    if(coord == INT32_MAX) {
+        return;
+    }
+    w.putFixedPoint<7>(nmeaCoordinateToDegrees(coord));
+}
+
+/**
+ * Write a date in ddmmyy format as ISO 8601 (20yy-mm-dd)
+ */
+static inline void putDate(NMEAWriter& w, int32_t date) {
+    w.put('2');
+    w.put('0');
+    w.putDigits(date % 100, 2);
+    w.put('-');
+    w.putDigits(date / 100 % 100, 2);
+    w.put('-');
+    w.putDigits(date / 10000 % 100, 2);
+}
+
+/**
+ * Write a time in hhmmss.ss format as hh:mm:ss.ss
+ */
+static inline void putTime(NMEAWriter& w, uint32_t time) {
+    w.putDigits(time / 1000000 % 100, 2);
+    w.put(':');
+    w.putDigits(time / 10000 % 100, 2);
+    w.put(':');
+    w.putDigits(time / 100 % 100, 2);
+    w.put('.');
+    w.putDigits(time % 100, 2);
+}
+
+/**
+ * Write a JSON member name including quotes and colon, preceded by a comma if not first
+ */
+static inline void putJSONKey(NMEAWriter& w, const char* key, bool first = false) {
+    if(!first) {
+        w.put(',');
+    }
+    w.put('"');
+    w.putString(key);
+    w.put('"');
+    w.put(':');
+}
+
+static inline void putJSONNull(NMEAWriter& w) {
+    w.putString("null");
+}
+
+/**
+ * Write a character as JSON string, or null if it is '\0' or would need escaping
+ */
+static inline void putJSONChar(NMEAWriter& w, char c) {
+    if(c == '\0' || c == '"' || c == '\\' || (unsigned char)c < 0x20) {
+        putJSONNull(w);
+        return;
+    }
+    w.put('"');
+    w.put(c);
+    w.put('"');
+}
+
+template<int Decimals>
+static inline void putJSONFixedPoint(NMEAWriter& w, int32_t value) {
+    if(value == INT32_MAX) {
+        putJSONNull(w);
+    } else {
+        w.putFixedPoint<Decimals>(value);
+    }
+}
+
+static inline void putJSONCoordinate(NMEAWriter& w, int32_t coord) {
+    if(coord == INT32_MAX) {
+        putJSONNull(w);
+    } else {
+        putCoordinateDecimal(w, coord);
+    }
+}
+
+static void putPositionText(NMEAWriter& w, const NMEAPosition& position) {
+    w.putString("NMEAPosition { ");
+    if(position.latitude == INT32_MAX) {
+        w.put('-');
+    } else {
+        putCoordinateText(w, position.latitude);
+        w.put(position.latitude < 0 ? 'S' : 'N');
+    }
+    w.put(' ');
+    if(position.longitude == INT32_MAX) {
+        w.put('-');
+    } else {
+        putCoordinateText(w, position.longitude);
+        w.put(position.longitude < 0 ? 'W' : 'E');
+    }
+    w.putString(" }");
+}
+
+static void putSatInfoText(NMEAWriter& w, const GSVSatInfo& sat) {
+    w.putString("Satellite { #");
+    w.putUnsigned(sat.id);
+    w.putString(", azimuth ");
+    w.putUnsigned(sat.azimuth);
+    w.putString(", elevation ");
+    w.putUnsigned(sat.elevation);
+    w.putString(", signal ");
+    w.putUnsigned(sat.signal);
+    w.putString(" }");
+}
+
+size_t formatNMEACoordinate(int32_t coord, char* buf) {
+    NMEAWriter w = {buf, 0};
+    putCoordinateText(w, coord);
+    return endRecord(w, buf);
+}
+
+size_t formatNMEAPosition(const NMEAPosition& position, NMEAFormatMode mode, char* buf, size_t size) {
+    if(size < NMEA_FORMAT_MAX_SIZE) {
+        return 0;
+    }
+    NMEAWriter w = {buf, 0};
+    switch(mode) {
+        case NMEAFormatText: {
+            putPositionText(w, position);
+            break;
+        }
+        case NMEAFormatJSON: {
+            w.putString("{\"type\":\"position\"");
+            putJSONKey(w, "latitude");
+            putJSONCoordinate(w, position.latitude);
+            putJSONKey(w, "longitude");
+            putJSONCoordinate(w, position.longitude);
+            w.putString("}\n");
+            break;
+        }
+        case NMEAFormatCSV: {
+            w.putString("position,");
+            putCoordinateDecimal(w, position.latitude);
+            w.put(',');
+            putCoordinateDecimal(w, position.longitude);
+            w.put('\n');
+            break;
+        }
+    }
+    return endRecord(w, buf);
+}
+
+size_t formatRMCSentence(const RMCSentence& m, NMEAFormatMode mode, char* buf, size_t size) {
+    if(size < NMEA_FORMAT_MAX_SIZE) {
+        return 0;
+    }
+    NMEAWriter w = {buf, 0};
+    switch(mode) {
+        case NMEAFormatText: {
+            w.putString("RMC { ");
+            if(m.date == INT32_MAX) {
+                w.put('-');
+            } else {
+                putDate(w, m.date);
+            }
+            w.put(' ');
+            if(m.utcTime == INT32_MAX) {
+                w.put('-');
+            } else {
+                putTime(w, m.utcTime);
+            }
+            w.putString(", ");
+            putPositionText(w, m.position);
+            w.putString(", ");
+            w.putChar(m.status);
+            w.put('/');
+            w.putChar(m.posMode);
+            w.putString(", ");
+            w.putFixedPoint<3>(m.speed);
+            w.putString(" kt, ");
+            w.putFixedPoint<3>(m.course);
+            w.putString(NMEA_DEGREE_SIGN " }");
+            break;
+        }
+        case NMEAFormatJSON: {
+            w.putString("{\"type\":\"RMC\"");
+            putJSONKey(w, "date");
+            if(m.date == INT32_MAX) {
+                putJSONNull(w);
+            } else {
+                w.put('"');
+                putDate(w, m.date);
+                w.put('"');
+            }
+            putJSONKey(w, "time");
+            if(m.utcTime == INT32_MAX) {
+                putJSONNull(w);
+            } else {
+                w.put('"');
+                putTime(w, m.utcTime);
+                w.put('"');
+            }
+            putJSONKey(w, "status");
+            putJSONChar(w, m.status);
+            putJSONKey(w, "latitude");
+            putJSONCoordinate(w, m.position.latitude);
+            putJSONKey(w, "longitude");
+            putJSONCoordinate(w, m.position.longitude);
+            putJSONKey(w, "speed");
+            putJSONFixedPoint<3>(w, m.speed);
+            putJSONKey(w, "course");
+            putJSONFixedPoint<3>(w, m.course);
+            putJSONKey(w, "posMode");
+            putJSONChar(w, m.posMode);
+            w.putString("}\n");
+            break;
+        }
+        case NMEAFormatCSV: {
+            w.putString("RMC,");
+            if(m.date != INT32_MAX) {
+                putDate(w, m.date);
+            }
+            w.put(',');
+            if(m.utcTime != INT32_MAX) {
+                putTime(w, m.utcTime);
+            }
+            w.put(',');
+            w.putChar(m.status);
+            w.put(',');
+            putCoordinateDecimal(w, m.position.latitude);
+            w.put(',');
+            putCoordinateDecimal(w, m.position.longitude);
+            w.put(',');
+            w.putFixedPoint<3>(m.speed);
+            w.put(',');
+            w.putFixedPoint<3>(m.course);
+            w.put(',');
+            w.putChar(m.posMode);
+            w.put('\n');
+            break;
+        }
+    }
+    return endRecord(w, buf);
+}
+
+size_t formatGSVSatInfo(const GSVSatInfo& sat, char* buf, size_t size) {
+    if(size < NMEA_FORMAT_MAX_SIZE) {
+        return 0;
+    }
+    NMEAWriter w = {buf, 0};
+    putSatInfoText(w, sat);
+    return endRecord(w, buf);
+}
+
+size_t formatGSVSentence(const GSVSentence& m, NMEAFormatMode mode, char* buf, size_t size) {
+    if(size < NMEA_FORMAT_MAX_SIZE) {
+        return 0;
+    }
+    NMEAWriter w = {buf, 0};
+    int numSatInfos = m.numSatInfos < 4 ? m.numSatInfos : 4;
+    switch(mode) {
+        case NMEAFormatText: {
+            w.putString("GSVSentence { #");
+            w.putUnsigned(m.msgNum);
+            w.putString(" of ");
+            w.putUnsigned(m.numMsgs);
+            w.putString(", ");
+            w.putUnsigned(m.numSats);
+            w.putString(" satellites in view: ");
+            for (int i = 0; i < numSatInfos; ++i) {
+                if(i != 0) {
+                    w.putString(", ");
+                }
+                putSatInfoText(w, m.satellites[i]);
+            }
+            w.putString(" }");
+            break;
+        }
+        case NMEAFormatJSON: {
+            w.putString("{\"type\":\"GSV\"");
+            putJSONKey(w, "numMsgs");
+            w.putUnsigned(m.numMsgs);
+            putJSONKey(w, "msgNum");
+            w.putUnsigned(m.msgNum);
+            putJSONKey(w, "numSats");
+            w.putUnsigned(m.numSats);
+            putJSONKey(w, "satellites");
+            w.put('[');
+            for (int i = 0; i < numSatInfos; ++i) {
+                const GSVSatInfo& sat = m.satellites[i];
+                if(i != 0) {
+                    w.put(',');
+                }
+                w.put('{');
+                putJSONKey(w, "id", true);
+                w.putUnsigned(sat.id);
+                putJSONKey(w, "azimuth");
+                w.putUnsigned(sat.azimuth);
+                putJSONKey(w, "elevation");
+                w.putUnsigned(sat.elevation);
+                putJSONKey(w, "signal");
+                if(sat.signal == UINT8_MAX) {
+                    putJSONNull(w);
+                } else {
+                    w.putUnsigned(sat.signal);
+                }
+                w.put('}');
+            }
+            w.putString("]}\n");
+            break;
+        }
+        case NMEAFormatCSV: {
+            w.putString("GSV,");
+            w.putUnsigned(m.numMsgs);
+            w.put(',');
+            w.putUnsigned(m.msgNum);
+            w.put(',');
+            w.putUnsigned(m.numSats);
+            for (int i = 0; i < numSatInfos; ++i) {
+                const GSVSatInfo& sat = m.satellites[i];
+                w.put(',');
+                w.putUnsigned(sat.id);
+                w.put(',');
+                w.putUnsigned(sat.azimuth);
+                w.put(',');
+                w.putUnsigned(sat.elevation);
+                w.put(',');
+                if(sat.signal != UINT8_MAX) {
+                    w.putUnsigned(sat.signal);
+                }
+            }
+            w.put('\n');
+            break;
+        }
+    }
+    return endRecord(w, buf);
+}
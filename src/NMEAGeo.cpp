@@ -0,0 +1,74 @@
+#include "NMEAGeo.h"
+
+#include <cmath>
+
+#define NMEA_WGS84_E2 (NMEA_WGS84_F * (2.0 - NMEA_WGS84_F))
+
+/**
+ * 1e-7 degrees to radians
+ */
+static const double degreesToRadians = M_PI / 180.0 / 1e7;
+
+void convertNMEAPositionsToDegrees(const NMEAPosition* positions, size_t count,
+    int32_t* latitudes, int32_t* longitudes) {
+    for (size_t i = 0; i < count; ++i) {
+        latitudes[i] = nmeaCoordinateToDegrees(positions[i].latitude);
+        longitudes[i] = nmeaCoordinateToDegrees(positions[i].longitude);
+    }
+}
+
+static inline double toRadians(int32_t coord) {
+    return coord == INT32_MAX ? NAN : nmeaCoordinateToDegrees(coord) * degreesToRadians;
+}
+
+void convertNMEAPositionsToRadians(const NMEAPosition* positions, size_t count,
+    double* latitudes, double* longitudes) {
+    for (size_t i = 0; i < count; ++i) {
+        latitudes[i] = toRadians(positions[i].latitude);
+        longitudes[i] = toRadians(positions[i].longitude);
+    }
+}
+
+/**
+ * Geodetic to ECEF for one position
+ */
+static inline void toECEF(const NMEAPosition& position, int32_t altitude, double* x, double* y, double* z) {
+    double lat = toRadians(position.latitude);
+    double lon = toRadians(position.longitude);
+    double h = altitude == INT32_MAX ? 0.0 : altitude * 1e-3;
+    double sinLat = sin(lat), cosLat = cos(lat);
+    //Radius of curvature in the prime vertical
+    double n = NMEA_WGS84_A / sqrt(1.0 - NMEA_WGS84_E2 * sinLat * sinLat);
+    *x = (n + h) * cosLat * cos(lon);
+    *y = (n + h) * cosLat * sin(lon);
+    *z = (n * (1.0 - NMEA_WGS84_E2) + h) * sinLat;
+}
+
+void convertNMEAPositionsToECEF(const NMEAPosition* positions, const int32_t* altitudes, size_t count,
+    double* x, double* y, double* z) {
+    for (size_t i = 0; i < count; ++i) {
+        toECEF(positions[i], altitudes != NULL ? altitudes[i] : 0, &x[i], &y[i], &z[i]);
+    }
+}
+
+NMEALocalFrame::NMEALocalFrame(const NMEAPosition& reference, int32_t altitude) {
+    toECEF(reference, altitude, &originX, &originY, &originZ);
+    double lat = toRadians(reference.latitude);
+    double lon = toRadians(reference.longitude);
+    sinLat = sin(lat);
+    cosLat = cos(lat);
+    sinLon = sin(lon);
+    cosLon = cos(lon);
+}
+
+void NMEALocalFrame::toENU(const NMEAPosition* positions, const int32_t* altitudes, size_t count,
+    double* east, double* north, double* up) const {
+    for (size_t i = 0; i < count; ++i) {
+        double x, y, z;
+        toECEF(positions[i], altitudes != NULL ? altitudes[i] : 0, &x, &y, &z);
+        double dx = x - originX, dy = y - originY, dz = z - originZ;
+        east[i] = -sinLon * dx + cosLon * dy;
+        north[i] = -sinLat * cosLon * dx - sinLat * sinLon * dy + cosLat * dz;
+        up[i] = cosLat * cosLon * dx + cosLat * sinLon * dy + sinLat * dz;
+    }
+}
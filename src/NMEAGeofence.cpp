@@ -0,0 +1,291 @@
+#include "NMEAGeofence.h"
+#include "NMEAGeo.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+/**
+ * Mean earth radius, see NMEATrackReducer
+ */
+#define GEOFENCE_EARTH_RADIUS 6371008.8
+
+/**
+ * Meters per 1e-7 degrees of latitude
+ */
+static const double metersPerDegreeLatitude = GEOFENCE_EARTH_RADIUS * M_PI / 180.0 / 1e7;
+
+NMEAGeofenceIndex::NMEAGeofenceIndex() : built(false) {
+}
+
+int NMEAGeofenceIndex::addFence(const Fence& fence) {
+    if((int64_t)fence.maxLatitude - fence.minLatitude > NMEA_GEOFENCE_MAX_EXTENT
+        || (int64_t)fence.maxLongitude - fence.minLongitude > NMEA_GEOFENCE_MAX_EXTENT) {
+        return -2;
+    }
+    fences.push_back(fence);
+    return (int)fences.size() - 1;
+}
+
+int NMEAGeofenceIndex::addPolygon(const NMEAPosition* polygon, size_t count) {
+    if(built) {
+        return -3;
+    }
+    if(count < 3) {
+        return -1;
+    }
+    Fence fence;
+    fence.type = FencePolygon;
+    fence.minLatitude = fence.minLongitude = INT32_MAX;
+    fence.maxLatitude = fence.maxLongitude = INT32_MIN;
+    fence.firstVertex = (uint32_t)vertices.size();
+    fence.numVertices = (uint32_t)count;
+    fence.centerLatitude = fence.centerLongitude = 0;
+    fence.radiusSquared = fence.metersPerDegreeLongitude = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if(polygon[i].latitude == INT32_MAX || polygon[i].longitude == INT32_MAX) {
+            vertices.resize(fence.firstVertex);
+            return -1;
+        }
+        Vertex v = {nmeaCoordinateToDegrees(polygon[i].latitude), nmeaCoordinateToDegrees(polygon[i].longitude)};
+        fence.minLatitude = v.latitude < fence.minLatitude ? v.latitude : fence.minLatitude;
+        fence.maxLatitude = v.latitude > fence.maxLatitude ? v.latitude : fence.maxLatitude;
+        fence.minLongitude = v.longitude < fence.minLongitude ? v.longitude : fence.minLongitude;
+        fence.maxLongitude = v.longitude > fence.maxLongitude ? v.longitude : fence.maxLongitude;
+        vertices.push_back(v);
+    }
+    int rc = addFence(fence);
+    if(rc < 0) {
+        vertices.resize(fence.firstVertex);
+    }
+    return rc;
+}
+
+int NMEAGeofenceIndex::addCircle(const NMEAPosition& center, double radiusMeters) {
+    if(built) {
+        return -3;
+    }
+    if(center.latitude == INT32_MAX || center.longitude == INT32_MAX || !(radiusMeters >= 0)) {
+        return -1;
+    }
+    Fence fence;
+    fence.type = FenceCircle;
+    fence.firstVertex = fence.numVertices = 0;
+    fence.centerLatitude = nmeaCoordinateToDegrees(center.latitude);
+    fence.centerLongitude = nmeaCoordinateToDegrees(center.longitude);
+    fence.radiusSquared = radiusMeters * radiusMeters;
+    fence.metersPerDegreeLongitude = metersPerDegreeLatitude * cos(fence.centerLatitude * (M_PI / 180.0 / 1e7));
+    double height = radiusMeters / metersPerDegreeLatitude + 1;
+    double width = fence.metersPerDegreeLongitude > 0 ? radiusMeters / fence.metersPerDegreeLongitude + 1 : 1e10;
+    if(height > NMEA_GEOFENCE_MAX_EXTENT || width > NMEA_GEOFENCE_MAX_EXTENT) {
+        return -2;
+    }
+    fence.minLatitude = (int32_t)(fence.centerLatitude - height);
+    fence.maxLatitude = (int32_t)(fence.centerLatitude + height);
+    fence.minLongitude = (int32_t)(fence.centerLongitude - width);
+    fence.maxLongitude = (int32_t)(fence.centerLongitude + width);
+    return addFence(fence);
+}
+
+bool NMEAGeofenceIndex::findCell(const Grid& grid, int32_t latitude, int32_t longitude, size_t* cell) {
+    if(latitude < grid.latitude || longitude < grid.longitude) {
+        return false;
+    }
+    int64_t row = ((int64_t)latitude - grid.latitude) / grid.cellHeight;
+    int64_t column = ((int64_t)longitude - grid.longitude) / grid.cellWidth;
+    if(row >= grid.rows || column >= grid.columns) {
+        return false;
+    }
+    *cell = grid.firstCell + (size_t)row * grid.columns + (size_t)column;
+    return true;
+}
+
+void NMEAGeofenceIndex::getCellRange(const Grid& grid, const Fence& fence,
+    uint32_t* row0, uint32_t* row1, uint32_t* column0, uint32_t* column1) {
+    int64_t r0 = ((int64_t)fence.minLatitude - grid.latitude) / grid.cellHeight;
+    int64_t r1 = ((int64_t)fence.maxLatitude - grid.latitude) / grid.cellHeight;
+    int64_t c0 = ((int64_t)fence.minLongitude - grid.longitude) / grid.cellWidth;
+    int64_t c1 = ((int64_t)fence.maxLongitude - grid.longitude) / grid.cellWidth;
+    //Truncation rounds towards zero, so negative offsets clip to 0 as well
+    *row0 = r0 < 0 ? 0 : (uint32_t)r0;
+    *row1 = r1 < (int64_t)grid.rows ? (uint32_t)r1 : grid.rows - 1;
+    *column0 = c0 < 0 ? 0 : (uint32_t)c0;
+    *column1 = c1 < (int64_t)grid.columns ? (uint32_t)c1 : grid.columns - 1;
+}
+
+int NMEAGeofenceIndex::build() {
+    if(fences.empty()) {
+        return -1;
+    }
+    //Bounding box of all fences
+    int64_t minLatitude = INT32_MAX, maxLatitude = INT32_MIN;
+    int64_t minLongitude = INT32_MAX, maxLongitude = INT32_MIN;
+    for (size_t i = 0; i < fences.size(); ++i) {
+        const Fence& f = fences[i];
+        minLatitude = f.minLatitude < minLatitude ? f.minLatitude : minLatitude;
+        maxLatitude = f.maxLatitude > maxLatitude ? f.maxLatitude : maxLatitude;
+        minLongitude = f.minLongitude < minLongitude ? f.minLongitude : minLongitude;
+        maxLongitude = f.maxLongitude > maxLongitude ? f.maxLongitude : maxLongitude;
+    }
+    //Roughly square cells (in degrees), NMEA_GEOFENCE_CELLS_PER_FENCE per fence
+    double height = (double)(maxLatitude - minLatitude + 1);
+    double width = (double)(maxLongitude - minLongitude + 1);
+    double cells = (double)fences.size() * NMEA_GEOFENCE_CELLS_PER_FENCE;
+    cells = cells < NMEA_GEOFENCE_MAX_CELLS ? cells : NMEA_GEOFENCE_MAX_CELLS;
+    double cellSize = sqrt(height * width / cells);
+    Grid top;
+    top.rows = (uint32_t)ceil(height / cellSize);
+    top.columns = (uint32_t)ceil(width / cellSize);
+    top.rows = top.rows < 1 ? 1 : top.rows;
+    top.columns = top.columns < 1 ? 1 : top.columns;
+    top.cellHeight = (uint32_t)((maxLatitude - minLatitude) / top.rows + 1);
+    top.cellWidth = (uint32_t)((maxLongitude - minLongitude) / top.columns + 1);
+    top.latitude = (int32_t)minLatitude;
+    top.longitude = (int32_t)minLongitude;
+    top.firstCell = 0;
+    grids.assign(1, top);
+    //Fence lists of all cells (in ascending fence order), the cells of subdivisions are appended
+    vector<vector<uint32_t> > lists((size_t)top.rows * top.columns);
+    for (uint32_t id = 0; id < fences.size(); ++id) {
+        uint32_t row0, row1, column0, column1;
+        getCellRange(top, fences[id], &row0, &row1, &column0, &column1);
+        for (uint32_t row = row0; row <= row1; ++row) {
+            for (uint32_t column = column0; column <= column1; ++column) {
+                lists[(size_t)row * top.columns + column].push_back(id);
+            }
+        }
+    }
+    size_t numCells = lists.size();
+    cellGrid.assign(numCells, 0);
+    for (size_t cell = 0; cell < numCells; ++cell) {
+        size_t n = lists[cell].size();
+        if(n <= NMEA_GEOFENCE_MAX_CELL_FENCES) {
+            continue;
+        }
+        uint32_t size = (uint32_t)ceil(sqrt((double)n * NMEA_GEOFENCE_CELLS_PER_FENCE));
+        size = size < NMEA_GEOFENCE_MAX_SUBDIVISION ? size : NMEA_GEOFENCE_MAX_SUBDIVISION;
+        if(lists.size() + (size_t)size * size > NMEA_GEOFENCE_MAX_CELLS) {
+            continue;
+        }
+        Grid sub;
+        sub.latitude = (int32_t)(top.latitude + (int64_t)(cell / top.columns) * top.cellHeight);
+        sub.longitude = (int32_t)(top.longitude + (int64_t)(cell % top.columns) * top.cellWidth);
+        sub.cellHeight = (top.cellHeight - 1) / size + 1;
+        sub.cellWidth = (top.cellWidth - 1) / size + 1;
+        sub.rows = sub.columns = size;
+        sub.firstCell = (uint32_t)lists.size();
+        vector<vector<uint32_t> > subLists((size_t)size * size);
+        size_t entries = 0;
+        for (uint32_t id : lists[cell]) {
+            uint32_t row0, row1, column0, column1;
+            getCellRange(sub, fences[id], &row0, &row1, &column0, &column1);
+            for (uint32_t row = row0; row <= row1; ++row) {
+                for (uint32_t column = column0; column <= column1; ++column) {
+                    subLists[(size_t)row * size + column].push_back(id);
+                }
+            }
+            entries += (size_t)(row1 - row0 + 1) * (column1 - column0 + 1);
+        }
+        //Not worth it if most fences cover most of the cell anyway
+        if(entries * 2 > n * subLists.size()) {
+            continue;
+        }
+        cellGrid[cell] = (uint32_t)grids.size();
+        grids.push_back(sub);
+        lists[cell].clear();
+        for (size_t i = 0; i < subLists.size(); ++i) {
+            lists.push_back(std::move(subLists[i]));
+        }
+    }
+    cellStart.assign(lists.size() + 1, 0);
+    for (size_t cell = 0; cell < lists.size(); ++cell) {
+        cellStart[cell + 1] = cellStart[cell] + (uint32_t)lists[cell].size();
+    }
+    cellFences.resize(cellStart.back());
+    for (size_t cell = 0; cell < lists.size(); ++cell) {
+        std::copy(lists[cell].begin(), lists[cell].end(), cellFences.begin() + cellStart[cell]);
+    }
+    built = true;
+    return 0;
+}
+
+bool NMEAGeofenceIndex::containsDegrees(const Fence& fence, int32_t latitude, int32_t longitude) const {
+    if(latitude < fence.minLatitude || latitude > fence.maxLatitude
+        || longitude < fence.minLongitude || longitude > fence.maxLongitude) {
+        return false;
+    }
+    if(fence.type == FenceCircle) {
+        double dx = ((int64_t)longitude - fence.centerLongitude) * fence.metersPerDegreeLongitude;
+        double dy = ((int64_t)latitude - fence.centerLatitude) * metersPerDegreeLatitude;
+        return dx * dx + dy * dy <= fence.radiusSquared;
+    }
+    //Crossing number. The bounding box check keeps all differences below NMEA_GEOFENCE_MAX_EXTENT.
+    const Vertex* v = &vertices[fence.firstVertex];
+    bool inside = false;
+    for (uint32_t i = 0, j = fence.numVertices - 1; i < fence.numVertices; j = i++) {
+        const Vertex& a = v[j];
+        const Vertex& b = v[i];
+        if((a.latitude > latitude) != (b.latitude > latitude)) {
+            //Is the position west of the edge at its latitude?
+            int64_t cross = (int64_t)(b.longitude - a.longitude) * (latitude - a.latitude)
+                - (int64_t)(longitude - a.longitude) * (b.latitude - a.latitude);
+            if((cross > 0) == (b.latitude > a.latitude)) {
+                inside = !inside;
+            }
+        }
+    }
+    return inside;
+}
+
+size_t NMEAGeofenceIndex::queryDegrees(int32_t latitude, int32_t longitude, uint32_t* result, size_t maxFences) const {
+    size_t cell;
+    if(!built || !findCell(grids[0], latitude, longitude, &cell)) {
+        return 0;
+    }
+    if(cellGrid[cell] != 0 && !findCell(grids[cellGrid[cell]], latitude, longitude, &cell)) {
+        return 0;
+    }
+    size_t n = 0;
+    for (uint32_t k = cellStart[cell]; k < cellStart[cell + 1]; ++k) {
+        uint32_t id = cellFences[k];
+        if(containsDegrees(fences[id], latitude, longitude)) {
+            if(n < maxFences) {
+                result[n] = id;
+            }
+            n++;
+        }
+    }
+    return n;
+}
+
+size_t NMEAGeofenceIndex::query(const NMEAPosition& position, uint32_t* result, size_t maxFences) const {
+    if(position.latitude == INT32_MAX || position.longitude == INT32_MAX) {
+        return 0;
+    }
+    return queryDegrees(nmeaCoordinateToDegrees(position.latitude),
+        nmeaCoordinateToDegrees(position.longitude), result, maxFences);
+}
+
+size_t NMEAGeofenceIndex::query(const int32_t* latitudes, const int32_t* longitudes, size_t count,
+    uint32_t* offsets, uint32_t* result, size_t maxFences) const {
+    offsets[0] = 0;
+    for (size_t i = 0; i < count; ++i) {
+        NMEAPosition position = {latitudes[i], longitudes[i]};
+        size_t used = offsets[i];
+        size_t n = query(position, result + used, maxFences - used);
+        if(n > maxFences - used) {
+            return i;
+        }
+        offsets[i + 1] = (uint32_t)(used + n);
+    }
+    return count;
+}
+
+bool NMEAGeofenceIndex::contains(uint32_t fence, const NMEAPosition& position) const {
+    if(fence >= fences.size() || position.latitude == INT32_MAX || position.longitude == INT32_MAX) {
+        return false;
+    }
+    return containsDegrees(fences[fence], nmeaCoordinateToDegrees(position.latitude),
+        nmeaCoordinateToDegrees(position.longitude));
+}
@@ -0,0 +1,356 @@
+#include "NMEAIndex.h"
+
+#include <atomic>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NMEA_INDEX_X86
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__)
+#define NMEA_INDEX_NEON
+#include <arm_neon.h>
+#endif
+
+/**
+ * Stage 1 of the indexer: Find all structural characters.
+ * Writes at most maxOut offsets to out.
+ * @param processed Set to the number of bytes that have been scanned completely
+ * @return The number of offsets written to out
+ */
+typedef size_t (*FindStructuralsFn)(const char* buf, size_t size, uint32_t* out, size_t maxOut, size_t* processed);
+/**
+ * XOR of all bytes in the given range
+ */
+typedef uint8_t (*XorRangeFn)(const char* buf, size_t size);
+
+static inline bool isNMEAStructural(char c) {
+    return c == '$' || c == ',' || c == '*' || c == '\n';
+}
+
+/**
+ * Append the offsets of all set bits in mask to out
+ */
+static inline size_t flattenBitmap(uint64_t mask, uint32_t base, uint32_t* out) {
+    size_t n = 0;
+    while(mask) {
+        out[n++] = base + __builtin_ctzll(mask);
+        mask &= mask - 1;
+    }
+    return n;
+}
+
+static inline uint8_t foldXor64(uint64_t x) {
+    x ^= x >> 32;
+    x ^= x >> 16;
+    x ^= x >> 8;
+    return (uint8_t)x;
+}
+
+/**
+ * Scalar stage 1, starting at offset start. Also used for the tail of the SIMD implementations.
+ */
+static size_t findStructuralsScalarFrom(const char* buf, size_t size, size_t start,
+                                        uint32_t* out, size_t n, size_t maxOut, size_t* processed) {
+    size_t i = start;
+    for(; i < size; i++) {
+        if(isNMEAStructural(buf[i])) {
+            if(n == maxOut) {
+                break;
+            }
+            out[n++] = (uint32_t)i;
+        }
+    }
+    *processed = i;
+    return n;
+}
+
+static size_t findStructuralsScalar(const char* buf, size_t size, uint32_t* out, size_t maxOut, size_t* processed) {
+    return findStructuralsScalarFrom(buf, size, 0, out, 0, maxOut, processed);
+}
+
+static uint8_t xorRangeScalar(const char* buf, size_t size) {
+    uint64_t acc = 0;
+    size_t i = 0;
+    for(; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, buf + i, 8);
+        acc ^= word;
+    }
+    uint8_t checksum = foldXor64(acc);
+    for(; i < size; i++) {
+        checksum ^= buf[i];
+    }
+    return checksum;
+}
+
+#ifdef NMEA_INDEX_X86
+__attribute__((target("sse2")))
+static inline uint16_t structuralMaskSSE2(const char* p) {
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+    __m128i m = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('$')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))),
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('*')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+    return (uint16_t)_mm_movemask_epi8(m);
+}
+
+__attribute__((target("sse2")))
+static size_t findStructuralsSSE2(const char* buf, size_t size, uint32_t* out, size_t maxOut, size_t* processed) {
+    size_t n = 0, i = 0;
+    for(; i + 64 <= size && maxOut - n >= 64; i += 64) {
+        uint64_t mask = (uint64_t)structuralMaskSSE2(buf + i)
+                      | ((uint64_t)structuralMaskSSE2(buf + i + 16) << 16)
+                      | ((uint64_t)structuralMaskSSE2(buf + i + 32) << 32)
+                      | ((uint64_t)structuralMaskSSE2(buf + i + 48) << 48);
+        n += flattenBitmap(mask, (uint32_t)i, out + n);
+    }
+    return findStructuralsScalarFrom(buf, size, i, out, n, maxOut, processed);
+}
+
+__attribute__((target("sse2")))
+static uint8_t xorRangeSSE2(const char* buf, size_t size) {
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for(; i + 16 <= size; i += 16) {
+        acc = _mm_xor_si128(acc, _mm_loadu_si128((const __m128i*)(buf + i)));
+    }
+    uint64_t halves[2];
+    _mm_storeu_si128((__m128i*)halves, acc);
+    return foldXor64(halves[0] ^ halves[1]) ^ xorRangeScalar(buf + i, size - i);
+}
+
+__attribute__((target("avx2")))
+static inline uint32_t structuralMaskAVX2(const char* p) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)p);
+    __m256i m = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('$')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('*')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+    return (uint32_t)_mm256_movemask_epi8(m);
+}
+
+__attribute__((target("avx2")))
+static size_t findStructuralsAVX2(const char* buf, size_t size, uint32_t* out, size_t maxOut, size_t* processed) {
+    size_t n = 0, i = 0;
+    for(; i + 64 <= size && maxOut - n >= 64; i += 64) {
+        uint64_t mask = (uint64_t)structuralMaskAVX2(buf + i)
+                      | ((uint64_t)structuralMaskAVX2(buf + i + 32) << 32);
+        n += flattenBitmap(mask, (uint32_t)i, out + n);
+    }
+    return findStructuralsScalarFrom(buf, size, i, out, n, maxOut, processed);
+}
+
+__attribute__((target("avx2")))
+static uint8_t xorRangeAVX2(const char* buf, size_t size) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for(; i + 32 <= size; i += 32) {
+        acc = _mm256_xor_si256(acc, _mm256_loadu_si256((const __m256i*)(buf + i)));
+    }
+    uint64_t quarters[4];
+    _mm256_storeu_si256((__m256i*)quarters, acc);
+    return foldXor64(quarters[0] ^ quarters[1] ^ quarters[2] ^ quarters[3])
+         ^ xorRangeScalar(buf + i, size - i);
+}
+#endif //NMEA_INDEX_X86
+
+#ifdef NMEA_INDEX_NEON
+static inline uint16_t structuralMaskNEON(const char* p) {
+    static const uint8_t bitWeights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t v = vld1q_u8((const uint8_t*)p);
+    uint8x16_t m = vorrq_u8(
+        vorrq_u8(vceqq_u8(v, vdupq_n_u8('$')), vceqq_u8(v, vdupq_n_u8(','))),
+        vorrq_u8(vceqq_u8(v, vdupq_n_u8('*')), vceqq_u8(v, vdupq_n_u8('\n'))));
+    m = vandq_u8(m, vld1q_u8(bitWeights));
+    return (uint16_t)(vaddv_u8(vget_low_u8(m)) | (vaddv_u8(vget_high_u8(m)) << 8));
+}
+
+static size_t findStructuralsNEON(const char* buf, size_t size, uint32_t* out, size_t maxOut, size_t* processed) {
+    size_t n = 0, i = 0;
+    for(; i + 64 <= size && maxOut - n >= 64; i += 64) {
+        uint64_t mask = (uint64_t)structuralMaskNEON(buf + i)
+                      | ((uint64_t)structuralMaskNEON(buf + i + 16) << 16)
+                      | ((uint64_t)structuralMaskNEON(buf + i + 32) << 32)
+                      | ((uint64_t)structuralMaskNEON(buf + i + 48) << 48);
+        n += flattenBitmap(mask, (uint32_t)i, out + n);
+    }
+    return findStructuralsScalarFrom(buf, size, i, out, n, maxOut, processed);
+}
+
+static uint8_t xorRangeNEON(const char* buf, size_t size) {
+    uint8x16_t acc = vdupq_n_u8(0);
+    size_t i = 0;
+    for(; i + 16 <= size; i += 16) {
+        acc = veorq_u8(acc, vld1q_u8((const uint8_t*)(buf + i)));
+    }
+    uint64x2_t acc64 = vreinterpretq_u64_u8(acc);
+    return foldXor64(vgetq_lane_u64(acc64, 0) ^ vgetq_lane_u64(acc64, 1))
+         ^ xorRangeScalar(buf + i, size - i);
+}
+#endif //NMEA_INDEX_NEON
+
+bool isNMEAIndexImplementationSupported(NMEAIndexImplementation impl) {
+    switch(impl) {
+        case NMEAIndexScalar: return true;
+#ifdef NMEA_INDEX_X86
+        case NMEAIndexSSE2: return __builtin_cpu_supports("sse2");
+        case NMEAIndexAVX2: return __builtin_cpu_supports("avx2");
+#endif
+#ifdef NMEA_INDEX_NEON
+        case NMEAIndexNEON: return true;
+#endif
+        default: return false;
+    }
+}
+
+static NMEAIndexImplementation detectNMEAIndexImplementation() {
+    static const NMEAIndexImplementation preferred[] = {
+        NMEAIndexAVX2, NMEAIndexNEON, NMEAIndexSSE2
+    };
+    for (size_t i = 0; i < sizeof(preferred) / sizeof(preferred[0]); ++i) {
+        if(isNMEAIndexImplementationSupported(preferred[i])) {
+            return preferred[i];
+        }
+    }
+    return NMEAIndexScalar;
+}
+
+/**
+ * The dispatch pointers may be switched while other threads are indexing.
+ * Every combination of implementations gives the same results, so relaxed
+ * loads and stores suffice.
+ */
+static std::atomic<NMEAIndexImplementation> currentImplementation(detectNMEAIndexImplementation());
+static std::atomic<FindStructuralsFn> findStructurals(findStructuralsScalar);
+static std::atomic<XorRangeFn> xorRange(xorRangeScalar);
+
+static void setNMEAIndexFunctions(FindStructuralsFn find, XorRangeFn xorFn) {
+    findStructurals.store(find, std::memory_order_relaxed);
+    xorRange.store(xorFn, std::memory_order_relaxed);
+}
+
+int setNMEAIndexImplementation(NMEAIndexImplementation impl) {
+    if(!isNMEAIndexImplementationSupported(impl)) {
+        return -1;
+    }
+    switch(impl) {
+#ifdef NMEA_INDEX_X86
+        case NMEAIndexSSE2: {
+            setNMEAIndexFunctions(findStructuralsSSE2, xorRangeSSE2);
+            break;
+        }
+        case NMEAIndexAVX2: {
+            setNMEAIndexFunctions(findStructuralsAVX2, xorRangeAVX2);
+            break;
+        }
+#endif
+#ifdef NMEA_INDEX_NEON
+        case NMEAIndexNEON: {
+            setNMEAIndexFunctions(findStructuralsNEON, xorRangeNEON);
+            break;
+        }
+#endif
+        default: {
+            setNMEAIndexFunctions(findStructuralsScalar, xorRangeScalar);
+        }
+    }
+    currentImplementation.store(impl, std::memory_order_relaxed);
+    return 0;
+}
+
+NMEAIndexImplementation getNMEAIndexImplementation() {
+    return currentImplementation.load(std::memory_order_relaxed);
+}
+
+/**
+ * Selects the implementation detected at startup.
+ */
+static int nmeaIndexDispatchInitialized = setNMEAIndexImplementation(getNMEAIndexImplementation());
+
+size_t indexNMEABuffer(const char* buf, size_t size, NMEAStructuralIndex* index) {
+    (void)nmeaIndexDispatchInitialized;
+    size_t processed;
+    uint32_t* structurals = index->structurals;
+    //Stage 1: Raw structural offsets
+    size_t numRaw = findStructurals.load(std::memory_order_relaxed)(buf, size, structurals, index->maxStructurals, &processed);
+    XorRangeFn xorFn = xorRange.load(std::memory_order_relaxed);
+    /**
+     * Stage 2: Build sentence records. Compacts the structurals array in place,
+     * dropping structurals that are not part of a complete sentence.
+     */
+    size_t numOut = 0, numSentences = 0, consumed = 0;
+    size_t sentenceFirst = 0;
+    size_t sentenceRaw = 0; //Index of the '$' in the raw structurals
+    uint32_t checksumPos = UINT32_MAX;
+    bool inSentence = false, sentencesFull = false;
+    for (size_t r = 0; r < numRaw; ++r) {
+        uint32_t offset = structurals[r];
+        char c = buf[offset];
+        if(c == '$') {
+            //Also discards any incomplete sentence
+            sentenceFirst = numOut;
+            sentenceRaw = r;
+            checksumPos = UINT32_MAX;
+            inSentence = true;
+        } else if(!inSentence) {
+            continue;
+        }
+        structurals[numOut++] = offset;
+        if(c == '*' && checksumPos == UINT32_MAX) {
+            checksumPos = offset;
+        } else if(c == '\n') {
+            inSentence = false;
+            if(numOut - sentenceFirst > UINT16_MAX) { //Not a sensible sentence
+                numOut = sentenceFirst;
+                continue;
+            }
+            if(numSentences == index->maxSentences) {
+                numOut = sentenceFirst;
+                sentencesFull = true;
+                break;
+            }
+            NMEASentenceRecord* record = &index->sentences[numSentences++];
+            record->start = structurals[sentenceFirst];
+            record->end = offset;
+            record->checksumPos = checksumPos;
+            record->firstStructural = (uint32_t)sentenceFirst;
+            record->numStructurals = (uint16_t)(numOut - sentenceFirst);
+            record->checksum = checksumPos == UINT32_MAX ? 0 :
+                xorFn(buf + record->start + 1, checksumPos - record->start - 1);
+            consumed = offset + 1;
+        }
+    }
+    if(sentencesFull) {
+        //Stopped after the last sentence that fit
+    } else if(!inSentence) {
+        //Everything scanned is either indexed or outside of sentences
+        consumed = processed;
+    } else if(numSentences != 0 || processed == size || sentenceRaw != 0) {
+        //Incomplete sentence at the end of the buffer or of the structurals array
+        //(e.g. after garbage that used up the array), it is indexed by the next call
+        consumed = structurals[sentenceFirst];
+        numOut = sentenceFirst;
+    } else {
+        //The sentence starts at the first structural and has more structurals than fit in the array.
+        //Skip it, its remaining bytes up to the next '$' are ignored anyway.
+        const char* next = (const char*)memchr(buf + processed, '$', size - processed);
+        consumed = next ? next - buf : size;
+        numOut = sentenceFirst;
+    }
+    index->numStructurals = numOut;
+    index->numSentences = numSentences;
+    return consumed;
+}
+
+uint32_t getNMEAFieldOffset(const NMEAStructuralIndex* index, const NMEASentenceRecord* sentence, unsigned field) {
+    //Field n starts after the n-th structural of the sentence ('$' for field 0).
+    //The last structural is the '\n' which does not start a field.
+    if(field + 1 >= sentence->numStructurals) {
+        return UINT32_MAX;
+    }
+    uint32_t delimiterPos = index->structurals[sentence->firstStructural + field];
+    //Anything after the '*' is the checksum, not a field
+    if(sentence->checksumPos != UINT32_MAX && delimiterPos >= sentence->checksumPos) {
+        return UINT32_MAX;
+    }
+    return delimiterPos + 1;
+}
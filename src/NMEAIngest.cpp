@@ -0,0 +1,148 @@
+#include "NMEAIngest.h"
+
+#include <ctime>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+using namespace std;
+
+uint64_t getNMEAMonotonicTime() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+NMEAIngestLoop::NMEAIngestLoop() : epollFd(-1) {
+}
+
+NMEAIngestLoop::~NMEAIngestLoop() {
+    close();
+}
+
+int NMEAIngestLoop::open() {
+    close();
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if(epollFd < 0) {
+        return -1;
+    }
+    buffer.resize(NMEA_INGEST_READ_SIZE);
+    readySources.resize(NMEA_INGEST_MAX_EVENTS);
+    return 0;
+}
+
+void NMEAIngestLoop::close() {
+    for (auto& entry : sources) {
+        delete entry.second;
+    }
+    sources.clear();
+    releaseRemoved();
+    if(epollFd >= 0) {
+        ::close(epollFd);
+    }
+    epollFd = -1;
+}
+
+int NMEAIngestLoop::addSource(int fd, uint32_t sourceId, NMEASourceType type) {
+    if(epollFd < 0) {
+        return -1;
+    }
+    if(sources.count(sourceId) != 0) {
+        return -2;
+    }
+    int flags = fcntl(fd, F_GETFL);
+    if(flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        return -1;
+    }
+    Source* source = new Source();
+    source->fd = fd;
+    source->id = sourceId;
+    source->type = type;
+    source->removed = false;
+    source->bytes = 0;
+    source->reads = 0;
+    source->sentences = 0;
+    //Level-triggered: data left after a read is reported by the next poll()
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = source;
+    if(epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        delete source;
+        return -1;
+    }
+    sources[sourceId] = source;
+    return 0;
+}
+
+int NMEAIngestLoop::removeSource(uint32_t sourceId) {
+    auto it = sources.find(sourceId);
+    if(it == sources.end()) {
+        return -1;
+    }
+    Source* source = it->second;
+    //May fail if the fd has already been closed, which unregisters it anyway
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, source->fd, NULL);
+    source->removed = true;
+    removedSources.push_back(source);
+    sources.erase(it);
+    return 0;
+}
+
+int NMEAIngestLoop::getSourceStats(uint32_t sourceId, NMEASourceStats* stats) const {
+    auto it = sources.find(sourceId);
+    if(it == sources.end()) {
+        return -1;
+    }
+    const Source* source = it->second;
+    stats->bytes = source->bytes;
+    stats->reads = source->reads;
+    stats->sentences = source->sentences;
+    stats->droppedBytes = source->framer.getDroppedBytes();
+    return 0;
+}
+
+int NMEAIngestLoop::wait(int timeoutMs) {
+    if(epollFd < 0) {
+        return -1;
+    }
+    struct epoll_event events[NMEA_INGEST_MAX_EVENTS];
+    int n;
+    do {
+        n = epoll_wait(epollFd, events, NMEA_INGEST_MAX_EVENTS, timeoutMs);
+    } while(n < 0 && errno == EINTR);
+    for (int i = 0; i < n; ++i) {
+        readySources[i] = events[i].data.ptr;
+    }
+    return n;
+}
+
+ssize_t NMEAIngestLoop::readSource(Source* source) {
+    ssize_t n;
+    do {
+        n = read(source->fd, buffer.data(), buffer.size());
+    } while(n < 0 && errno == EINTR);
+    if(n > 0) {
+        source->bytes += n;
+        source->reads++;
+        return n;
+    }
+    if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return 0;
+    }
+    //A zero-length datagram is not the end of the source
+    if(n == 0 && source->type == NMEASourceDatagram) {
+        return 0;
+    }
+    if(n == 0) {
+        errno = 0;
+    }
+    return -1;
+}
+
+void NMEAIngestLoop::releaseRemoved() {
+    for (Source* source : removedSources) {
+        delete source;
+    }
+    removedSources.clear();
+}
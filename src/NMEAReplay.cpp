@@ -0,0 +1,186 @@
+#include "NMEAReplay.h"
+#include "NMEA.h"
+#include "NMEADispatch.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/**
+ * Parsed results of a single chunk
+ */
+struct ReplayChunk {
+    vector<NMEAReplayRecord> records;
+    uint64_t sentences;
+    uint64_t parseErrors;
+    bool done;
+};
+
+#define REPLAY_SENTENCE_TYPES (NMEA_TYPE_MASK(NMEASentenceGLL) \
+    | NMEA_TYPE_MASK(NMEASentenceRMC) | NMEA_TYPE_MASK(NMEASentenceGSV))
+
+/**
+ * Get the offset of the first '$' at or after offset
+ */
+static size_t alignToSentence(const char* buf, size_t size, size_t offset) {
+    if(offset >= size) {
+        return size;
+    }
+    const char* start = (const char*)memchr(buf + offset, '$', size - offset);
+    return start == NULL ? size : start - buf;
+}
+
+/**
+ * Parse all GLL, RMC and GSV sentences in [begin, end) of buf.
+ */
+static void parseChunk(const char* buf, size_t begin, size_t end, ReplayChunk* chunk) {
+    const char* pos = buf + begin;
+    const char* chunkEnd = buf + end;
+    while(pos < chunkEnd) {
+        const char* start = (const char*)memchr(pos, '$', chunkEnd - pos);
+        if(start == NULL) {
+            break;
+        }
+        const char* eol = (const char*)memchr(start, '\n', chunkEnd - start);
+        if(eol == NULL) {
+            eol = chunkEnd;
+        }
+        NMEAReplayRecord record;
+        int rc = dispatchNMEASentence(start, eol - start, REPLAY_SENTENCE_TYPES, &record.sentence);
+        if(rc == 1) { //Unsupported sentence
+            pos = eol + 1;
+            continue;
+        }
+        chunk->sentences++;
+        if(rc == 0) {
+            record.offset = start - buf;
+            chunk->records.push_back(record);
+        } else {
+            chunk->parseErrors++;
+        }
+        pos = eol + 1;
+    }
+}
+
+NMEAReplayEngine::NMEAReplayEngine(unsigned numThreads, size_t chunkSize)
+    : numThreads(numThreads), chunkSize(chunkSize) {
+    if(this->numThreads == 0) {
+        this->numThreads = std::thread::hardware_concurrency();
+    }
+    if(this->numThreads == 0) {
+        this->numThreads = 1;
+    }
+    if(this->chunkSize == 0) {
+        this->chunkSize = 1;
+    }
+}
+
+void NMEAReplayEngine::replayBuffer(const char* buf, size_t size, Callback callback, NMEAReplayStats* stats) {
+    auto startTime = chrono::steady_clock::now();
+    size_t numChunks = (size + chunkSize - 1) / chunkSize;
+    //At most this many chunks are parsed or waiting for delivery
+    size_t window = 2 * numThreads;
+    vector<ReplayChunk> chunks(window);
+    mutex lock;
+    condition_variable chunkDone, chunkDelivered;
+    size_t nextChunk = 0, delivered = 0;
+
+    auto worker = [&]() {
+        for(;;) {
+            size_t idx;
+            {
+                unique_lock<mutex> guard(lock);
+                if(nextChunk >= numChunks) {
+                    return;
+                }
+                idx = nextChunk++;
+                //Wait until there is space in the window
+                chunkDelivered.wait(guard, [&]() { return idx < delivered + window; });
+            }
+            ReplayChunk& chunk = chunks[idx % window];
+            chunk.records.clear();
+            chunk.sentences = chunk.parseErrors = 0;
+            parseChunk(buf,
+                alignToSentence(buf, size, idx * chunkSize),
+                alignToSentence(buf, size, (idx + 1) * chunkSize), &chunk);
+            {
+                lock_guard<mutex> guard(lock);
+                chunk.done = true;
+            }
+            chunkDone.notify_all();
+        }
+    };
+    for (size_t i = 0; i < window; ++i) {
+        chunks[i].done = false;
+    }
+    vector<thread> threads;
+    for (unsigned i = 0; i < numThreads; ++i) {
+        threads.push_back(thread(worker));
+    }
+    //Deliver results in input order
+    uint64_t sentences = 0, parseErrors = 0;
+    for (size_t idx = 0; idx < numChunks; ++idx) {
+        ReplayChunk& chunk = chunks[idx % window];
+        {
+            unique_lock<mutex> guard(lock);
+            chunkDone.wait(guard, [&]() { return chunk.done; });
+        }
+        for (const NMEAReplayRecord& record : chunk.records) {
+            callback(record);
+        }
+        sentences += chunk.sentences;
+        parseErrors += chunk.parseErrors;
+        {
+            lock_guard<mutex> guard(lock);
+            chunk.done = false;
+            delivered++;
+        }
+        chunkDelivered.notify_all();
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+    if(stats != NULL) {
+        stats->bytes = size;
+        stats->sentences = sentences;
+        stats->parseErrors = parseErrors;
+        stats->seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    }
+}
+
+int NMEAReplayEngine::replayFile(const char* filename, Callback callback, NMEAReplayStats* stats) {
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    size_t size = st.st_size;
+    if(size == 0) {
+        close(fd);
+        replayBuffer(NULL, 0, callback, stats);
+        return 0;
+    }
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) {
+        return -2;
+    }
+    madvise(map, size, MADV_SEQUENTIAL);
+    replayBuffer((const char*)map, size, callback, stats);
+    munmap(map, size);
+    return 0;
+}
@@ -0,0 +1,275 @@
+#include "NMEASeekIndex.h"
+#include "NMEATime.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const char seekIndexMagic[8] = {'N', 'M', 'E', 'A', 'S', 'E', 'K', '1'};
+
+/**
+ * Magic, uint32 interval, uint32 reserved
+ */
+#define SEEK_INDEX_HEADER_SIZE 16
+/**
+ * Capture bytes read per step
+ */
+#define SEEK_INDEX_READ_SIZE (64 * 1024)
+
+/**
+ * Seconds since 1970-01-01 of a time key
+ */
+static int64_t timeKeySeconds(uint64_t key) {
+    uint32_t yymmdd = (uint32_t)(key / 100000000);
+    uint32_t time = (uint32_t)(key % 100000000) / 100;
+    int64_t days = getNMEACivilDays(2000 + yymmdd / 10000, yymmdd / 100 % 100, yymmdd % 100);
+    return days * 86400 + (time / 10000) * 3600 + (time / 100 % 100) * 60 + time % 100;
+}
+
+uint64_t getNMEARMCTimeKey(const char* sentence, size_t size) {
+    if(checkNMEAChecksum(sentence, size) == -2) {
+        return NMEA_TIME_KEY_INVALID;
+    }
+    NMEASentenceView view(sentence, size);
+    return makeNMEATimeKey(view.integer(9), view.utcTime(1));
+}
+
+NMEASeekIndexBuilder::NMEASeekIndexBuilder(uint32_t intervalSeconds)
+    : interval(intervalSeconds), captureFd(-1), indexFd(-1),
+      scanOffset(0), hasEntry(false), lastSeconds(0), lastKey(0) {
+}
+
+NMEASeekIndexBuilder::~NMEASeekIndexBuilder() {
+    close();
+}
+
+int NMEASeekIndexBuilder::open(const char* captureFilename, const char* indexFilename) {
+    close();
+    captureFd = ::open(captureFilename, O_RDONLY);
+    if(captureFd < 0) {
+        return -1;
+    }
+    indexFd = ::open(indexFilename, O_RDWR | O_CREAT, 0644);
+    if(indexFd < 0) {
+        close();
+        return -2;
+    }
+    struct stat st;
+    if(fstat(indexFd, &st) != 0) {
+        close();
+        return -2;
+    }
+    uint8_t header[SEEK_INDEX_HEADER_SIZE] = {};
+    if(st.st_size == 0) { //New index
+        memcpy(header, seekIndexMagic, sizeof(seekIndexMagic));
+        memcpy(header + 8, &interval, sizeof(interval));
+        if(pwrite(indexFd, header, sizeof(header), 0) != sizeof(header)) {
+            close();
+            return -2;
+        }
+        return 0;
+    }
+    //Continue an existing index
+    uint32_t existingInterval;
+    if(pread(indexFd, header, sizeof(header), 0) != sizeof(header)
+        || memcmp(header, seekIndexMagic, sizeof(seekIndexMagic)) != 0
+        || (st.st_size - SEEK_INDEX_HEADER_SIZE) % sizeof(NMEASeekIndexEntry) != 0) {
+        close();
+        return -3;
+    }
+    memcpy(&existingInterval, header + 8, sizeof(existingInterval));
+    if(existingInterval != interval) {
+        close();
+        return -3;
+    }
+    if(st.st_size > SEEK_INDEX_HEADER_SIZE) {
+        NMEASeekIndexEntry last;
+        if(pread(indexFd, &last, sizeof(last), st.st_size - sizeof(last)) != sizeof(last)) {
+            close();
+            return -2;
+        }
+        //Rescan from the last entry. Its own RMC does not create a new entry.
+        hasEntry = true;
+        lastSeconds = timeKeySeconds(last.key);
+        lastKey = last.key;
+        scanOffset = last.offset;
+    }
+    return 0;
+}
+
+void NMEASeekIndexBuilder::close() {
+    if(captureFd >= 0) {
+        ::close(captureFd);
+    }
+    if(indexFd >= 0) {
+        ::close(indexFd);
+    }
+    captureFd = -1;
+    indexFd = -1;
+    scanOffset = 0;
+    hasEntry = false;
+    lastSeconds = 0;
+    lastKey = 0;
+}
+
+int NMEASeekIndexBuilder::addEntry(uint64_t key, uint64_t offset) {
+    NMEASeekIndexEntry entry = {key, offset};
+    off_t end = lseek(indexFd, 0, SEEK_END);
+    if(end < 0 || pwrite(indexFd, &entry, sizeof(entry), end) != sizeof(entry)) {
+        return -1;
+    }
+    hasEntry = true;
+    lastSeconds = timeKeySeconds(key);
+    return 0;
+}
+
+int NMEASeekIndexBuilder::update() {
+    if(captureFd < 0) {
+        return -1;
+    }
+    buffer.resize(SEEK_INDEX_READ_SIZE);
+    int newEntries = 0;
+    for(;;) {
+        ssize_t n = pread(captureFd, buffer.data(), buffer.size(), scanOffset);
+        if(n < 0) {
+            return -1;
+        }
+        const char* data = buffer.data();
+        //Only index complete lines
+        const char* lastEol = (const char*)memrchr(data, '\n', n);
+        if(lastEol == NULL) {
+            if((size_t)n == buffer.size()) { //Overlong line, skip it
+                scanOffset += n;
+                continue;
+            }
+            return newEntries;
+        }
+        const char* end = lastEol + 1;
+        const char* pos = data;
+        while(pos < end) {
+            const char* eol = (const char*)memchr(pos, '\n', end - pos) + 1;
+            const char* start = (const char*)memchr(pos, '$', eol - pos);
+            if(start != NULL && getNMEASentenceType(start, eol - start) == NMEASentenceRMC) {
+                uint64_t key = getNMEARMCTimeKey(start, eol - start);
+                if(key != NMEA_TIME_KEY_INVALID && key < lastKey) {
+                    //Binary search and queries need non-decreasing keys
+                    scanOffset += pos - data;
+                    return -2;
+                }
+                lastKey = key != NMEA_TIME_KEY_INVALID ? key : lastKey;
+                if(key != NMEA_TIME_KEY_INVALID
+                    && (!hasEntry || timeKeySeconds(key) >= lastSeconds + interval)) {
+                    if(addEntry(key, scanOffset + (start - data)) != 0) {
+                        return -1;
+                    }
+                    newEntries++;
+                }
+            }
+            pos = eol;
+        }
+        scanOffset += end - data;
+        if((size_t)n < buffer.size()) {
+            return newEntries;
+        }
+    }
+}
+
+NMEACaptureSeeker::NMEACaptureSeeker()
+    : capture(NULL), captureSize(0), indexMap(NULL), indexSize(0), entries(NULL), numEntries(0) {
+}
+
+NMEACaptureSeeker::~NMEACaptureSeeker() {
+    close();
+}
+
+/**
+ * Map a whole file read-only
+ * @return 0 on success, -1 if it could not be opened, -2 if it could not be mapped
+ */
+static int mapFile(const char* filename, const void** map, size_t* size) {
+    int fd = ::open(filename, O_RDONLY);
+    if(fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    *size = st.st_size;
+    *map = NULL;
+    if(*size == 0) {
+        ::close(fd);
+        return 0;
+    }
+    void* m = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(m == MAP_FAILED) {
+        return -2;
+    }
+    *map = m;
+    return 0;
+}
+
+int NMEACaptureSeeker::open(const char* captureFilename, const char* indexFilename) {
+    close();
+    const void* map;
+    int rc = mapFile(captureFilename, &map, &captureSize);
+    if(rc != 0) {
+        return rc;
+    }
+    capture = (const char*)map;
+    rc = mapFile(indexFilename, &map, &indexSize);
+    if(rc != 0) {
+        close();
+        return rc;
+    }
+    indexMap = (const uint8_t*)map;
+    if(indexSize < SEEK_INDEX_HEADER_SIZE
+        || memcmp(indexMap, seekIndexMagic, sizeof(seekIndexMagic)) != 0) {
+        close();
+        return -3;
+    }
+    entries = (const NMEASeekIndexEntry*)(indexMap + SEEK_INDEX_HEADER_SIZE);
+    //Ignore a partially written last entry
+    numEntries = (indexSize - SEEK_INDEX_HEADER_SIZE) / sizeof(NMEASeekIndexEntry);
+    return 0;
+}
+
+void NMEACaptureSeeker::close() {
+    if(capture != NULL) {
+        munmap((void*)capture, captureSize);
+    }
+    if(indexMap != NULL) {
+        munmap((void*)indexMap, indexSize);
+    }
+    capture = NULL;
+    captureSize = 0;
+    indexMap = NULL;
+    indexSize = 0;
+    entries = NULL;
+    numEntries = 0;
+}
+
+uint64_t NMEACaptureSeeker::findOffset(uint64_t key) const {
+    //Find the first entry with a key > key
+    size_t lo = 0, hi = numEntries;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(entries[mid].key <= key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if(lo == 0) {
+        return 0;
+    }
+    uint64_t offset = entries[lo - 1].offset;
+    return offset < captureSize ? offset : captureSize;
+}
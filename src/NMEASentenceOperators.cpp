@@ -1,45 +1,21 @@
 #include "NMEASentenceOperators.h"
-
-#include <iomanip>
+#include "NMEAFormat.h"
 
 using namespace std;
 
 std::ostream& printCoordinate(std::ostream &os, int32_t coord) {
-    //All-integer computation avoids floating point rounding errors
-    div_t degmin = div(coord, 10000000);
-    div_t minutes = div(degmin.rem, 100000);
-    os << degmin.quot << "°" << minutes.quot << '.' << minutes.rem << '"';
-    return os;
+    char buf[24];
+    return os.write(buf, formatNMEACoordinate(coord, buf));
 }
 
 std::ostream& operator<<(std::ostream &os, NMEAPosition const &m) {
-    os << "NMEAPosition { ";
-    printCoordinate(os, abs(m.latitude)) << (m.latitude < 0 ? 'S' : 'N') << ' ';
-    printCoordinate(os, abs(m.longitude)) << (m.latitude < 0 ? 'W' : 'E') << " }";
-    return os;
+    char buf[NMEA_FORMAT_MAX_SIZE];
+    return os.write(buf, formatNMEAPosition(m, NMEAFormatText, buf, sizeof(buf)));
 }
 
 std::ostream& operator<<(std::ostream &os, RMCSentence const &m) {
-    os << "RMC { ";
-    //Date (ISO 8601)
-    div_t year = div(m.date, 100);
-    div_t month = div(year.quot, 100);
-    //os << m.date << " ";
-    os << setfill('0') << "20" << setw(2) << year.rem
-       << '-' << setw(2) << month.rem << "-" << setw(2)
-       << month.quot << ' ';
-    //Time
-    div_t subseconds = div(m.utcTime, 100);
-    div_t seconds = div(subseconds.quot, 100);
-    div_t minutes = div(seconds.quot, 100);
-    os << minutes.quot << ':' << minutes.rem << ':' << seconds.rem << '.' << subseconds.rem << ", ";
-    //Position
-    os << m.position;
-    //Status & posMode
-    os << m.status << '/' << m.posMode << ", ";
-    //Speed & course
-    os << (m.speed / 1000.0) << " kt, " << (m.course / 1000.0) << "° }";
-    return os;
+    char buf[NMEA_FORMAT_MAX_SIZE];
+    return os.write(buf, formatRMCSentence(m, NMEAFormatText, buf, sizeof(buf)));
 }
 
 bool operator==(NMEAPosition const &a, NMEAPosition const &b) {
@@ -94,20 +70,123 @@ bool operator!=(GSVSentence const &a, GSVSentence const &b) {
 }
 
 std::ostream& operator<<(std::ostream &os, GSVSatInfo const &m) {
-    os << "Satellite { #" << (int)m.id << ", azimuth " << (int)m.azimuth
-       << ", elevation " << (int)m.elevation << ", signal " << ((int)m.signal) << '}';
-    return os;
+    char buf[NMEA_FORMAT_MAX_SIZE];
+    return os.write(buf, formatGSVSatInfo(m, buf, sizeof(buf)));
 }
 
 std::ostream& operator<<(std::ostream &os, GSVSentence const &m) {
-    os << "GSVSentence { #" << (int)m.msgNum << " of "
-       << (int)m.numMsgs << ", " << (int)m.numSats << " satellites in view: ";
-    for (int i = 0; i < m.numSatInfos; ++i) {
-        if(i != 0) {
-            os << ", ";
+    char buf[NMEA_FORMAT_MAX_SIZE];
+    return os.write(buf, formatGSVSentence(m, NMEAFormatText, buf, sizeof(buf)));
+}
+
+bool operator==(GGASentence const &a, GGASentence const &b) {
+    return a.utcTime == b.utcTime
+            && a.position == b.position
+            && a.quality == b.quality
+            && a.numSatellites == b.numSatellites
+            && a.hdop == b.hdop
+            && a.altitude == b.altitude
+            && a.geoidSeparation == b.geoidSeparation;
+}
+
+bool operator!=(GGASentence const &a, GGASentence const &b) {
+    return !(a == b);
+}
+
+bool operator==(GSASentence const &a, GSASentence const &b) {
+    if(a.opMode != b.opMode || a.navMode != b.navMode) {
+        return false;
+    }
+    for (int i = 0; i < 12; ++i) {
+        if(a.satellites[i] != b.satellites[i]) {
+            return false;
+        }
+    }
+    return a.pdop == b.pdop
+            && a.hdop == b.hdop
+            && a.vdop == b.vdop
+            && a.systemId == b.systemId;
+}
+
+bool operator!=(GSASentence const &a, GSASentence const &b) {
+    return !(a == b);
+}
+
+bool operator==(VTGSentence const &a, VTGSentence const &b) {
+    return a.courseTrue == b.courseTrue
+            && a.courseMagnetic == b.courseMagnetic
+            && a.speedKnots == b.speedKnots
+            && a.speedKmh == b.speedKmh
+            && a.posMode == b.posMode;
+}
+
+bool operator!=(VTGSentence const &a, VTGSentence const &b) {
+    return !(a == b);
+}
+
+bool operator==(ZDASentence const &a, ZDASentence const &b) {
+    return a.utcTime == b.utcTime
+            && a.day == b.day
+            && a.month == b.month
+            && a.year == b.year
+            && a.localZoneHours == b.localZoneHours
+            && a.localZoneMinutes == b.localZoneMinutes;
+}
+
+bool operator!=(ZDASentence const &a, ZDASentence const &b) {
+    return !(a == b);
+}
+
+bool operator==(GSTSentence const &a, GSTSentence const &b) {
+    return a.utcTime == b.utcTime
+            && a.rangeRms == b.rangeRms
+            && a.stdMajor == b.stdMajor
+            && a.stdMinor == b.stdMinor
+            && a.orientation == b.orientation
+            && a.stdLatitude == b.stdLatitude
+            && a.stdLongitude == b.stdLongitude
+            && a.stdAltitude == b.stdAltitude;
+}
+
+bool operator!=(GSTSentence const &a, GSTSentence const &b) {
+    return !(a == b);
+}
+
+std::ostream& operator<<(std::ostream &os, GGASentence const &m) {
+    os << "GGA { " << m.utcTime << ", " << m.position
+       << ", quality " << (int)m.quality << ", " << (int)m.numSatellites << " satellites"
+       << ", HDOP " << m.hdop << ", altitude " << m.altitude << " mm"
+       << ", geoid separation " << m.geoidSeparation << " mm }";
+    return os;
+}
+
+std::ostream& operator<<(std::ostream &os, GSASentence const &m) {
+    os << "GSA { " << m.opMode << '/' << (int)m.navMode << ", satellites:";
+    for (int i = 0; i < 12; ++i) {
+        if(m.satellites[i] != INT32_MAX) {
+            os << ' ' << m.satellites[i];
         }
-        os << m.satellites[i];
     }
-    os << " }";
+    os << ", PDOP " << m.pdop << ", HDOP " << m.hdop << ", VDOP " << m.vdop
+       << ", system " << m.systemId << " }";
+    return os;
+}
+
+std::ostream& operator<<(std::ostream &os, VTGSentence const &m) {
+    os << "VTG { " << m.courseTrue << " T, " << m.courseMagnetic << " M, "
+       << m.speedKnots << " N, " << m.speedKmh << " K, " << m.posMode << " }";
     return os;
-}
\ No newline at end of file
+}
+
+std::ostream& operator<<(std::ostream &os, ZDASentence const &m) {
+    os << "ZDA { " << m.utcTime << ", " << (int)m.day << '.' << (int)m.month << '.' << m.year
+       << ", zone " << m.localZoneHours << ':' << m.localZoneMinutes << " }";
+    return os;
+}
+
+std::ostream& operator<<(std::ostream &os, GSTSentence const &m) {
+    os << "GST { " << m.utcTime << ", RMS " << m.rangeRms
+       << ", ellipse " << m.stdMajor << '/' << m.stdMinor << '/' << m.orientation
+       << ", std " << m.stdLatitude << '/' << m.stdLongitude << '/' << m.stdAltitude << " }";
+    return os;
+}
@@ -1,150 +1,101 @@
-
 #include "NMEASentences.h"
 #include "NMEA.h"
+#include "NMEASentenceSchemas.h"
 
 #include <cstring>
 
-/**
- * Utility macro to advance the pos pointer to after the next ','
- * and return -1 if done
- */
-#define NextNMEAField() pos = strchr(pos, ','); if(pos == NULL) {return -1;}pos++
-/**
- * Assert that a given field is not INT32_MAX. Else, return a rc
- */
-#define CheckFieldValid(field, rc) if((field) == INT32_MAX) {return rc;}(void)0;
-/**
- * Like NextNMEAField(), but does not return if no next field is found.
- * pos is NULL after the call if there is no next field
- */
-#define OptionalNextNMEAField() pos = strchr(pos, ','); if(pos != NULL) {pos++;}(void)0
-
 int parseGLLSentence(const char* buf, NMEAPosition* position) {
-    const char* pos = buf;
-    //Parse latitude
-    NextNMEAField();
-    position->latitude = parseNMEACoordinate(pos);
-    CheckFieldValid(position->latitude, -2);
-    //Parse latitude direction
-    NextNMEAField();
-    if(applyDirectionSignToCoordinate(*pos, &position->latitude)) {
-        return -3;
-    }
-    //Parse longitude
-    NextNMEAField();
-    position->longitude = parseNMEACoordinate(pos);
-    CheckFieldValid(position->longitude, -4);
-    //Parse longitude direction
-    NextNMEAField();
-    if(applyDirectionSignToCoordinate(*pos, &position->longitude)) {
-        return -5;
-    }
-    return 0;
+    return parseGLLSentence(NMEASentenceView(buf), position);
+}
+
+int parseGLLSentence(const NMEASentenceView& view, NMEAPosition* position) {
+    return NMEAGLLSchema::parse(view, position);
 }
 
 int parseRMCSentence(const char* buf, RMCSentence* result) {
-    const char* pos = buf;
-    NextNMEAField();
-    result->utcTime = parseNMEAUTCTime(pos);
-    CheckFieldValid(result->utcTime, -2);
-    //Parse status
-    NextNMEAField();
-    result->status = *pos;
-    if(result->status != 'A' && result->status != 'V') {
-        return -3;
-    }
-    //Parse latitude
-    NextNMEAField();
-    result->position.latitude = parseNMEACoordinate(pos);
-    CheckFieldValid(result->position.latitude, -4);
-    //Parse latitude direction
-    NextNMEAField();
-    if(applyDirectionSignToCoordinate(*pos, &result->position.latitude)) {
-        return -5;
-    }
-    //Parse longitude
-    NextNMEAField();
-    result->position.longitude = parseNMEACoordinate(pos);
-    CheckFieldValid(result->position.longitude, -6);
-    //Parse longitude direction
-    NextNMEAField();
-    if(applyDirectionSignToCoordinate(*pos, &result->position.longitude)) {
-        return -7;
-    }
-    //Parse speed
-    NextNMEAField();
-    result->speed = parseNMEAFixedPointDecimal(pos, 3);
-    CheckFieldValid(result->speed, -8);
-    //Parse course
-    NextNMEAField();
-    result->course = parseNMEAFixedPointDecimal(pos, 3);
-    CheckFieldValid(result->course, -9);
-    //Parse date
-    NextNMEAField();
-    result->date = parseNMEAInteger(pos);
-    CheckFieldValid(result->date, -10);
-    //Ignore 2 magnetic variation fields
-    NextNMEAField();
-    NextNMEAField();
-    //Position/fix mode
-    NextNMEAField();
-    result->posMode = *pos;
-    if(result->posMode != 'N'
-        && result->posMode != 'E'
-        && result->posMode != 'A'
-        && result->posMode != 'D') {
-        return -11;
-    }
-    return 0;
+    return parseRMCSentence(NMEASentenceView(buf), result);
 }
 
+int parseRMCSentence(const NMEASentenceView& view, RMCSentence* result) {
+    return NMEARMCSchema::parse(view, result);
+}
 
 int parseGSVSentence(const char* buf, GSVSentence* result) {
-    const char* pos = buf;
-    //Parse number of msgs
-    NextNMEAField();
-    int32_t numMsgs = parseNMEAInteger(pos);
-    CheckFieldValid(numMsgs, -2);
-    result->numMsgs = (uint16_t)numMsgs;
-    //Parse current msg id
-    NextNMEAField();
-    int32_t msgNum = parseNMEAInteger(pos);
-    CheckFieldValid(msgNum, -3);
-    result->msgNum = (uint8_t)msgNum;
-    //Parse satellites in view
-    NextNMEAField();
-    int32_t numSats = parseNMEAInteger(pos);
-    CheckFieldValid(numSats, -4);
-    result->numSats = (uint8_t)numSats;
-    /*
-     * Parse 1..4 satellite infos
-     */ 
-    result->numSatInfos = 0;
-    for (int i = 0; i < 4; ++i) {
-        OptionalNextNMEAField();
-        if(pos == NULL) { //No next satellite
-            break;
-        }
-        //We have a next record
-        result->numSatInfos++;
-        //Parse sat id
-        int32_t satId = parseNMEAInteger(pos);
-        CheckFieldValid(satId, -5);
-        result->satellites[i].id = (uint16_t)satId;
-        //Parse azimuth
-        NextNMEAField();
-        int32_t azimuth = parseNMEAInteger(pos);
-        CheckFieldValid(azimuth, -6);
-        result->satellites[i].azimuth = (int16_t)azimuth;
-        //Parse elevation
-        NextNMEAField();
-        int32_t elevation = parseNMEAInteger(pos);
-        CheckFieldValid(elevation, -7);
-        result->satellites[i].elevation = (uint8_t)elevation;
-        //Parse signal
-        NextNMEAField();
-        int32_t signalLevel = parseNMEAInteger(pos);
-        result->satellites[i].signal = signalLevel == INT32_MAX ? UINT8_MAX : (uint8_t)signalLevel;
-    }
-    return 0;
+    return parseGSVSentence(NMEASentenceView(buf), result);
+}
+
+int parseGSVSentence(const NMEASentenceView& view, GSVSentence* result) {
+    return NMEAGSVSchema::parse(view, result);
+}
+
+int parseGGASentence(const char* buf, GGASentence* result) {
+    return parseGGASentence(NMEASentenceView(buf), result);
+}
+
+int parseGGASentence(const NMEASentenceView& view, GGASentence* result) {
+    return NMEAGGASchema::parse(view, result);
+}
+
+int parseGSASentence(const char* buf, GSASentence* result) {
+    return parseGSASentence(NMEASentenceView(buf), result);
+}
+
+int parseGSASentence(const NMEASentenceView& view, GSASentence* result) {
+    return NMEAGSASchema::parse(view, result);
+}
+
+int parseVTGSentence(const char* buf, VTGSentence* result) {
+    return parseVTGSentence(NMEASentenceView(buf), result);
+}
+
+int parseVTGSentence(const NMEASentenceView& view, VTGSentence* result) {
+    return NMEAVTGSchema::parse(view, result);
+}
+
+int parseZDASentence(const char* buf, ZDASentence* result) {
+    return parseZDASentence(NMEASentenceView(buf), result);
+}
+
+int parseZDASentence(const NMEASentenceView& view, ZDASentence* result) {
+    return NMEAZDASchema::parse(view, result);
+}
+
+int parseGSTSentence(const char* buf, GSTSentence* result) {
+    return parseGSTSentence(NMEASentenceView(buf), result);
+}
+
+int parseGSTSentence(const NMEASentenceView& view, GSTSentence* result) {
+    return NMEAGSTSchema::parse(view, result);
+}
+
+uint32_t parseGLLSentenceFields(const NMEASentenceView& view, uint32_t fieldMask, NMEAPosition* position) {
+    return NMEAGLLSchema::decode(view, position, fieldMask);
+}
+
+uint32_t parseRMCSentenceFields(const NMEASentenceView& view, uint32_t fieldMask, RMCSentence* result) {
+    return NMEARMCSchema::decode(view, result, fieldMask);
+}
+
+uint32_t parseGSVSentenceFields(const NMEASentenceView& view, uint32_t fieldMask, GSVSentence* result) {
+    return NMEAGSVSchema::decode(view, result, fieldMask);
+}
+
+uint32_t parseGGASentenceFields(const NMEASentenceView& view, uint32_t fieldMask, GGASentence* result) {
+    return NMEAGGASchema::decode(view, result, fieldMask);
+}
+
+uint32_t parseGSASentenceFields(const NMEASentenceView& view, uint32_t fieldMask, GSASentence* result) {
+    return NMEAGSASchema::decode(view, result, fieldMask);
+}
+
+uint32_t parseVTGSentenceFields(const NMEASentenceView& view, uint32_t fieldMask, VTGSentence* result) {
+    return NMEAVTGSchema::decode(view, result, fieldMask);
+}
+
+uint32_t parseZDASentenceFields(const NMEASentenceView& view, uint32_t fieldMask, ZDASentence* result) {
+    return NMEAZDASchema::decode(view, result, fieldMask);
+}
+
+uint32_t parseGSTSentenceFields(const NMEASentenceView& view, uint32_t fieldMask, GSTSentence* result) {
+    return NMEAGSTSchema::decode(view, result, fieldMask);
 }
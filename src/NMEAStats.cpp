@@ -0,0 +1,127 @@
+#include "NMEAStats.h"
+
+#include <chrono>
+#include <cstring>
+
+using namespace std;
+
+uint64_t NMEAStatsSnapshot::totalSentences() const {
+    uint64_t total = 0;
+    for (int i = 0; i < NMEA_STATS_NUM_TYPES; ++i) {
+        total += sentences[i];
+    }
+    return total;
+}
+
+uint64_t NMEAStatsSnapshot::totalErrors() const {
+    uint64_t total = 0;
+    for (int type = 0; type < NMEA_STATS_NUM_TYPES; ++type) {
+        for (int i = 0; i < NMEA_STATS_NUM_ERRORS; ++i) {
+            total += errors[type][i];
+        }
+    }
+    return total;
+}
+
+uint64_t NMEAStatsSnapshot::totalErrors(int rc) const {
+    unsigned slot = getNMEAStatsErrorSlot(rc);
+    uint64_t total = 0;
+    for (int type = 0; type < NMEA_STATS_NUM_TYPES; ++type) {
+        total += errors[type][slot];
+    }
+    return total;
+}
+
+uint64_t NMEAStatsSnapshot::latencyQuantile(double quantile) const {
+    uint64_t total = 0;
+    for (int i = 0; i < NMEA_STATS_NUM_LATENCY_BUCKETS; ++i) {
+        total += latency[i];
+    }
+    if(total == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(quantile * total);
+    uint64_t count = 0;
+    for (int i = 0; i < NMEA_STATS_NUM_LATENCY_BUCKETS; ++i) {
+        count += latency[i];
+        if(count > rank) {
+            return i == 0 ? 0 : (1ull << i) - 1;
+        }
+    }
+    return (1ull << (NMEA_STATS_NUM_LATENCY_BUCKETS - 1)) - 1;
+}
+
+#ifdef NMEA_ENABLE_STATS
+
+NMEAStatsShard nmeaStatsShards[NMEA_STATS_SHARDS];
+
+static std::atomic<unsigned> nextStatsShard(0);
+
+NMEAStatsShard& getNMEAStatsShard() {
+    //Round-robin assignment spreads the first NMEA_STATS_SHARDS threads over all shards
+    static thread_local NMEAStatsShard* shard =
+        &nmeaStatsShards[nextStatsShard.fetch_add(1, memory_order_relaxed) % NMEA_STATS_SHARDS];
+    return *shard;
+}
+
+uint64_t getNMEAStatsTime() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template<size_t N>
+static inline void sumCounters(const std::atomic<uint64_t> (&counters)[N], uint64_t* out) {
+    for (size_t i = 0; i < N; ++i) {
+        out[i] += counters[i].load(memory_order_relaxed);
+    }
+}
+
+template<size_t N>
+static inline void resetCounters(std::atomic<uint64_t> (&counters)[N]) {
+    for (size_t i = 0; i < N; ++i) {
+        counters[i].store(0, memory_order_relaxed);
+    }
+}
+
+bool isNMEAStatsEnabled() {
+    return true;
+}
+
+void getNMEAStats(NMEAStatsSnapshot* snapshot) {
+    memset(snapshot, 0, sizeof(*snapshot));
+    for (int i = 0; i < NMEA_STATS_SHARDS; ++i) {
+        const NMEAStatsShard& shard = nmeaStatsShards[i];
+        sumCounters(shard.sentences, snapshot->sentences);
+        for (int type = 0; type < NMEA_STATS_NUM_TYPES; ++type) {
+            sumCounters(shard.errors[type], snapshot->errors[type]);
+        }
+        sumCounters(shard.counters, snapshot->counters);
+        sumCounters(shard.latency, snapshot->latency);
+    }
+}
+
+void resetNMEAStats() {
+    for (int i = 0; i < NMEA_STATS_SHARDS; ++i) {
+        NMEAStatsShard& shard = nmeaStatsShards[i];
+        resetCounters(shard.sentences);
+        for (int type = 0; type < NMEA_STATS_NUM_TYPES; ++type) {
+            resetCounters(shard.errors[type]);
+        }
+        resetCounters(shard.counters);
+        resetCounters(shard.latency);
+    }
+}
+
+#else
+
+bool isNMEAStatsEnabled() {
+    return false;
+}
+
+void getNMEAStats(NMEAStatsSnapshot* snapshot) {
+    memset(snapshot, 0, sizeof(*snapshot));
+}
+
+void resetNMEAStats() {
+}
+
+#endif //NMEA_ENABLE_STATS
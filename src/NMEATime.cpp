@@ -0,0 +1,115 @@
+#include "NMEATime.h"
+
+#define NMEA_HALF_DAY_NS (NMEA_NS_PER_DAY / 2)
+
+int64_t getNMEACivilDays(int year, int month, int day) {
+    //Shift the year to start in March, so the leap day is the last day
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    //719468 days from 0000-03-01 to 1970-01-01
+    return (int64_t)era * 146097 + dayOfEra - 719468;
+}
+
+/**
+ * Days since 1970-01-01 of a ddmmyy date, -1 if it is invalid
+ */
+static int64_t ddmmyyDays(int32_t date) {
+    int day = date / 10000;
+    int month = date / 100 % 100;
+    if(date < 0 || date == INT32_MAX || day < 1 || day > 31 || month < 1 || month > 12) {
+        return -1;
+    }
+    return getNMEACivilDays(2000 + date % 100, month, day);
+}
+
+NMEAEpochConverter::NMEAEpochConverter(int32_t minDate) {
+    minDays = minDate == INT32_MAX ? -1 : ddmmyyDays(minDate);
+    reset();
+}
+
+void NMEAEpochConverter::reset() {
+    cachedDate = INT32_MAX;
+    cachedDayStart = NMEA_EPOCH_INVALID;
+    cachedMinute = UINT32_MAX;
+    cachedMinuteNs = 0;
+    dayStart = NMEA_EPOCH_INVALID;
+    lastTimeOfDay = 0;
+}
+
+int64_t NMEAEpochConverter::timeOfDayNs(uint32_t utcTime) {
+    //hhmmss.ss as hhmmssss
+    uint32_t minute = utcTime / 10000;
+    uint32_t rest = utcTime - minute * 10000;
+    if(minute != cachedMinute) {
+        uint32_t hours = minute / 100;
+        uint32_t minutes = minute - hours * 100;
+        if(utcTime == INT32_MAX || hours >= 24 || minutes >= 60) {
+            return -1;
+        }
+        cachedMinute = minute;
+        cachedMinuteNs = (int64_t)(hours * 60 + minutes) * 60 * NMEA_NS_PER_SECOND;
+    }
+    uint32_t seconds = rest / 100;
+    if(seconds > 60) { //60 = leap second
+        return -1;
+    }
+    return cachedMinuteNs + (int64_t)seconds * NMEA_NS_PER_SECOND + (int64_t)(rest - seconds * 100) * 10000000;
+}
+
+int64_t NMEAEpochConverter::dayStartNs(int32_t date) const {
+    int64_t days = ddmmyyDays(date);
+    if(days < 0) {
+        return NMEA_EPOCH_INVALID;
+    }
+    if(days < minDays) {
+        days += (minDays - days + NMEA_GPS_ROLLOVER_DAYS - 1) / NMEA_GPS_ROLLOVER_DAYS * NMEA_GPS_ROLLOVER_DAYS;
+    }
+    return days * NMEA_NS_PER_DAY;
+}
+
+int64_t NMEAEpochConverter::toEpochNs(int32_t date, uint32_t utcTime) {
+    if(date == INT32_MAX) {
+        return toEpochNs(utcTime);
+    }
+    if(date != cachedDate) { //Once a day
+        int64_t start = dayStartNs(date);
+        if(start == NMEA_EPOCH_INVALID) {
+            return NMEA_EPOCH_INVALID;
+        }
+        cachedDate = date;
+        cachedDayStart = start;
+    }
+    int64_t timeOfDay = timeOfDayNs(utcTime);
+    if(timeOfDay < 0) {
+        return NMEA_EPOCH_INVALID;
+    }
+    dayStart = cachedDayStart;
+    lastTimeOfDay = timeOfDay;
+    return cachedDayStart + timeOfDay;
+}
+
+int64_t NMEAEpochConverter::toEpochNs(uint32_t utcTime) {
+    int64_t timeOfDay = timeOfDayNs(utcTime);
+    if(timeOfDay < 0 || dayStart == NMEA_EPOCH_INVALID) {
+        return NMEA_EPOCH_INVALID;
+    }
+    if(timeOfDay < lastTimeOfDay - NMEA_HALF_DAY_NS) { //Past midnight
+        dayStart += NMEA_NS_PER_DAY;
+    } else if(timeOfDay > lastTimeOfDay + NMEA_HALF_DAY_NS) { //From before midnight
+        dayStart -= NMEA_NS_PER_DAY;
+    }
+    lastTimeOfDay = timeOfDay;
+    return dayStart + timeOfDay;
+}
+
+size_t NMEAEpochConverter::toEpochNs(const int32_t* dates, const uint32_t* utcTimes, size_t count, int64_t* out) {
+    size_t valid = 0;
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = dates != NULL ? toEpochNs(dates[i], utcTimes[i]) : toEpochNs(utcTimes[i]);
+        valid += out[i] != NMEA_EPOCH_INVALID;
+    }
+    return valid;
+}
@@ -0,0 +1,319 @@
+#include "NMEATrack.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const char trackMagic[8] = {'N', 'M', 'E', 'A', 'T', 'R', 'K', '1'};
+static const char indexMagic[8] = {'N', 'M', 'E', 'A', 'I', 'D', 'X', '1'};
+
+/**
+ * uint32 numFixes, uint32 payload size
+ */
+#define TRACK_BLOCK_HEADER_SIZE 8
+/**
+ * uint64 index offset, uint32 number of blocks, uint32 reserved, magic
+ */
+#define TRACK_TRAILER_SIZE 24
+
+/**
+ * Map signed deltas to unsigned values so small magnitudes encode to few bytes
+ */
+static inline uint64_t zigzagEncode(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t zigzagDecode(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static inline void putVarint(vector<uint8_t>& out, uint64_t value) {
+    while(value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+/**
+ * @return The position after the varint or NULL if it exceeds end
+ */
+static inline const uint8_t* getVarint(const uint8_t* pos, const uint8_t* end, uint64_t* value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64 && pos < end; shift += 7) {
+        uint8_t byte = *pos++;
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if(!(byte & 0x80)) {
+            *value = result;
+            return pos;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Column values of a fix, in storage order
+ */
+static inline void getTrackColumns(const RMCSentence& fix, int32_t* values) {
+    values[0] = (int32_t)fix.utcTime;
+    values[1] = fix.date;
+    values[2] = fix.position.latitude;
+    values[3] = fix.position.longitude;
+    values[4] = fix.speed;
+    values[5] = fix.course;
+    values[6] = fix.status;
+    values[7] = fix.posMode;
+}
+
+static inline void setTrackColumn(RMCSentence* fix, int column, int32_t value) {
+    switch(column) {
+        case 0: fix->utcTime = (uint32_t)value; break;
+        case 1: fix->date = value; break;
+        case 2: fix->position.latitude = value; break;
+        case 3: fix->position.longitude = value; break;
+        case 4: fix->speed = value; break;
+        case 5: fix->course = value; break;
+        case 6: fix->status = (char)value; break;
+        case 7: fix->posMode = (char)value; break;
+    }
+}
+
+NMEATrackWriter::NMEATrackWriter(uint32_t fixesPerBlock)
+    : fd(-1), fixesPerBlock(fixesPerBlock == 0 ? 1 : fixesPerBlock), offset(0), numFixes(0) {
+    memset(&block, 0, sizeof(block));
+    memset(previous, 0, sizeof(previous));
+}
+
+NMEATrackWriter::~NMEATrackWriter() {
+    close();
+}
+
+int NMEATrackWriter::writeAll(const void* data, size_t size) {
+    const char* pos = (const char*)data;
+    while(size > 0) {
+        ssize_t written = write(fd, pos, size);
+        if(written <= 0) {
+            return -2;
+        }
+        pos += written;
+        size -= written;
+        offset += written;
+    }
+    return 0;
+}
+
+int NMEATrackWriter::open(const char* filename) {
+    close();
+    fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) {
+        return -1;
+    }
+    offset = 0;
+    numFixes = 0;
+    index.clear();
+    block.numFixes = 0;
+    return writeAll(trackMagic, sizeof(trackMagic));
+}
+
+int NMEATrackWriter::add(const RMCSentence& fix) {
+    if(fd < 0) {
+        return -2;
+    }
+    if(block.numFixes == 0) { //Start a new block
+        block.offset = offset;
+        block.minKey = NMEA_TIME_KEY_INVALID;
+        block.maxKey = 0;
+        memset(previous, 0, sizeof(previous));
+        for (int i = 0; i < NMEA_TRACK_NUM_COLUMNS; ++i) {
+            columns[i].clear();
+        }
+    }
+    int32_t values[NMEA_TRACK_NUM_COLUMNS];
+    getTrackColumns(fix, values);
+    for (int i = 0; i < NMEA_TRACK_NUM_COLUMNS; ++i) {
+        putVarint(columns[i], zigzagEncode((int64_t)values[i] - previous[i]));
+        previous[i] = values[i];
+    }
+    uint64_t key = makeNMEATimeKey(fix.date, fix.utcTime);
+    if(key != NMEA_TIME_KEY_INVALID) {
+        block.minKey = key < block.minKey ? key : block.minKey;
+        block.maxKey = key > block.maxKey ? key : block.maxKey;
+    }
+    block.numFixes++;
+    numFixes++;
+    if(block.numFixes == fixesPerBlock) {
+        return flushBlock();
+    }
+    return 0;
+}
+
+int NMEATrackWriter::flushBlock() {
+    if(block.numFixes == 0) {
+        return 0;
+    }
+    block.size = 0;
+    for (int i = 0; i < NMEA_TRACK_NUM_COLUMNS; ++i) {
+        block.size += columns[i].size();
+    }
+    uint32_t header[2] = {block.numFixes, block.size};
+    int rc = writeAll(header, sizeof(header));
+    for (int i = 0; i < NMEA_TRACK_NUM_COLUMNS && rc == 0; ++i) {
+        rc = writeAll(columns[i].data(), columns[i].size());
+    }
+    index.push_back(block);
+    block.numFixes = 0;
+    return rc;
+}
+
+int NMEATrackWriter::close() {
+    if(fd < 0) {
+        return 0;
+    }
+    int rc = flushBlock();
+    //Align the index so the reader can access it in place
+    static const uint8_t padding[8] = {};
+    if(rc == 0 && offset % 8 != 0) {
+        rc = writeAll(padding, 8 - offset % 8);
+    }
+    uint64_t indexOffset = offset;
+    if(rc == 0 && !index.empty()) {
+        rc = writeAll(index.data(), index.size() * sizeof(NMEATrackBlockInfo));
+    }
+    uint32_t counts[2] = {(uint32_t)index.size(), 0};
+    if(rc == 0) {
+        rc = writeAll(&indexOffset, sizeof(indexOffset));
+    }
+    if(rc == 0) {
+        rc = writeAll(counts, sizeof(counts));
+    }
+    if(rc == 0) {
+        rc = writeAll(indexMagic, sizeof(indexMagic));
+    }
+    if(::close(fd) != 0 && rc == 0) {
+        rc = -2;
+    }
+    fd = -1;
+    return rc;
+}
+
+NMEATrackReader::NMEATrackReader()
+    : data(NULL), size(0), mapped(false), index(NULL), numBlocks(0) {
+}
+
+NMEATrackReader::~NMEATrackReader() {
+    close();
+}
+
+int NMEATrackReader::open(const char* filename) {
+    close();
+    int fd = ::open(filename, O_RDONLY);
+    if(fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    size_t fileSize = st.st_size;
+    if(fileSize == 0) {
+        ::close(fd);
+        return -3;
+    }
+    void* map = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(map == MAP_FAILED) {
+        return -2;
+    }
+    int rc = openBuffer((const uint8_t*)map, fileSize);
+    if(rc != 0) {
+        munmap(map, fileSize);
+        return rc;
+    }
+    mapped = true;
+    return 0;
+}
+
+int NMEATrackReader::openBuffer(const uint8_t* buf, size_t bufSize) {
+    close();
+    if(bufSize < sizeof(trackMagic) + TRACK_TRAILER_SIZE
+        || memcmp(buf, trackMagic, sizeof(trackMagic)) != 0
+        || memcmp(buf + bufSize - sizeof(indexMagic), indexMagic, sizeof(indexMagic)) != 0) {
+        return -3;
+    }
+    const uint8_t* trailer = buf + bufSize - TRACK_TRAILER_SIZE;
+    uint64_t indexOffset;
+    uint32_t count;
+    memcpy(&indexOffset, trailer, sizeof(indexOffset));
+    memcpy(&count, trailer + 8, sizeof(count));
+    if(indexOffset > bufSize - TRACK_TRAILER_SIZE
+        || (bufSize - TRACK_TRAILER_SIZE - indexOffset) != (uint64_t)count * sizeof(NMEATrackBlockInfo)
+        || indexOffset % 8 != 0) {
+        return -3;
+    }
+    data = buf;
+    size = bufSize;
+    index = (const NMEATrackBlockInfo*)(buf + indexOffset);
+    numBlocks = count;
+    maxKeyUpTo.resize(count);
+    minKeyFrom.resize(count);
+    uint64_t maxKey = 0;
+    for (size_t i = 0; i < count; ++i) {
+        maxKey = max(maxKey, index[i].maxKey);
+        maxKeyUpTo[i] = maxKey;
+    }
+    uint64_t minKey = NMEA_TIME_KEY_INVALID;
+    for (size_t i = count; i-- > 0;) {
+        minKey = min(minKey, index[i].minKey);
+        minKeyFrom[i] = minKey;
+    }
+    return 0;
+}
+
+void NMEATrackReader::close() {
+    if(mapped) {
+        munmap((void*)data, size);
+    }
+    data = NULL;
+    size = 0;
+    mapped = false;
+    index = NULL;
+    numBlocks = 0;
+    maxKeyUpTo.clear();
+    minKeyFrom.clear();
+}
+
+uint64_t NMEATrackReader::getNumFixes() const {
+    uint64_t n = 0;
+    for (size_t i = 0; i < numBlocks; ++i) {
+        n += index[i].numFixes;
+    }
+    return n;
+}
+
+int NMEATrackReader::decodeBlock(size_t idx, RMCSentence* out) const {
+    const NMEATrackBlockInfo& info = index[idx];
+    if(info.offset + TRACK_BLOCK_HEADER_SIZE + info.size > size) {
+        return -1;
+    }
+    const uint8_t* pos = data + info.offset + TRACK_BLOCK_HEADER_SIZE;
+    const uint8_t* end = pos + info.size;
+    for (int column = 0; column < NMEA_TRACK_NUM_COLUMNS; ++column) {
+        int64_t value = 0;
+        for (uint32_t i = 0; i < info.numFixes; ++i) {
+            uint64_t delta;
+            pos = getVarint(pos, end, &delta);
+            if(pos == NULL) {
+                return -1;
+            }
+            value += zigzagDecode(delta);
+            setTrackColumn(&out[i], column, (int32_t)value);
+        }
+    }
+    return (int)info.numFixes;
+}
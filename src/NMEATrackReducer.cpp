@@ -0,0 +1,134 @@
+#include "NMEATrackReducer.h"
+#include "NMEAGeo.h"
+
+#include <cmath>
+#include <cstring>
+
+/**
+ * Mean earth radius. The local plane does not need the ellipsoid.
+ */
+#define REDUCER_EARTH_RADIUS 6371008.8
+/**
+ * Meters per 1e-7 degrees of latitude
+ */
+static const double metersPerDegreeLatitude = REDUCER_EARTH_RADIUS * M_PI / 180.0 / 1e7;
+
+NMEATrackReducer::NMEATrackReducer(double toleranceMeters, double dedupMeters, uint32_t minIntervalMs)
+    : tolerance(toleranceMeters), dedupDistance(dedupMeters),
+      minInterval((int64_t)minIntervalMs * 1000000) {
+    memset(&stats, 0, sizeof(stats));
+    reset();
+}
+
+void NMEATrackReducer::reset() {
+    epoch.reset();
+    hasLast = false;
+    lastTime = NMEA_EPOCH_INVALID;
+    hasAnchor = false;
+    anchorLatitude = anchorLongitude = 0;
+    metersPerDegreeLongitude = 0;
+    windowSize = 0;
+}
+
+void NMEATrackReducer::setAnchor(const RMCSentence& fix) {
+    hasAnchor = true;
+    anchorLatitude = nmeaCoordinateToDegrees(fix.position.latitude);
+    anchorLongitude = nmeaCoordinateToDegrees(fix.position.longitude);
+    metersPerDegreeLongitude = metersPerDegreeLatitude * cos(anchorLatitude * (M_PI / 180.0 / 1e7));
+}
+
+void NMEATrackReducer::project(const RMCSentence& fix, double* x, double* y) const {
+    int64_t dLon = (int64_t)nmeaCoordinateToDegrees(fix.position.longitude) - anchorLongitude;
+    //Shortest way across the antimeridian
+    if(dLon > 1800000000) {
+        dLon -= 3600000000ll;
+    } else if(dLon < -1800000000) {
+        dLon += 3600000000ll;
+    }
+    *x = dLon * metersPerDegreeLongitude;
+    *y = ((int64_t)nmeaCoordinateToDegrees(fix.position.latitude) - anchorLatitude) * metersPerDegreeLatitude;
+}
+
+bool NMEATrackReducer::fitsLine(double x, double y) const {
+    //Distance to the segment from the anchor (0, 0) to (x, y)
+    double lengthSquared = x * x + y * y;
+    double toleranceSquared = tolerance * tolerance;
+    for (size_t i = 0; i < windowSize; ++i) {
+        const Point& p = window[i];
+        double t = lengthSquared > 0 ? (p.x * x + p.y * y) / lengthSquared : 0;
+        t = t < 0 ? 0 : (t > 1 ? 1 : t);
+        double dx = p.x - t * x, dy = p.y - t * y;
+        if(dx * dx + dy * dy > toleranceSquared) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void NMEATrackReducer::emitLast(RMCSentence* out) {
+    *out = window[windowSize - 1].fix;
+    stats.simplified += windowSize - 1;
+    stats.output++;
+    windowSize = 0;
+    setAnchor(*out);
+}
+
+int NMEATrackReducer::add(const RMCSentence& fix, RMCSentence* out) {
+    stats.input++;
+    if(fix.position.latitude == INT32_MAX || fix.position.longitude == INT32_MAX) {
+        stats.invalid++;
+        return -1;
+    }
+    int64_t time = epoch.toEpochNs(fix.date, fix.utcTime);
+    if(hasLast) {
+        if(dedupDistance <= 0) {
+            if(fix.position.latitude == last.position.latitude && fix.position.longitude == last.position.longitude) {
+                stats.duplicates++;
+                return 0;
+            }
+        } else {
+            double x, y, lastX, lastY;
+            project(fix, &x, &y);
+            project(last, &lastX, &lastY);
+            if((x - lastX) * (x - lastX) + (y - lastY) * (y - lastY) < dedupDistance * dedupDistance) {
+                stats.duplicates++;
+                return 0;
+            }
+        }
+        if(minInterval > 0 && time != NMEA_EPOCH_INVALID && lastTime != NMEA_EPOCH_INVALID
+            && time - lastTime < minInterval) {
+            stats.rateLimited++;
+            return 0;
+        }
+    }
+    hasLast = true;
+    last = fix;
+    lastTime = time;
+    if(!hasAnchor) {
+        setAnchor(fix);
+        stats.output++;
+        *out = fix;
+        return 1;
+    }
+    Point p;
+    p.fix = fix;
+    project(fix, &p.x, &p.y);
+    if(windowSize < NMEA_REDUCER_WINDOW && fitsLine(p.x, p.y)) {
+        window[windowSize++] = p;
+        return 0;
+    }
+    emitLast(out);
+    //The new fix starts the next line
+    window[0].fix = fix;
+    project(fix, &window[0].x, &window[0].y);
+    windowSize = 1;
+    return 1;
+}
+
+int NMEATrackReducer::flush(RMCSentence* out) {
+    if(windowSize == 0) {
+        return 0;
+    }
+    emitLast(out);
+    return 1;
+}
@@ -3,10 +3,48 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <sstream>
+#include <algorithm>
+#include <map>
+#include <ctime>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
 
 #include "NMEA.h"
 #include "NMEASentences.h"
 #include "NMEASentenceOperators.h"
+#include "NMEAFramer.h"
+#include "NMEAIndex.h"
+#include "NMEABatch.h"
+#include "NMEAReplay.h"
+#include "NMEADispatch.h"
+#include "NMEACorpus.h"
+#include "GSVAssembler.h"
+#include "EpochAggregator.h"
+#include "SeqLock.h"
+#include "UBX.h"
+#include "NMEAUBXFramer.h"
+#include "NMEAEncoder.h"
+#include "NMEAFormat.h"
+#include "NMEATrack.h"
+#include "NMEASeekIndex.h"
+#include "NMEAIngest.h"
+#include "NMEARing.h"
+#include "UBlox.h"
+#include "NMEAStats.h"
+#include "NMEASentenceSchemas.h"
+#include "NMEATime.h"
+#include "NMEAGeo.h"
+#include "NMEATrackReducer.h"
+#include "NMEAGeofence.h"
 
 using namespace std;
 
@@ -113,4 +151,2148 @@ BOOST_AUTO_TEST_CASE(TestParseGSVSentence)
     BOOST_CHECK_EQUAL(ref, pos);
 }
 
+BOOST_AUTO_TEST_CASE(TestParseGGASentence)
+{
+    GGASentence pos, ref = {9272500, {471711399, 83391590}, 1, 8, 101, 499600, 48000};
+    const char* msg = "$GPGGA,092725.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,*5B";
+    BOOST_CHECK_EQUAL(0, parseGGASentence(msg, &pos));
+    BOOST_CHECK_EQUAL(ref, pos);
+    //Negative altitude, no HDOP
+    ref = {9272500, {-471711399, -83391590}, 2, 12, INT32_MAX, -12500, -3000};
+    msg = "$GPGGA,092725.00,4717.11399,S,00833.91590,W,2,12,,-12.5,M,-3.0,M,,*5B";
+    BOOST_CHECK_EQUAL(0, parseGGASentence(msg, &pos));
+    BOOST_CHECK_EQUAL(ref, pos);
+    //Errors
+    BOOST_CHECK_EQUAL(-4, parseGGASentence("$GPGGA,092725.00,4717.11399,X,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,", &pos));
+    BOOST_CHECK_EQUAL(-7, parseGGASentence("$GPGGA,092725.00,4717.11399,N,00833.91590,E,,08,1.01,499.6,M,48.0,M,,", &pos));
+    BOOST_CHECK_EQUAL(-1, parseGGASentence("$GPGGA,092725.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M", &pos));
+}
+
+BOOST_AUTO_TEST_CASE(TestParseGSASentence)
+{
+    GSASentence pos, ref = {'A', 3, {23, 29, 7, 8, 9, 18, 26, 28, INT32_MAX, INT32_MAX, INT32_MAX, INT32_MAX},
+                            194, 118, 154, INT32_MAX};
+    const char* msg = "$GPGSA,A,3,23,29,07,08,09,18,26,28,,,,,1.94,1.18,1.54*0D";
+    BOOST_CHECK_EQUAL(0, parseGSASentence(msg, &pos));
+    BOOST_CHECK_EQUAL(ref, pos);
+    //NMEA 4.10 system ID
+    ref.systemId = 1;
+    msg = "$GNGSA,A,3,23,29,07,08,09,18,26,28,,,,,1.94,1.18,1.54,1*0D";
+    BOOST_CHECK_EQUAL(0, parseGSASentence(msg, &pos));
+    BOOST_CHECK_EQUAL(ref, pos);
+    BOOST_CHECK_EQUAL(-2, parseGSASentence("$GPGSA,X,3,,,,,,,,,,,,,,,", &pos));
+    BOOST_CHECK_EQUAL(-1, parseGSASentence("$GPGSA,A,1,,,,,", &pos));
+}
+
+BOOST_AUTO_TEST_CASE(TestParseVTGSentence)
+{
+    VTGSentence pos, ref = {77520, INT32_MAX, 4, 8, 'A'};
+    const char* msg = "$GPVTG,77.52,T,,M,0.004,N,0.008,K,A*06";
+    BOOST_CHECK_EQUAL(0, parseVTGSentence(msg, &pos));
+    BOOST_CHECK_EQUAL(ref, pos);
+    BOOST_CHECK_EQUAL(-2, parseVTGSentence("$GPVTG,77.52,T,,M,0.004,N,0.008,K,X", &pos));
+    BOOST_CHECK_EQUAL(-1, parseVTGSentence("$GPVTG,77.52,T,,M,0.004,N,0.008,K", &pos));
+}
+
+BOOST_AUTO_TEST_CASE(TestParseZDASentence)
+{
+    ZDASentence pos, ref = {8271000, 16, 9, 2002, 0, 0};
+    const char* msg = "$GPZDA,082710.00,16,09,2002,00,00*64";
+    BOOST_CHECK_EQUAL(0, parseZDASentence(msg, &pos));
+    BOOST_CHECK_EQUAL(ref, pos);
+    ref = {8271000, 16, 9, 2002, -5, 30};
+    msg = "$GPZDA,082710.00,16,09,2002,-05,30*64";
+    BOOST_CHECK_EQUAL(0, parseZDASentence(msg, &pos));
+    BOOST_CHECK_EQUAL(ref, pos);
+    BOOST_CHECK_EQUAL(-5, parseZDASentence("$GPZDA,082710.00,16,09,,00,00", &pos));
+}
+
+BOOST_AUTO_TEST_CASE(TestParseGSTSentence)
+{
+    GSTSentence pos, ref = {8235600, 1800, INT32_MAX, INT32_MAX, INT32_MAX, 1700, 1300, 2200};
+    const char* msg = "$GPGST,082356.00,1.8,,,,1.7,1.3,2.2*7E";
+    BOOST_CHECK_EQUAL(0, parseGSTSentence(msg, &pos));
+    BOOST_CHECK_EQUAL(ref, pos);
+    BOOST_CHECK_EQUAL(-2, parseGSTSentence("$GPGST,,1.8,,,,1.7,1.3,2.2", &pos));
+}
+
+
+
+BOOST_AUTO_TEST_CASE(TestNMEAFramer)
+{
+    NMEAFramer framer;
+    vector<string> sentences;
+    auto collect = [&](const char* sentence, size_t size) {
+        sentences.push_back(string(sentence, size));
+    };
+    //Garbage, one complete sentence and the start of a second one
+    const char* chunk1 = "xx\r\n$GPGLL,4753.95225,N*00\r\n$GPRMC,0835";
+    BOOST_CHECK_EQUAL(1, framer.feed(chunk1, strlen(chunk1), collect));
+    BOOST_CHECK(framer.hasPartialSentence());
+    //Rest of the second sentence, split within \r\n
+    const char* chunk2 = "59.00,A*00\r";
+    BOOST_CHECK_EQUAL(0, framer.feed(chunk2, strlen(chunk2), collect));
+    BOOST_CHECK_EQUAL(1, framer.feed("\n", 1, collect));
+    BOOST_CHECK(!framer.hasPartialSentence());
+    //Truncated sentence followed by a new one resynchronizes
+    const char* chunk3 = "$GPGSV,3,1$GPGSV,3,1,10*7F\r\n$GP";
+    BOOST_CHECK_EQUAL(1, framer.feed(chunk3, strlen(chunk3), collect));
+    const char* chunk4 = "GSV$GPGSV,3,2,10*7F\r\n";
+    BOOST_CHECK_EQUAL(1, framer.feed(chunk4, strlen(chunk4), collect));
+    //Missing \r is rejected
+    BOOST_CHECK_EQUAL(0, framer.feed("$GPGLL*00\n", 10, collect));
+    BOOST_CHECK_EQUAL(2, framer.getResyncs());
+    BOOST_CHECK_EQUAL(4 + 10 + 6 + 10, framer.getDroppedBytes());
+    BOOST_REQUIRE_EQUAL(4, sentences.size());
+    BOOST_CHECK_EQUAL("$GPGLL,4753.95225,N*00\r\n", sentences[0]);
+    BOOST_CHECK_EQUAL("$GPRMC,083559.00,A*00\r\n", sentences[1]);
+    BOOST_CHECK_EQUAL("$GPGSV,3,1,10*7F\r\n", sentences[2]);
+    BOOST_CHECK_EQUAL("$GPGSV,3,2,10*7F\r\n", sentences[3]);
+}
+
+/**
+ * In-memory stand-in for a serial port, used to compare
+ * the per-byte ubloxReadLine() loop to NMEAFramer.
+ */
+struct MemoryPort {
+    const char* data;
+    size_t size;
+    size_t pos;
+};
+
+static size_t __attribute__((noinline)) memoryPortRead(MemoryPort* port, char* buf, size_t size) {
+    size_t n = std::min(size, port->size - port->pos);
+    memcpy(buf, port->data + port->pos, n);
+    port->pos += n;
+    return n;
+}
+
+/**
+ * Per-byte read loop equivalent to ubloxReadLine()
+ */
+static size_t perByteReadLine(MemoryPort* port, char* rxbuf, size_t bufsize) {
+    for(size_t i = 0; i < (bufsize - 1); i++) {
+        if(memoryPortRead(port, &rxbuf[i], 1) == 0) {
+            return 0;
+        }
+        if(i == 0 && rxbuf[0] != '$') {
+            return 0;
+        }
+        if(rxbuf[i] == '\n') {
+            if(i < 3 || rxbuf[i - 1] != '\r') {
+                return 0;
+            }
+            rxbuf[i + 1] = '\0';
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEAFramerThroughput)
+{
+    string corpus;
+    for (int i = 0; i < 20000; ++i) {
+        corpus += "$GPRMC,083559.00,A,4717.11437,N,00833.91522,E,0.004,77.52,091202,,,A*57\r\n";
+        corpus += "$GPGSV,3,1,10,23,38,230,44,29,71,156,47,07,29,116,41,08,09,081,36*7F\r\n";
+    }
+    //Per-byte loop
+    MemoryPort port = {corpus.data(), corpus.size(), 0};
+    char rxbuf[256];
+    size_t perByteCount = 0, perByteBytes = 0;
+    auto t0 = chrono::steady_clock::now();
+    while(port.pos < port.size) {
+        size_t size = perByteReadLine(&port, rxbuf, sizeof(rxbuf));
+        perByteCount += (size != 0);
+        perByteBytes += size;
+    }
+    auto t1 = chrono::steady_clock::now();
+    //Framer with bulk reads
+    port.pos = 0;
+    NMEAFramer framer;
+    char chunk[4096];
+    size_t framerCount = 0, framerBytes = 0;
+    while(port.pos < port.size) {
+        size_t n = memoryPortRead(&port, chunk, sizeof(chunk));
+        framerCount += framer.feed(chunk, n, [&](const char*, size_t size) {
+            framerBytes += size;
+        });
+    }
+    auto t2 = chrono::steady_clock::now();
+    BOOST_CHECK_EQUAL(40000, perByteCount);
+    BOOST_CHECK_EQUAL(perByteCount, framerCount);
+    BOOST_CHECK_EQUAL(perByteBytes, framerBytes);
+    BOOST_CHECK_EQUAL(0, framer.getDroppedBytes());
+    double perByteMBs = corpus.size() / chrono::duration<double>(t1 - t0).count() / 1e6;
+    double framerMBs = corpus.size() / chrono::duration<double>(t2 - t1).count() / 1e6;
+    BOOST_TEST_MESSAGE("Per-byte read loop: " << perByteMBs << " MB/s, NMEAFramer: " << framerMBs << " MB/s");
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEAIndex)
+{
+    const char* buf = "garbage,*\n$GPGLL,4753.95225,N,01007.36179,E,133017.00,A,A*6E\r\n"
+                      "$GPGSV,3,1,10\r\n$GPRMC,0835$GPZDA,082710.00,16,09,2002,00,00*64\r\n$GPRMC,08";
+    uint32_t structurals[64];
+    NMEASentenceRecord sentences[8];
+    NMEAStructuralIndex index = {structurals, 64, 0, sentences, 8, 0};
+    size_t consumed = indexNMEABuffer(buf, strlen(buf), &index);
+    BOOST_CHECK_EQUAL(strlen(buf) - strlen("$GPRMC,08"), consumed);
+    BOOST_REQUIRE_EQUAL(3, index.numSentences);
+    //GLL
+    BOOST_CHECK_EQUAL('$', buf[sentences[0].start]);
+    BOOST_CHECK_EQUAL('*', buf[sentences[0].checksumPos]);
+    BOOST_CHECK_EQUAL('\n', buf[sentences[0].end]);
+    BOOST_CHECK_EQUAL(0x6E, sentences[0].checksum);
+    BOOST_CHECK_EQUAL(0, strncmp(buf + getNMEAFieldOffset(&index, &sentences[0], 0), "GPGLL,", 6));
+    BOOST_CHECK_EQUAL(475395225, parseNMEACoordinate(buf + getNMEAFieldOffset(&index, &sentences[0], 1)));
+    BOOST_CHECK_EQUAL('A', buf[getNMEAFieldOffset(&index, &sentences[0], 7)]);
+    BOOST_CHECK_EQUAL(UINT32_MAX, getNMEAFieldOffset(&index, &sentences[0], 8));
+    //GSV without checksum
+    BOOST_CHECK_EQUAL(UINT32_MAX, sentences[1].checksumPos);
+    BOOST_CHECK_EQUAL(0, sentences[1].checksum);
+    BOOST_CHECK_EQUAL('1', buf[getNMEAFieldOffset(&index, &sentences[1], 2)]);
+    //ZDA after the interrupted RMC
+    BOOST_CHECK_EQUAL(0x64, sentences[2].checksum);
+    BOOST_CHECK_EQUAL(0, strncmp(buf + sentences[2].start, "$GPZDA", 6));
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEAIndexProgress)
+{
+    uint32_t structurals[16];
+    NMEASentenceRecord sentences[4];
+    NMEAStructuralIndex index = {structurals, 16, 0, sentences, 4, 0};
+    //No sentence at all
+    const char* garbage = "garbage,*\n,,,\r\n";
+    BOOST_CHECK_EQUAL(strlen(garbage), indexNMEABuffer(garbage, strlen(garbage), &index));
+    BOOST_CHECK_EQUAL(0, index.numSentences);
+    BOOST_CHECK_EQUAL(0, index.numStructurals);
+    //Garbage before an incomplete sentence
+    const char* incomplete = "garbage,*\n$GPRMC,08";
+    BOOST_CHECK_EQUAL(strlen("garbage,*\n"), indexNMEABuffer(incomplete, strlen(incomplete), &index));
+    BOOST_CHECK_EQUAL(0, index.numSentences);
+    //A first sentence that does not fit into the structurals array is skipped
+    string buf = "xx$GPGSV,3,1,10,01,02,03,04,05,06,07,08,09,10,11,12,13,14,15,16*00\r\n"
+                 "garbage,\n$GPGSV,3,1,10\r\n$GPGSV,3,1";
+    size_t second = buf.find("$GPGSV,3,1,10\r");
+    size_t consumed = indexNMEABuffer(buf.data(), buf.size(), &index);
+    BOOST_CHECK_EQUAL(second, consumed);
+    BOOST_CHECK_EQUAL(0, index.numSentences);
+    consumed += indexNMEABuffer(buf.data() + consumed, buf.size() - consumed, &index);
+    BOOST_REQUIRE_EQUAL(1, index.numSentences);
+    BOOST_CHECK_EQUAL(0, sentences[0].start);
+    BOOST_CHECK_EQUAL(buf.rfind('$'), consumed);
+    //Garbage filling the structurals array does not skip the following sentence
+    const char* commas = ",,,,,,,,,,,,,,$GPGSV,3,1,10\r\n";
+    consumed = indexNMEABuffer(commas, strlen(commas), &index);
+    BOOST_CHECK_EQUAL(14u, consumed);
+    BOOST_CHECK_EQUAL(0, index.numSentences);
+    BOOST_CHECK_EQUAL(strlen(commas) - 14, indexNMEABuffer(commas + 14, strlen(commas) - 14, &index));
+    BOOST_REQUIRE_EQUAL(1, index.numSentences);
+    BOOST_CHECK_EQUAL(0, strncmp(commas + 14 + sentences[0].start, "$GPGSV", 6));
+    //Also without a following sentence
+    string oversized = buf.substr(0, buf.find("garbage"));
+    BOOST_CHECK_EQUAL(oversized.size(), indexNMEABuffer(oversized.data(), oversized.size(), &index));
+    BOOST_CHECK_EQUAL(0, index.numSentences);
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEAIndexImplementations)
+{
+    //Random sentences and garbage, so that all block and tail paths are hit
+    string corpus;
+    srand(1234);
+    const char alphabet[] = "$,*\r\nGPRMC0123456789.ANEW";
+    for (int i = 0; i < 20000; ++i) {
+        corpus += alphabet[rand() % (sizeof(alphabet) - 1)];
+    }
+    NMEAIndexImplementation defaultImpl = getNMEAIndexImplementation();
+    vector<uint32_t> refStructurals(corpus.size()), structurals(corpus.size());
+    vector<NMEASentenceRecord> refSentences(corpus.size()), sentences(corpus.size());
+    BOOST_REQUIRE_EQUAL(0, setNMEAIndexImplementation(NMEAIndexScalar));
+    NMEAStructuralIndex ref = {refStructurals.data(), refStructurals.size(), 0,
+                               refSentences.data(), refSentences.size(), 0};
+    indexNMEABuffer(corpus.data(), corpus.size(), &ref);
+    BOOST_CHECK(ref.numSentences > 100);
+    for (size_t i = 0; i < ref.numSentences; ++i) {
+        const NMEASentenceRecord& rec = refSentences[i];
+        if(rec.checksumPos != UINT32_MAX) {
+            BOOST_CHECK_EQUAL(computeNMEAChecksum(corpus.data() + rec.start, rec.checksumPos - rec.start + 1), rec.checksum);
+        }
+    }
+    const NMEAIndexImplementation impls[] = {NMEAIndexSSE2, NMEAIndexAVX2, NMEAIndexNEON};
+    for (NMEAIndexImplementation impl : impls) {
+        if(!isNMEAIndexImplementationSupported(impl)) {
+            BOOST_CHECK_EQUAL(-1, setNMEAIndexImplementation(impl));
+            continue;
+        }
+        BOOST_REQUIRE_EQUAL(0, setNMEAIndexImplementation(impl));
+        //Also exercise the early stop when the structurals array is full
+        for (size_t maxStructurals : {structurals.size(), (size_t)1000, (size_t)63}) {
+            NMEAStructuralIndex index = {structurals.data(), maxStructurals, 0,
+                                         sentences.data(), sentences.size(), 0};
+            NMEAStructuralIndex refIndex = {refStructurals.data(), maxStructurals, 0,
+                                            refSentences.data(), refSentences.size(), 0};
+            setNMEAIndexImplementation(NMEAIndexScalar);
+            size_t expectedConsumed = indexNMEABuffer(corpus.data(), corpus.size(), &refIndex);
+            setNMEAIndexImplementation(impl);
+            BOOST_CHECK_EQUAL(expectedConsumed, indexNMEABuffer(corpus.data(), corpus.size(), &index));
+            BOOST_REQUIRE_EQUAL(refIndex.numStructurals, index.numStructurals);
+            BOOST_REQUIRE_EQUAL(refIndex.numSentences, index.numSentences);
+            BOOST_CHECK(0 == memcmp(refStructurals.data(), structurals.data(), index.numStructurals * sizeof(uint32_t)));
+            for (size_t i = 0; i < index.numSentences; ++i) {
+                BOOST_CHECK_EQUAL(refSentences[i].checksum, sentences[i].checksum);
+                BOOST_CHECK_EQUAL(refSentences[i].end, sentences[i].end);
+            }
+        }
+    }
+    setNMEAIndexImplementation(defaultImpl);
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEASentenceView)
+{
+    const char* msg = "$GPRMC,083559.00,A,4717.11437,N,00833.91522,E,0.004,77.52,091202,,,A*57\r\n";
+    NMEASentenceView view(msg);
+    BOOST_CHECK_EQUAL(13, view.numFields());
+    BOOST_CHECK_EQUAL(5, view.fieldSize(0));
+    BOOST_CHECK_EQUAL(0, strncmp("GPRMC", view.field(0), 5));
+    BOOST_CHECK_EQUAL(8355900, view.utcTime(1));
+    BOOST_CHECK_EQUAL('A', view.character(2));
+    BOOST_CHECK_EQUAL(471711437, view.coordinate(3));
+    BOOST_CHECK_EQUAL(4, view.fixedPoint(7, 3));
+    BOOST_CHECK_EQUAL(91202, view.integer(9));
+    BOOST_CHECK_EQUAL(0, view.fieldSize(10));
+    BOOST_CHECK_EQUAL('\0', view.character(10));
+    BOOST_CHECK_EQUAL(INT32_MAX, view.integer(10));
+    BOOST_CHECK_EQUAL('A', view.character(12));
+    BOOST_CHECK(view.field(13) == NULL);
+    BOOST_CHECK_EQUAL(INT32_MAX, view.integer(13));
+    //Size-delimited, not NUL-terminated: Must not read beyond the given size
+    const char* gsv = "$GPGSV,3,1,10,23,38$GPGSV,3,2,10";
+    NMEASentenceView sized(gsv, 19);
+    BOOST_CHECK_EQUAL(6, sized.numFields());
+    BOOST_CHECK_EQUAL(38, sized.integer(5));
+    GSVSentence gsvResult;
+    BOOST_CHECK_EQUAL(-1, parseGSVSentence(sized, &gsvResult));
+    //Parsing via the view is equivalent to parsing the string
+    RMCSentence fromView, fromString;
+    BOOST_CHECK_EQUAL(0, parseRMCSentence(view, &fromView));
+    BOOST_CHECK_EQUAL(0, parseRMCSentence(msg, &fromString));
+    BOOST_CHECK_EQUAL(fromString, fromView);
+    //Truncated sentences
+    BOOST_CHECK_EQUAL(-1, parseRMCSentence("$GPRMC,083559.00,A,4717.11437,N*57", &fromView));
+    NMEAPosition position;
+    BOOST_CHECK_EQUAL(-2, parseGLLSentence("$GPGLL,4753.95225X,N", &position));
+    BOOST_CHECK_EQUAL(-1, parseGLLSentence("$GPGLL,4753.95225,N", &position));
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEAChecksumVerification)
+{
+    const char* msg = "$GPGSV,3,1,10,23,38,230,44,29,71,156,47,07,29,116,41,08,09,081,36*7F\r\n";
+    BOOST_CHECK_EQUAL(0, checkNMEAChecksum(msg, strlen(msg)));
+    BOOST_CHECK_EQUAL(0, checkNMEAChecksum("$PUBX,00*33", 11));
+    BOOST_CHECK_EQUAL(-2, checkNMEAChecksum("$PUBX,00*34", 11));
+    BOOST_CHECK_EQUAL(-1, checkNMEAChecksum("$PUBX,00*3", 10));
+    BOOST_CHECK_EQUAL(-1, checkNMEAChecksum("$PUBX,00", 8));
+}
+
+BOOST_AUTO_TEST_CASE(TestParseNMEAFixBatch)
+{
+    const char* buf =
+        "$GPRMC,083559.00,A,4717.11437,N,00833.91522,E,0.004,77.52,091202,,,A*57\r\n"
+        "$GPGSV,3,1,10,23,38,230,44,29,71,156,47,07,29,116,41,08,09,081,36*7F\r\n"
+        "$GNGLL,4753.95225,S,01007.36179,E,133017.00,A,A*6D\r\n"
+        "$GPRMC,083559.00,A,4717.11437,N,00833.91522,E,0.004,77.52,091202,,,A*58\r\n"
+        "$GNRMC,083600.00,V,4717.11437,N,00833.91522,E,,,091202,,,N\r\n"
+        "$GPRMC,0836";
+    uint32_t utcTime[4];
+    int32_t latitude[4], longitude[4], speed[4], course[4], date[4];
+    uint8_t status[4];
+    NMEAFixColumns columns = {utcTime, latitude, longitude, speed, course, date, status, 4};
+    size_t consumed;
+    BOOST_REQUIRE_EQUAL(4, parseNMEAFixBatch(buf, strlen(buf), &columns, &consumed));
+    BOOST_CHECK_EQUAL(strlen(buf) - strlen("$GPRMC,0836"), consumed);
+    //RMC
+    BOOST_CHECK_EQUAL(NMEA_ROW_RMC | NMEA_ROW_VALID | NMEA_ROW_FIX, status[0]);
+    BOOST_CHECK_EQUAL(8355900, utcTime[0]);
+    BOOST_CHECK_EQUAL(471711437, latitude[0]);
+    BOOST_CHECK_EQUAL(83391522, longitude[0]);
+    BOOST_CHECK_EQUAL(4, speed[0]);
+    BOOST_CHECK_EQUAL(77520, course[0]);
+    BOOST_CHECK_EQUAL(91202, date[0]);
+    //GLL from another talker
+    BOOST_CHECK_EQUAL(NMEA_ROW_GLL | NMEA_ROW_VALID | NMEA_ROW_FIX, status[1]);
+    BOOST_CHECK_EQUAL(13301700, utcTime[1]);
+    BOOST_CHECK_EQUAL(-475395225, latitude[1]);
+    BOOST_CHECK_EQUAL(INT32_MAX, speed[1]);
+    //Wrong checksum
+    BOOST_CHECK_EQUAL(NMEA_ROW_RMC | NMEA_ROW_CHECKSUM_ERROR, status[2]);
+    BOOST_CHECK_EQUAL(INT32_MAX, latitude[2]);
+    //Empty speed field fails to parse
+    BOOST_CHECK_EQUAL(NMEA_ROW_RMC, status[3]);
+    //Only status column
+    columns = {NULL, NULL, NULL, NULL, NULL, NULL, status, 4};
+    BOOST_CHECK_EQUAL(1, parseNMEAFixBatch(buf + consumed - 60, 60, &columns, NULL));
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEAReplayEngine)
+{
+    //Capture with varying sentence lengths so chunk boundaries fall everywhere
+    string capture;
+    for (int i = 0; i < 5000; ++i) {
+        char line[128];
+        snprintf(line, sizeof(line), "$GPRMC,%06d.00,A,4717.%05d,N,00833.91522,E,0.004,77.52,091202,,,A\r\n", i, i);
+        capture += line;
+        capture += "$GPGSV,3,1,10,23,38,230,44,29,71,156,47\r\n";
+        if(i % 7 == 0) {
+            capture += "$GNGLL,4753.95225,S,01007.36179,E,133017.00,A,A\r\n$GPTXT,garbage\r\n";
+        }
+        if(i % 11 == 0) {
+            capture += "$GPRMC,broken\r\n";
+        }
+    }
+    char filename[] = "/tmp/nmeareplayXXXXXX";
+    int fd = mkstemp(filename);
+    BOOST_REQUIRE(fd >= 0);
+    BOOST_REQUIRE_EQUAL(capture.size(), write(fd, capture.data(), capture.size()));
+    close(fd);
+    //Single-threaded reference
+    vector<NMEAReplayRecord> reference;
+    NMEAReplayEngine(1, capture.size()).replayBuffer(capture.data(), capture.size(),
+        [&](const NMEAReplayRecord& record) { reference.push_back(record); }, NULL);
+    BOOST_CHECK_EQUAL(5000 + 5000 + 715, reference.size());
+    //Multi-threaded with small chunks
+    NMEAReplayEngine engine(4, 1000);
+    vector<NMEAReplayRecord> records;
+    NMEAReplayStats stats;
+    BOOST_REQUIRE_EQUAL(0, engine.replayFile(filename, [&](const NMEAReplayRecord& record) {
+        records.push_back(record);
+    }, &stats));
+    unlink(filename);
+    BOOST_CHECK_EQUAL(capture.size(), stats.bytes);
+    BOOST_CHECK_EQUAL(5000 + 5000 + 715 + 455, stats.sentences);
+    BOOST_CHECK_EQUAL(455, stats.parseErrors);
+    BOOST_REQUIRE_EQUAL(reference.size(), records.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(reference[i].offset, records[i].offset);
+        BOOST_REQUIRE_EQUAL(reference[i].sentence.type, records[i].sentence.type);
+        if(records[i].sentence.type == NMEASentenceRMC) {
+            BOOST_REQUIRE_EQUAL(reference[i].sentence.rmc, records[i].sentence.rmc);
+        }
+    }
+    BOOST_CHECK_EQUAL(-1, NMEAReplayEngine().replayFile("/nonexistent", NULL, NULL));
+    BOOST_TEST_MESSAGE("Replay: " << stats.sentencesPerSecond() << " sentences/s, "
+        << stats.bytesPerSecond() / 1e6 << " MB/s");
+}
+
+BOOST_AUTO_TEST_CASE(TestDispatchNMEASentence)
+{
+    BOOST_CHECK_EQUAL(NMEASentenceGLL, getNMEASentenceType("$GPGLL,", 7));
+    BOOST_CHECK_EQUAL(NMEASentenceRMC, getNMEASentenceType("$GNRMC,", 7));
+    BOOST_CHECK_EQUAL(NMEASentenceGSV, getNMEASentenceType("$GAGSV,", 7));
+    BOOST_CHECK_EQUAL(NMEASentenceGSV, getNMEASentenceType("$GBGSV*00", 9));
+    BOOST_CHECK_EQUAL(NMEASentenceZDA, getNMEASentenceType("$GPZDA,", 7));
+    BOOST_CHECK_EQUAL(NMEASentenceUnknown, getNMEASentenceType("$GPTXT,", 7));
+    BOOST_CHECK_EQUAL(NMEASentenceUnknown, getNMEASentenceType("$PUBX,00", 8));
+    BOOST_CHECK_EQUAL(NMEASentenceUnknown, getNMEASentenceType("$GPRMCX,", 8));
+    BOOST_CHECK_EQUAL(NMEASentenceUnknown, getNMEASentenceType("$GPRM", 5));
+    //Parse any talker
+    NMEAParsedSentence result;
+    const char* msg = "$GLGSV,3,1,10,23,38,230,44,29,71,156,47*7F\r\n";
+    BOOST_CHECK_EQUAL(0, dispatchNMEASentence(msg, strlen(msg), NMEA_TYPE_MASK_ALL, &result));
+    BOOST_CHECK_EQUAL(NMEASentenceGSV, result.type);
+    BOOST_CHECK_EQUAL('G', result.talker[0]);
+    BOOST_CHECK_EQUAL('L', result.talker[1]);
+    BOOST_CHECK_EQUAL(2, result.gsv.numSatInfos);
+    msg = "$GNRMC,083559.00,A,4717.11437,N,00833.91522,E,0.004,77.52,091202,,,A*57\r\n";
+    BOOST_CHECK_EQUAL(0, dispatchNMEASentence(msg, strlen(msg), NMEA_TYPE_MASK(NMEASentenceRMC), &result));
+    BOOST_CHECK_EQUAL(471711437, result.rmc.position.latitude);
+    //Disabled types are dropped
+    BOOST_CHECK_EQUAL(1, dispatchNMEASentence(msg, strlen(msg), NMEA_TYPE_MASK(NMEASentenceGLL), &result));
+    //Parser errors are passed through
+    msg = "$GNGLL,4753.95225X,N";
+    BOOST_CHECK_EQUAL(-2, dispatchNMEASentence(msg, strlen(msg), NMEA_TYPE_MASK_ALL, &result));
+}
+
+/**
+ * Reference implementations of the per-character integer
+ * and fixed point decoders (with wrap-around on overflow)
+ */
+static int32_t referenceParseNMEAInteger(const char* src) {
+    if(!isdigit(*src)) {
+        return INT32_MAX;
+    }
+    uint32_t ret = 0;
+    for(;*src != ',' && *src != '\0' && *src != '*';src++) {
+        if(!isdigit(*src)) {
+            return INT32_MAX;
+        }
+        ret = (ret * 10) + (*src - '0');
+    }
+    return (int32_t)ret;
+}
+
+static int32_t referenceParseNMEAFixedPointDecimal(const char* src, int decimals) {
+    if(!isdigit(*src)) {
+        return INT32_MAX;
+    }
+    uint32_t ret = 0;
+    int digitsSinceDot = -1;
+    for(;*src != ',' && *src != '\0' && *src != '*';src++) {
+        if(*src == '.') {
+            if(digitsSinceDot != -1) {
+                return INT32_MAX;
+            }
+            digitsSinceDot = 0;
+            continue;
+        }
+        if(!isdigit(*src)) {
+            return INT32_MAX;
+        }
+        ret = (ret * 10) + (*src - '0');
+        if(digitsSinceDot != -1) {
+            digitsSinceDot++;
+        }
+    }
+    if(digitsSinceDot == -1) {
+        return INT32_MAX;
+    }
+    while(digitsSinceDot++ < decimals) {
+        ret *= 10;
+    }
+    return (int32_t)ret;
+}
 
+/**
+ * Check all decoder variants for a string placed at every offset
+ * near the end of a page and at the end of a sized buffer.
+ */
+static void checkNumericDecoders(const string& str, char* page) {
+    for (size_t offset : {(size_t)0, (size_t)4096 - 8 - str.size(), (size_t)4096 - 1 - str.size(), (size_t)4093 - str.size()}) {
+        char* dst = page + offset;
+        memcpy(dst, str.c_str(), str.size() + 1);
+        int32_t refInt = referenceParseNMEAInteger(dst);
+        BOOST_REQUIRE_MESSAGE(refInt == parseNMEAInteger(dst), "parseNMEAInteger(\"" << str << "\")");
+        BOOST_REQUIRE_MESSAGE(refInt == parseNMEAInteger(dst, str.size()), "parseNMEAInteger(\"" << str << "\", size)");
+        for (int decimals : {0, 2, 3, 5}) {
+            int32_t refFixed = referenceParseNMEAFixedPointDecimal(dst, decimals);
+            BOOST_REQUIRE_MESSAGE(refFixed == parseNMEAFixedPointDecimal(dst, decimals),
+                "parseNMEAFixedPointDecimal(\"" << str << "\", " << decimals << ")");
+            BOOST_REQUIRE_MESSAGE(refFixed == parseNMEAFixedPointDecimal(dst, str.size(), decimals),
+                "parseNMEAFixedPointDecimal(\"" << str << "\", size, " << decimals << ")");
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestNumericDecodersEquivalence)
+{
+    vector<char> buf(3 * 4096);
+    //Page-aligned page followed by another accessible page
+    char* page = (char*)(((uintptr_t)buf.data() + 4095) & ~(uintptr_t)4095);
+    memset(page, 'x', 2 * 4096);
+    //Exhaustive over short strings
+    const char alphabet[] = {'0', '1', '9', '.', ',', '*', 'a', '/', ':', '\xB0'};
+    const size_t n = sizeof(alphabet);
+    string str;
+    for (size_t len = 0; len <= 4; ++len) {
+        size_t combinations = 1;
+        for (size_t i = 0; i < len; ++i) {
+            combinations *= n;
+        }
+        for (size_t c = 0; c < combinations; ++c) {
+            str.clear();
+            for (size_t i = 0, rest = c; i < len; ++i, rest /= n) {
+                str += alphabet[rest % n];
+            }
+            checkNumericDecoders(str, page);
+        }
+    }
+    //Fuzzed longer strings, mostly digits
+    srand(42);
+    for (int i = 0; i < 100000; ++i) {
+        str.clear();
+        size_t len = rand() % 24;
+        for (size_t j = 0; j < len; ++j) {
+            int r = rand() % 40;
+            str += r < 36 ? (char)('0' + r % 10) : alphabet[3 + r % 4];
+        }
+        checkNumericDecoders(str, page);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEACorpusGenerator)
+{
+    //Deterministic
+    BOOST_CHECK_EQUAL(NMEACorpusGenerator(7).generate(1000), NMEACorpusGenerator(7).generate(1000));
+    BOOST_CHECK(NMEACorpusGenerator(7).generate(10) != NMEACorpusGenerator(8).generate(10));
+    //Without empty fields and corrupt checksums, every sentence is valid
+    NMEACorpusGenerator generator(3, 0, 0);
+    char buf[128];
+    for (int i = 0; i < 10000; ++i) {
+        NMEASentenceType type;
+        size_t size = generator.next(buf, sizeof(buf), &type);
+        BOOST_REQUIRE(size > 0);
+        BOOST_REQUIRE_EQUAL(0, checkNMEAChecksum(buf, size));
+        NMEAParsedSentence result;
+        BOOST_REQUIRE_EQUAL(0, dispatchNMEASentence(buf, size, NMEA_TYPE_MASK_ALL, &result));
+        BOOST_REQUIRE_EQUAL(type, result.type);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestGSVAssembler)
+{
+    GSVAssembler assembler;
+    NMEAParsedSentence s;
+    auto add = [&](const char* msg) {
+        BOOST_REQUIRE_EQUAL(0, dispatchNMEASentence(msg, strlen(msg), NMEA_TYPE_MASK_ALL, &s));
+        return assembler.add(s);
+    };
+    BOOST_CHECK(!assembler.hasSkyView(GSVTalkerGP));
+    //Interleaved GPS and GLONASS sequences
+    BOOST_CHECK_EQUAL(0, add("$GPGSV,2,1,06,23,38,230,44,29,71,156,47,07,29,116,41,08,09,081,36*7F"));
+    BOOST_CHECK_EQUAL(1, add("$GLGSV,1,1,02,65,10,100,20,66,11,110,*00"));
+    BOOST_CHECK_EQUAL(1, add("$GPGSV,2,2,06,10,12,120,,11,13,130,30*00"));
+    BOOST_REQUIRE(assembler.hasSkyView(GSVTalkerGP));
+    const GSVSkyView& gps = assembler.getSkyView(GSVTalkerGP);
+    BOOST_CHECK_EQUAL(6, gps.numSats);
+    BOOST_CHECK_EQUAL(6, gps.numSatInfos);
+    BOOST_CHECK(gps.hasSatellite(23));
+    BOOST_CHECK(gps.hasSatellite(11));
+    BOOST_CHECK(!gps.hasSatellite(65));
+    BOOST_CHECK_EQUAL(30, gps.satellites[11].signal);
+    BOOST_CHECK_EQUAL(UINT8_MAX, gps.satellites[10].signal);
+    const GSVSkyView& glonass = assembler.getSkyView(GSVTalkerGL);
+    BOOST_CHECK_EQUAL(2, glonass.numSatInfos);
+    BOOST_CHECK(glonass.hasSatellite(66));
+    //Missing part: Sequence is discarded, the previous view stays published
+    BOOST_CHECK_EQUAL(0, add("$GPGSV,3,1,09,01,38,230,44*00"));
+    BOOST_CHECK_EQUAL(-3, add("$GPGSV,3,3,09,02,38,230,44*00"));
+    BOOST_CHECK_EQUAL(1, assembler.getDiscardedSequences());
+    BOOST_CHECK_EQUAL(6, assembler.getSkyView(GSVTalkerGP).numSatInfos);
+    //Restart in the middle of a sequence
+    BOOST_CHECK_EQUAL(0, add("$GPGSV,2,1,05,01,38,230,44*00"));
+    BOOST_CHECK_EQUAL(0, add("$GPGSV,2,1,05,03,38,230,44*00"));
+    BOOST_CHECK_EQUAL(2, assembler.getDiscardedSequences());
+    BOOST_CHECK_EQUAL(1, add("$GPGSV,2,2,05,04,38,230,44*00"));
+    BOOST_CHECK_EQUAL(2, assembler.getSkyView(GSVTalkerGP).numSatInfos);
+    BOOST_CHECK(!assembler.getSkyView(GSVTalkerGP).hasSatellite(1));
+    //Invalid sentences and talkers
+    BOOST_CHECK_EQUAL(-2, add("$GPGSV,2,3,05*00"));
+    BOOST_CHECK_EQUAL(-1, add("$GNGSV,1,1,05*00"));
+}
+
+BOOST_AUTO_TEST_CASE(TestEpochAggregator)
+{
+    EpochAggregator aggregator;
+    NMEAFix fix;
+    auto add = [&](const char* msg) { return aggregator.add(msg, strlen(msg)); };
+    BOOST_CHECK(!aggregator.getLatestFix(&fix));
+    //Complete epoch from the configured sentence set
+    BOOST_CHECK_EQUAL(0, add("$GPRMC,083559.00,A,4717.11437,N,00833.91522,E,0.004,77.52,091202,,,A\r\n"));
+    BOOST_CHECK_EQUAL(0, add("$GPGSV,2,1,06,23,38,230,44\r\n"));
+    BOOST_CHECK_EQUAL(0, add("$GPGSV,2,2,06,10,12,120,\r\n"));
+    BOOST_CHECK_EQUAL(0, add("$GLGSV,1,1,03,65,12,120,\r\n"));
+    BOOST_CHECK_EQUAL(-1, add("$GPGLL,4717.11437,N,00833.91522,E,083559.00,A,A*00\r\n")); //Wrong checksum
+    BOOST_CHECK_EQUAL(1, add("$GPGLL,4717.11437,N,00833.91522,E,083559.00,A,A\r\n"));
+    BOOST_REQUIRE(aggregator.getLatestFix(&fix));
+    BOOST_CHECK_EQUAL(8355900, fix.utcTime);
+    BOOST_CHECK_EQUAL(91202, fix.date);
+    BOOST_CHECK_EQUAL(471711437, fix.position.latitude);
+    BOOST_CHECK_EQUAL(77520, fix.course);
+    BOOST_CHECK_EQUAL('A', fix.posMode);
+    BOOST_CHECK_EQUAL(6, fix.satsInView[GSVTalkerGP]);
+    BOOST_CHECK_EQUAL(3, fix.satsInView[GSVTalkerGL]);
+    BOOST_CHECK_EQUAL(0, fix.satsInView[GSVTalkerGA]);
+    BOOST_CHECK_EQUAL(NMEA_TYPE_MASK(NMEASentenceRMC) | NMEA_TYPE_MASK(NMEASentenceGLL) | NMEA_TYPE_MASK(NMEASentenceGSV),
+                      fix.sentenceMask);
+    BOOST_CHECK_EQUAL(0, fix.epoch);
+    //Late duplicate of a published epoch is ignored
+    BOOST_CHECK_EQUAL(0, add("$GPGLL,4717.11437,N,00833.91522,E,083559.00,A,A\r\n"));
+    BOOST_CHECK_EQUAL(1, aggregator.getNumPublished());
+    //Incomplete epoch ended by the next timestamp
+    BOOST_CHECK_EQUAL(0, add("$GPGLL,4717.11438,N,00833.91522,E,083559.10,A,A\r\n"));
+    BOOST_CHECK_EQUAL(1, add("$GPGLL,4717.11439,N,00833.91522,E,083559.20,A,A\r\n"));
+    BOOST_REQUIRE(aggregator.getLatestFix(&fix));
+    BOOST_CHECK_EQUAL(8355910, fix.utcTime);
+    BOOST_CHECK_EQUAL(INT32_MAX, fix.date);
+    BOOST_CHECK_EQUAL(471711438, fix.position.latitude);
+    BOOST_CHECK_EQUAL('A', fix.status);
+    BOOST_CHECK_EQUAL(1, fix.epoch);
+    BOOST_CHECK_EQUAL(1, aggregator.flush());
+    BOOST_CHECK_EQUAL(0, aggregator.flush());
+    BOOST_CHECK_EQUAL(3, aggregator.getNumPublished());
+}
+
+struct SeqLockTestValue {
+    uint64_t values[9];
+};
+
+BOOST_AUTO_TEST_CASE(TestSeqLockConcurrency)
+{
+    SeqLock<SeqLockTestValue> lock;
+    atomic<bool> done(false);
+    atomic<uint64_t> inconsistent(0), reads(0);
+    auto reader = [&]() {
+        uint64_t last = 0;
+        while(!done.load()) {
+            SeqLockTestValue value = lock.load();
+            for (int i = 1; i < 9; ++i) {
+                if(value.values[i] != value.values[0]) {
+                    inconsistent++;
+                }
+            }
+            //Values never go back in time
+            if(value.values[0] < last) {
+                inconsistent++;
+            }
+            last = value.values[0];
+            reads++;
+        }
+    };
+    thread r1(reader), r2(reader);
+    SeqLockTestValue value;
+    for (uint64_t i = 1; i <= 2000000; ++i) {
+        for (int j = 0; j < 9; ++j) {
+            value.values[j] = i;
+        }
+        lock.store(value);
+    }
+    done = true;
+    r1.join();
+    r2.join();
+    BOOST_CHECK_EQUAL(0, inconsistent.load());
+    BOOST_CHECK(reads.load() > 0);
+    BOOST_CHECK_EQUAL(2000000, lock.getVersion());
+}
+
+BOOST_AUTO_TEST_CASE(TestUBXMessageBuilders)
+{
+    //1 Hz, from the u-blox protocol specification
+    uint8_t msg[32];
+    const uint8_t cfgRate[] = {0xB5, 0x62, 0x06, 0x08, 0x06, 0x00, 0xE8, 0x03, 0x01, 0x00, 0x01, 0x00, 0x01, 0x39};
+    BOOST_CHECK_EQUAL(sizeof(cfgRate), buildUBXCfgRate(1000, 1, msg));
+    BOOST_CHECK(memcmp(cfgRate, msg, sizeof(cfgRate)) == 0);
+    const uint8_t cfgMsg[] = {0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0x01, 0x07, 0x01, 0x13, 0x51};
+    BOOST_CHECK_EQUAL(sizeof(cfgMsg), buildUBXCfgMsg(UBX_CLASS_NAV, UBX_ID_NAV_PVT, 1, msg));
+    BOOST_CHECK(memcmp(cfgMsg, msg, sizeof(cfgMsg)) == 0);
+    BOOST_CHECK_EQUAL(28, buildUBXCfgPrtUART(115200, UBX_PROTO_UBX | UBX_PROTO_NMEA, UBX_PROTO_UBX, msg));
+    uint32_t baudrate;
+    memcpy(&baudrate, msg + UBX_HEADER_SIZE + 8, 4);
+    BOOST_CHECK_EQUAL(115200, baudrate);
+    BOOST_CHECK_EQUAL(UBX_PROTO_UBX | UBX_PROTO_NMEA, msg[UBX_HEADER_SIZE + 12]);
+    BOOST_CHECK_EQUAL(UBX_PROTO_UBX, msg[UBX_HEADER_SIZE + 14]);
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEAUBXFramer)
+{
+    UBXNavPVT pvt;
+    memset(&pvt, 0, sizeof(pvt));
+    pvt.iTOW = 123456000;
+    pvt.year = 2024;
+    pvt.fixType = 3;
+    pvt.numSV = 11;
+    pvt.lat = 477861625;
+    pvt.lon = 0x0A24B562; //Payload bytes resembling sync chars, '$' and '\n'
+    pvt.hMSL = 499600;
+    uint8_t sat[sizeof(UBXNavSat) + 2 * sizeof(UBXNavSatSv)] = {};
+    sat[5] = 3; //numSvs = 3, but only 2 blocks present
+    sat[sizeof(UBXNavSat) + 1] = 23;
+    sat[sizeof(UBXNavSat) + sizeof(UBXNavSatSv) + 1] = 29;
+    uint8_t frames[256];
+    size_t pvtSize = buildUBXMessage(UBX_CLASS_NAV, UBX_ID_NAV_PVT, &pvt, sizeof(pvt), frames);
+    size_t satSize = buildUBXMessage(UBX_CLASS_NAV, UBX_ID_NAV_SAT, sat, sizeof(sat), frames + pvtSize);
+    string pvtFrame((const char*)frames, pvtSize), satFrame((const char*)frames + pvtSize, satSize);
+    string rmc = "$GPRMC,083559.00,A,4717.11437,N,00833.91522,E,0.004,77.52,091202,,,A*57\r\n";
+    string gll = "$GPGLL,4717.11364,N,00833.91565,E,092321.00,A,A*60\r\n";
+    string stream = "xx" + rmc + pvtFrame + gll + satFrame + "$GPGSV,1,1" + pvtFrame + rmc;
+    //Corrupt copy of the PVT frame
+    string corrupt = pvtFrame;
+    corrupt[20] ^= 1;
+    stream += corrupt + gll;
+    //Feed with all chunk sizes
+    for (size_t chunkSize = 1; chunkSize <= stream.size(); chunkSize += (chunkSize < 16 ? 1 : 13)) {
+        NMEAUBXFramer framer;
+        vector<string> sentences;
+        vector<int> lats;
+        vector<int> svIds;
+        size_t emitted = 0;
+        for (size_t i = 0; i < stream.size(); i += chunkSize) {
+            size_t n = min(chunkSize, stream.size() - i);
+            emitted += framer.feed(stream.data() + i, n, [&](const char* sentence, size_t size) {
+                sentences.push_back(string(sentence, size));
+            }, [&](const UBXMessage& msg) {
+                const UBXNavPVT* decoded = decodeUBXMessage<UBXNavPVT>(msg);
+                if(decoded != NULL) {
+                    BOOST_CHECK_EQUAL(11, decoded->numSV);
+                    BOOST_CHECK_EQUAL(499600, decoded->hMSL);
+                    lats.push_back(decoded->lat);
+                }
+                const UBXNavSatSv* svs;
+                size_t numSvs = getUBXNavSatSvs(msg, &svs);
+                for (size_t j = 0; j < numSvs; ++j) {
+                    svIds.push_back(svs[j].svId);
+                }
+            });
+        }
+        BOOST_CHECK_EQUAL(7, emitted);
+        BOOST_REQUIRE_EQUAL(4, sentences.size());
+        BOOST_CHECK_EQUAL(rmc, sentences[0]);
+        BOOST_CHECK_EQUAL(gll, sentences[1]);
+        BOOST_CHECK_EQUAL(rmc, sentences[2]);
+        BOOST_CHECK_EQUAL(gll, sentences[3]);
+        BOOST_CHECK_EQUAL(2, lats.size());
+        BOOST_CHECK_EQUAL(2, svIds.size());
+        BOOST_CHECK_EQUAL(1, framer.getChecksumErrors());
+        //Interrupted GSV sentence
+        BOOST_CHECK(framer.getDroppedBytes() >= 2 + 10);
+    }
+}
+
+/**
+ * Feed a stream in chunks of the given size, record sentences and messages in order
+ */
+static vector<string> feedUBXFramer(NMEAUBXFramer& framer, const string& stream, size_t chunkSize) {
+    vector<string> output;
+    for (size_t i = 0; i < stream.size(); i += chunkSize) {
+        size_t n = min(chunkSize, stream.size() - i);
+        framer.feed(stream.data() + i, n, [&](const char* sentence, size_t size) {
+            output.push_back(string(sentence, size));
+        }, [&](const UBXMessage& msg) {
+            output.push_back("UBX " + string((const char*)msg.payload, msg.size));
+        });
+    }
+    return output;
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEAUBXFramerResync)
+{
+    uint8_t frame[64];
+    size_t frameSize = buildUBXMessage(UBX_CLASS_NAV, UBX_ID_NAV_PVT, "payload", 7, frame);
+    string ubx((const char*)frame, frameSize);
+    string rmc = "$GPRMC,083559.00,A,4717.11437,N,00833.91522,E,0.004,77.52,091202,,,A*57\r\n";
+    string gll = "$GPGLL,4717.11364,N,00833.91565,E,092321.00,A,A*60\r\n";
+    //False sync chars: Oversized length, then a length covering valid data with a wrong checksum
+    string oversized("\xB5\x62\x01\x07\xFF\x0F", 6);
+    string swallowing("\xB5\x62\x01\x07\x40\x00", 6);
+    string stream = oversized + rmc + ubx + gll + swallowing + rmc + ubx + gll;
+    NMEAUBXFramer whole;
+    vector<string> expected = feedUBXFramer(whole, stream, stream.size());
+    BOOST_REQUIRE_EQUAL(6u, expected.size());
+    BOOST_CHECK_EQUAL(rmc, expected[0]);
+    BOOST_CHECK_EQUAL("UBX payload", expected[1]);
+    BOOST_CHECK_EQUAL(gll, expected[2]);
+    BOOST_CHECK_EQUAL(rmc, expected[3]);
+    BOOST_CHECK_EQUAL("UBX payload", expected[4]);
+    BOOST_CHECK_EQUAL(gll, expected[5]);
+    for (size_t chunkSize = 1; chunkSize < stream.size(); ++chunkSize) {
+        NMEAUBXFramer framer;
+        vector<string> output = feedUBXFramer(framer, stream, chunkSize);
+        BOOST_CHECK_MESSAGE(output == expected, "chunk size " << chunkSize);
+        BOOST_CHECK_EQUAL(whole.getDroppedBytes(), framer.getDroppedBytes());
+        BOOST_CHECK_EQUAL(whole.getChecksumErrors(), framer.getChecksumErrors());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEAEncoders)
+{
+    char buf[NMEA_ENCODER_MAX_SIZE];
+    RMCSentence rmc;
+    BOOST_REQUIRE_EQUAL(0, parseRMCSentence("$GPRMC,083559.00,A,4717.11437,N,00833.91522,E,0.004,77.52,091202,,,A*57", &rmc));
+    const char* expected = "$GPRMC,083559.00,A,4717.11437,N,00833.91522,E,0.004,77.520,091202,,,A*67\r\n";
+    BOOST_CHECK_EQUAL(strlen(expected), encodeRMCSentence("GP", rmc, buf, sizeof(buf)));
+    BOOST_CHECK_EQUAL(expected, buf);
+    BOOST_CHECK_EQUAL(0, checkNMEAChecksum(buf, strlen(buf)));
+    NMEAPosition pos = {-471711364, -83391565};
+    BOOST_CHECK(encodeGLLSentence("GN", pos, 9232100, buf, sizeof(buf)) > 0);
+    BOOST_CHECK_EQUAL("$GNGLL,4717.11364,S,00833.91565,W,092321.00,A,A*71\r\n", buf);
+    GSVSentence gsv = {3, 1, 10, 2, {{7, 38, 230, 44}, {29, 71, 156, UINT8_MAX}} };
+    BOOST_CHECK(encodeGSVSentence("GL", gsv, buf, sizeof(buf)) > 0);
+    BOOST_CHECK_EQUAL(0, strncmp("$GLGSV,3,1,10,07,38,230,44,29,71,156,*", buf, 38));
+    //Buffer too small
+    BOOST_CHECK_EQUAL(0, encodeGSVSentence("GL", gsv, buf, sizeof(buf) - 1));
+    //Round trip of a generated corpus through parser and encoder
+    NMEACorpusGenerator generator(7, 2, 0);
+    char sentence[128];
+    size_t numRoundTrips = 0;
+    for (int i = 0; i < 3000; ++i) {
+        NMEASentenceType type;
+        generator.next(sentence, sizeof(sentence), &type);
+        NMEASentenceView view(sentence);
+        size_t size = 0;
+        if(type == NMEASentenceRMC) {
+            RMCSentence a, b;
+            if(parseRMCSentence(view, &a) != 0) {
+                continue;
+            }
+            size = encodeRMCSentence(sentence + 1, a, buf, sizeof(buf));
+            BOOST_REQUIRE_EQUAL(0, parseRMCSentence(buf, &b));
+            BOOST_CHECK_EQUAL(a, b);
+        } else if(type == NMEASentenceGLL) {
+            NMEAPosition a, b;
+            if(parseGLLSentence(view, &a) != 0) {
+                continue;
+            }
+            size = encodeGLLSentence(sentence + 1, a, view.utcTime(5), buf, sizeof(buf));
+            BOOST_REQUIRE_EQUAL(0, parseGLLSentence(buf, &b));
+            BOOST_CHECK_EQUAL(a, b);
+            BOOST_CHECK_EQUAL(view.utcTime(5), NMEASentenceView(buf).utcTime(5));
+        } else if(type == NMEASentenceGSV) {
+            GSVSentence a, b;
+            if(parseGSVSentence(view, &a) != 0) {
+                continue;
+            }
+            size = encodeGSVSentence(sentence + 1, a, buf, sizeof(buf));
+            BOOST_REQUIRE_EQUAL(0, parseGSVSentence(buf, &b));
+            BOOST_CHECK_EQUAL(a, b);
+        }
+        BOOST_CHECK_EQUAL(strlen(buf), size);
+        BOOST_CHECK_EQUAL(0, checkNMEAChecksum(buf, size));
+        numRoundTrips++;
+    }
+    BOOST_CHECK(numRoundTrips > 2500);
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEAFormatters)
+{
+    char buf[NMEA_FORMAT_MAX_SIZE];
+    RMCSentence rmc;
+    BOOST_REQUIRE_EQUAL(0, parseRMCSentence("$GPRMC,083559.00,A,4717.01437,N,00833.91522,W,0.004,77.52,091202,,,A*57", &rmc));
+    //Longitude hemisphere is independent of latitude
+    const char* text = "RMC { 2002-12-09 08:35:59.00, NMEAPosition { 47\xC2\xB0" "17.01437\"N 8\xC2\xB0" "33.91522\"W }, A/A, 0.004 kt, 77.520\xC2\xB0 }";
+    BOOST_CHECK_EQUAL(strlen(text), formatRMCSentence(rmc, NMEAFormatText, buf, sizeof(buf)));
+    BOOST_CHECK_EQUAL(text, buf);
+    //Stream operators print the same
+    ostringstream os;
+    os << rmc;
+    BOOST_CHECK_EQUAL(text, os.str());
+    //JSON lines & CSV: 17.01437' = 0.2835728 degrees
+    formatRMCSentence(rmc, NMEAFormatJSON, buf, sizeof(buf));
+    BOOST_CHECK_EQUAL("{\"type\":\"RMC\",\"date\":\"2002-12-09\",\"time\":\"08:35:59.00\",\"status\":\"A\","
+        "\"latitude\":47.2835728,\"longitude\":-8.5652537,\"speed\":0.004,\"course\":77.520,\"posMode\":\"A\"}\n", buf);
+    formatRMCSentence(rmc, NMEAFormatCSV, buf, sizeof(buf));
+    BOOST_CHECK_EQUAL("RMC,2002-12-09,08:35:59.00,A,47.2835728,-8.5652537,0.004,77.520,A\n", buf);
+    //Invalid fields
+    NMEAPosition pos = {INT32_MAX, -1};
+    formatNMEAPosition(pos, NMEAFormatJSON, buf, sizeof(buf));
+    BOOST_CHECK_EQUAL("{\"type\":\"position\",\"latitude\":null,\"longitude\":-0.0000002}\n", buf);
+    formatNMEAPosition(pos, NMEAFormatCSV, buf, sizeof(buf));
+    BOOST_CHECK_EQUAL("position,,-0.0000002\n", buf);
+    //GSV
+    GSVSentence gsv = {3, 1, 10, 2, {{23, 38, 230, 44}, {29, 71, 156, UINT8_MAX}} };
+    formatGSVSentence(gsv, NMEAFormatJSON, buf, sizeof(buf));
+    BOOST_CHECK_EQUAL("{\"type\":\"GSV\",\"numMsgs\":3,\"msgNum\":1,\"numSats\":10,\"satellites\":["
+        "{\"id\":23,\"azimuth\":38,\"elevation\":230,\"signal\":44},"
+        "{\"id\":29,\"azimuth\":71,\"elevation\":156,\"signal\":null}]}\n", buf);
+    formatGSVSentence(gsv, NMEAFormatCSV, buf, sizeof(buf));
+    BOOST_CHECK_EQUAL("GSV,3,1,10,23,38,230,44,29,71,156,\n", buf);
+    formatGSVSentence(gsv, NMEAFormatText, buf, sizeof(buf));
+    BOOST_CHECK_EQUAL("GSVSentence { #1 of 3, 10 satellites in view: Satellite { #23, azimuth 38, elevation 230, signal 44 }, "
+        "Satellite { #29, azimuth 71, elevation 156, signal 255 } }", buf);
+    //Buffer too small
+    BOOST_CHECK_EQUAL(0, formatGSVSentence(gsv, NMEAFormatCSV, buf, 16));
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEATrack)
+{
+    BOOST_CHECK_EQUAL(2120908355900ull, makeNMEATimeKey(91202, 8355900));
+    BOOST_CHECK(makeNMEATimeKey(311224, 23595999) < makeNMEATimeKey(10125, 0));
+    //Generate an RMC track
+    NMEACorpusGenerator generator(3, 1, 0);
+    vector<RMCSentence> fixes;
+    char sentence[128];
+    while(fixes.size() < 5000) {
+        generator.next(NMEASentenceRMC, sentence, sizeof(sentence));
+        RMCSentence fix;
+        if(parseRMCSentence(sentence, &fix) == 0) {
+            fixes.push_back(fix);
+        }
+    }
+    char filename[] = "/tmp/nmeatrackXXXXXX";
+    int fd = mkstemp(filename);
+    BOOST_REQUIRE(fd >= 0);
+    close(fd);
+    NMEATrackWriter writer(256);
+    BOOST_REQUIRE_EQUAL(0, writer.open(filename));
+    for (const RMCSentence& fix : fixes) {
+        BOOST_REQUIRE_EQUAL(0, writer.add(fix));
+    }
+    BOOST_REQUIRE_EQUAL(0, writer.close());
+    NMEATrackReader reader;
+    BOOST_REQUIRE_EQUAL(0, reader.open(filename));
+    BOOST_CHECK_EQUAL(fixes.size(), reader.getNumFixes());
+    BOOST_CHECK_EQUAL((fixes.size() + 255) / 256, reader.getNumBlocks());
+    //Much smaller than the NMEA text (~70 bytes/fix)
+    struct stat st;
+    stat(filename, &st);
+    BOOST_TEST_MESSAGE("Track: " << (double)st.st_size / fixes.size() << " bytes/fix");
+    BOOST_CHECK(st.st_size < (off_t)fixes.size() * 16);
+    //Full decode
+    vector<RMCSentence> all;
+    BOOST_CHECK_EQUAL(fixes.size(), reader.query(0, NMEA_TIME_KEY_INVALID, [&](const RMCSentence& fix) {
+        all.push_back(fix);
+    }));
+    BOOST_REQUIRE_EQUAL(fixes.size(), all.size());
+    for (size_t i = 0; i < fixes.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(fixes[i], all[i]);
+    }
+    //Range query only returns matching fixes
+    uint64_t from = makeNMEATimeKey(fixes[1000].date, fixes[1000].utcTime);
+    uint64_t to = makeNMEATimeKey(fixes[1100].date, fixes[1100].utcTime);
+    size_t expected = 0;
+    for (const RMCSentence& fix : fixes) {
+        uint64_t key = makeNMEATimeKey(fix.date, fix.utcTime);
+        expected += key >= from && key <= to;
+    }
+    BOOST_CHECK_EQUAL(expected, reader.query(from, to, [&](const RMCSentence& fix) {
+        uint64_t key = makeNMEATimeKey(fix.date, fix.utcTime);
+        BOOST_CHECK(key >= from && key <= to);
+    }));
+    reader.close();
+    //Chronological track with a block without time in between
+    BOOST_REQUIRE_EQUAL(0, writer.open(filename));
+    vector<uint64_t> keys;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        RMCSentence fix = fixes[i];
+        fix.date = 10126;
+        fix.utcTime = (i / 60) * 10000 + (i % 60) * 100;
+        if(i >= 256 && i < 512) {
+            fix.utcTime = INT32_MAX;
+        }
+        BOOST_REQUIRE_EQUAL(0, writer.add(fix));
+        keys.push_back(makeNMEATimeKey(fix.date, fix.utcTime));
+    }
+    BOOST_REQUIRE_EQUAL(0, writer.close());
+    BOOST_REQUIRE_EQUAL(0, reader.open(filename));
+    BOOST_CHECK_EQUAL(NMEA_TIME_KEY_INVALID, reader.getBlockInfo(1).minKey);
+    for (size_t range : {0, 100, 600, 990}) {
+        from = keys[range];
+        to = keys[range + 9];
+        BOOST_CHECK_EQUAL(10, reader.query(from, to, [&](const RMCSentence& fix) {
+            uint64_t key = makeNMEATimeKey(fix.date, fix.utcTime);
+            BOOST_CHECK(key >= from && key <= to);
+        }));
+    }
+    BOOST_CHECK_EQUAL(0, reader.query(keys[999] + 1, NMEA_TIME_KEY_INVALID - 1, [](const RMCSentence&) {}));
+    BOOST_CHECK_EQUAL(744, reader.query(0, NMEA_TIME_KEY_INVALID - 1, [](const RMCSentence&) {}));
+    reader.close();
+    unlink(filename);
+    //Invalid files
+    BOOST_CHECK_EQUAL(-1, reader.open(filename));
+    const uint8_t garbage[64] = {'N', 'M', 'E', 'A'};
+    BOOST_CHECK_EQUAL(-3, reader.openBuffer(garbage, sizeof(garbage)));
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEASeekIndex)
+{
+    //Capture of 2000 s at 2 Hz (RMC + GLL) crossing midnight and a year boundary
+    string capture;
+    vector<uint64_t> keys; //Key of each epoch
+    vector<size_t> epochSentences; //Number of sentences of each epoch
+    char sentence[NMEA_ENCODER_MAX_SIZE];
+    capture += "garbage before the first fix\r\n";
+    for (uint32_t i = 0; i < 4000; ++i) {
+        uint32_t t = (23 * 3600 + 50 * 60) * 100 + i * 50; //1/100 s
+        int32_t date = 311225;
+        if(t >= 24 * 3600 * 100) {
+            t -= 24 * 3600 * 100;
+            date = 10126;
+        }
+        RMCSentence rmc = {};
+        rmc.utcTime = (t / 360000) * 1000000 + (t / 6000 % 60) * 10000 + t % 6000;
+        rmc.date = date;
+        rmc.status = 'A';
+        rmc.posMode = 'A';
+        rmc.position.latitude = 475512345 + (int32_t)i;
+        rmc.position.longitude = -83012345;
+        rmc.speed = 1234;
+        rmc.course = INT32_MAX;
+        capture.append(sentence, encodeRMCSentence("GP", rmc, sentence, sizeof(sentence)));
+        capture.append(sentence, encodeGLLSentence("GP", rmc.position, rmc.utcTime, sentence, sizeof(sentence)));
+        keys.push_back(makeNMEATimeKey(rmc.date, rmc.utcTime));
+        epochSentences.push_back(2);
+    }
+    BOOST_REQUIRE(is_sorted(keys.begin(), keys.end()));
+    char captureName[] = "/tmp/nmeacaptureXXXXXX";
+    char indexName[] = "/tmp/nmeaseekXXXXXX";
+    int captureFd = mkstemp(captureName);
+    int indexFd = mkstemp(indexName);
+    BOOST_REQUIRE(captureFd >= 0 && indexFd >= 0);
+    close(indexFd);
+    //Index a capture that is still being written, ending in an incomplete line
+    size_t half = capture.size() / 2 + 7;
+    BOOST_REQUIRE_EQUAL((ssize_t)half, write(captureFd, capture.data(), half));
+    NMEASeekIndexBuilder builder(10);
+    BOOST_REQUIRE_EQUAL(0, builder.open(captureName, indexName));
+    int first = builder.update();
+    BOOST_CHECK(first > 0);
+    BOOST_CHECK(builder.getIndexedBytes() < half);
+    BOOST_CHECK_EQUAL('\n', capture[builder.getIndexedBytes() - 1]);
+    BOOST_CHECK_EQUAL(0, builder.update());
+    //Append the rest and continue with a new builder
+    BOOST_REQUIRE_EQUAL((ssize_t)(capture.size() - half), write(captureFd, capture.data() + half, capture.size() - half));
+    close(captureFd);
+    builder.close();
+    BOOST_CHECK_EQUAL(-3, NMEASeekIndexBuilder(5).open(captureName, indexName));
+    BOOST_REQUIRE_EQUAL(0, builder.open(captureName, indexName));
+    int second = builder.update();
+    BOOST_CHECK(second > 0);
+    BOOST_CHECK_EQUAL(capture.size(), builder.getIndexedBytes());
+    builder.close();
+    //Same index as a one-shot build: one entry every 10 s
+    char fullIndexName[] = "/tmp/nmeaseekXXXXXX";
+    indexFd = mkstemp(fullIndexName);
+    BOOST_REQUIRE(indexFd >= 0);
+    close(indexFd);
+    unlink(fullIndexName);
+    NMEASeekIndexBuilder fullBuilder(10);
+    BOOST_REQUIRE_EQUAL(0, fullBuilder.open(captureName, fullIndexName));
+    BOOST_CHECK_EQUAL(200, fullBuilder.update());
+    fullBuilder.close();
+    BOOST_CHECK_EQUAL(200, first + second);
+    NMEACaptureSeeker seeker, fullSeeker;
+    BOOST_REQUIRE_EQUAL(0, seeker.open(captureName, indexName));
+    BOOST_REQUIRE_EQUAL(0, fullSeeker.open(captureName, fullIndexName));
+    BOOST_REQUIRE_EQUAL(200u, seeker.getNumEntries());
+    BOOST_REQUIRE_EQUAL(fullSeeker.getNumEntries(), seeker.getNumEntries());
+    for (size_t i = 0; i < seeker.getNumEntries(); ++i) {
+        BOOST_CHECK_EQUAL(fullSeeker.getEntry(i).key, seeker.getEntry(i).key);
+        BOOST_CHECK_EQUAL(fullSeeker.getEntry(i).offset, seeker.getEntry(i).offset);
+        BOOST_CHECK_EQUAL(keys[i * 20], seeker.getEntry(i).key);
+        BOOST_CHECK(capture.compare(seeker.getEntry(i).offset, 6, "$GPRMC") == 0);
+    }
+    //Queries match a scan of the whole capture
+    const size_t ranges[][2] = {{0, 0}, {0, 30}, {1234, 1500}, {1199, 1201}, {3990, 3999}, {1000, 1000}};
+    for (const auto& range : ranges) {
+        uint64_t from = keys[range[0]], to = keys[range[1]];
+        size_t expected = 0;
+        for (size_t i = range[0]; i <= range[1]; ++i) {
+            expected += epochSentences[i];
+        }
+        const char* firstSentence = NULL;
+        uint64_t lastKey = 0;
+        BOOST_CHECK_EQUAL(expected, seeker.query(from, to, [&](const char* s, size_t size, uint64_t key) {
+            BOOST_CHECK(key >= from && key <= to && key >= lastKey);
+            BOOST_CHECK(size > 0 && s[0] == '$' && s[size - 1] == '\n');
+            if(firstSentence == NULL) {
+                firstSentence = s;
+            }
+            lastKey = key;
+        }));
+        BOOST_REQUIRE(firstSentence != NULL);
+        BOOST_CHECK_EQUAL(from, getNMEARMCTimeKey(firstSentence, strchr(firstSentence, '\n') + 1 - firstSentence));
+        BOOST_CHECK_EQUAL(to, lastKey);
+    }
+    //Before the first and after the last epoch
+    BOOST_CHECK_EQUAL(0u, seeker.findOffset(0));
+    BOOST_CHECK_EQUAL(0u, seeker.query(0, keys[0] - 1, [](const char*, size_t, uint64_t) {}));
+    BOOST_CHECK_EQUAL(0u, seeker.query(keys.back() + 1, NMEA_TIME_KEY_INVALID, [](const char*, size_t, uint64_t) {}));
+    seeker.close();
+    fullSeeker.close();
+    unlink(captureName);
+    unlink(indexName);
+    unlink(fullIndexName);
+    BOOST_CHECK_EQUAL(-1, seeker.open(captureName, indexName));
+    BOOST_CHECK_EQUAL(-1, builder.open(captureName, indexName));
+    //Receiver time going backwards stops the builder
+    string jump;
+    const uint32_t times[] = {120000, 120030, 115959, 120100};
+    size_t jumpOffset = 0;
+    for (uint32_t time : times) {
+        RMCSentence rmc = {};
+        rmc.utcTime = time * 100;
+        rmc.date = 10126;
+        rmc.status = 'A';
+        rmc.posMode = 'A';
+        rmc.position.latitude = 475512345;
+        rmc.position.longitude = -83012345;
+        rmc.speed = rmc.course = INT32_MAX;
+        if(time == 115959) {
+            jumpOffset = jump.size();
+        }
+        jump.append(sentence, encodeRMCSentence("GP", rmc, sentence, sizeof(sentence)));
+    }
+    char jumpName[] = "/tmp/nmeacaptureXXXXXX";
+    char jumpIndexName[] = "/tmp/nmeaseekXXXXXX";
+    captureFd = mkstemp(jumpName);
+    indexFd = mkstemp(jumpIndexName);
+    BOOST_REQUIRE(captureFd >= 0 && indexFd >= 0);
+    close(indexFd);
+    BOOST_REQUIRE_EQUAL((ssize_t)jump.size(), write(captureFd, jump.data(), jump.size()));
+    close(captureFd);
+    BOOST_REQUIRE_EQUAL(0, builder.open(jumpName, jumpIndexName));
+    BOOST_CHECK_EQUAL(-2, builder.update());
+    BOOST_CHECK_EQUAL(jumpOffset, builder.getIndexedBytes());
+    BOOST_CHECK_EQUAL(-2, builder.update());
+    builder.close();
+    BOOST_REQUIRE_EQUAL(0, seeker.open(jumpName, jumpIndexName));
+    BOOST_CHECK_EQUAL(2u, seeker.getNumEntries());
+    seeker.close();
+    unlink(jumpName);
+    unlink(jumpIndexName);
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEAIngestLoop)
+{
+    //Stream sockets, ptys and datagram sockets standing in for receivers
+    const uint32_t numStreams = 24, numPtys = 8, numDatagrams = 4;
+    const uint32_t numSources = numStreams + numPtys + numDatagrams;
+    NMEAIngestLoop loop;
+    BOOST_REQUIRE_EQUAL(0, loop.open());
+    vector<int> writers(numSources), readers(numSources);
+    for (uint32_t id = 0; id < numSources; ++id) {
+        int fds[2];
+        NMEASourceType type = NMEASourceStream;
+        if(id < numStreams) {
+            BOOST_REQUIRE_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        } else if(id < numStreams + numPtys) {
+            fds[0] = posix_openpt(O_RDWR | O_NOCTTY);
+            BOOST_REQUIRE(fds[0] >= 0);
+            BOOST_REQUIRE_EQUAL(0, grantpt(fds[0]));
+            BOOST_REQUIRE_EQUAL(0, unlockpt(fds[0]));
+            fds[1] = open(ptsname(fds[0]), O_RDWR | O_NOCTTY);
+            BOOST_REQUIRE(fds[1] >= 0);
+            //Like a serial port configured for a receiver: no line discipline processing
+            struct termios tio;
+            BOOST_REQUIRE_EQUAL(0, tcgetattr(fds[1], &tio));
+            cfmakeraw(&tio);
+            BOOST_REQUIRE_EQUAL(0, tcsetattr(fds[1], TCSANOW, &tio));
+        } else {
+            BOOST_REQUIRE_EQUAL(0, socketpair(AF_UNIX, SOCK_DGRAM, 0, fds));
+            type = NMEASourceDatagram;
+        }
+        readers[id] = fds[0];
+        writers[id] = fds[1];
+        BOOST_REQUIRE_EQUAL(0, loop.addSource(readers[id], 1000 + id, type));
+    }
+    BOOST_CHECK_EQUAL(numSources, loop.getNumSources());
+    BOOST_CHECK_EQUAL(-2, loop.addSource(readers[0], 1000));
+    BOOST_CHECK_EQUAL(-1, loop.removeSource(1));
+    //Every source sends its own corpus in random chunks, or sentence by sentence for datagrams
+    vector<string> corpora(numSources), received(numSources);
+    vector<size_t> written(numSources, 0);
+    vector<uint64_t> lastTimestamp(numSources, 0);
+    for (uint32_t id = 0; id < numSources; ++id) {
+        corpora[id] = NMEACorpusGenerator(id + 1).generate(300);
+    }
+    uint64_t startTime = getNMEAMonotonicTime();
+    auto onSentence = [&](const NMEAIngestSentence& s) {
+        BOOST_REQUIRE(s.sourceId >= 1000 && s.sourceId < 1000 + numSources);
+        uint32_t id = s.sourceId - 1000;
+        BOOST_CHECK(s.timestamp >= lastTimestamp[id] && s.timestamp >= startTime);
+        lastTimestamp[id] = s.timestamp;
+        received[id].append(s.sentence, s.size);
+    };
+    auto allRead = [&]() {
+        for (uint32_t id = 0; id < numSources; ++id) {
+            NMEASourceStats stats;
+            if(loop.getSourceStats(1000 + id, &stats) != 0 || stats.bytes != written[id]) {
+                return false;
+            }
+        }
+        return true;
+    };
+    uint32_t rng = 1;
+    bool done = false;
+    while(!done) {
+        done = true;
+        for (uint32_t id = 0; id < numSources; ++id) {
+            const string& corpus = corpora[id];
+            if(written[id] == corpus.size()) {
+                continue;
+            }
+            done = false;
+            size_t size;
+            if(id < numStreams + numPtys) {
+                rng = rng * 1103515245 + 12345;
+                size = 1 + (rng >> 16) % 300;
+            } else {
+                size = corpus.find('\n', written[id]) + 1 - written[id];
+            }
+            size = min(size, corpus.size() - written[id]);
+            BOOST_REQUIRE_EQUAL((ssize_t)size, write(writers[id], corpus.data() + written[id], size));
+            written[id] += size;
+        }
+        //Drain everything, ptys deliver asynchronously
+        for (int i = 0; i < 1000 && !allRead(); ++i) {
+            BOOST_REQUIRE(loop.poll(10, onSentence) >= 0);
+        }
+        BOOST_REQUIRE(allRead());
+    }
+    for (uint32_t id = 0; id < numSources; ++id) {
+        BOOST_CHECK(received[id] == corpora[id]);
+        NMEASourceStats stats;
+        BOOST_REQUIRE_EQUAL(0, loop.getSourceStats(1000 + id, &stats));
+        BOOST_CHECK_EQUAL(0u, stats.droppedBytes);
+        BOOST_CHECK_EQUAL(300u, stats.sentences);
+    }
+    //A datagram does not continue the partial sentence of the previous one
+    const char* truncated = "$GPGLL,4751.";
+    const char* complete = "$GPGLL,4751.23456,N,00830.12345,E,123519.00,A,A*6F\r\n";
+    uint32_t datagramId = numStreams + numPtys;
+    received[datagramId].clear();
+    BOOST_REQUIRE(write(writers[datagramId], truncated, strlen(truncated)) > 0);
+    BOOST_REQUIRE(write(writers[datagramId], complete + 7, strlen(complete) - 7) > 0);
+    BOOST_REQUIRE(write(writers[datagramId], complete, strlen(complete)) > 0);
+    for (int i = 0; i < 100 && received[datagramId].empty(); ++i) {
+        loop.poll(10, onSentence);
+    }
+    BOOST_CHECK_EQUAL(string(complete), received[datagramId]);
+    //End of stream removes the sources. Datagram sockets have no end of stream.
+    for (uint32_t id = numStreams + numPtys; id < numSources; ++id) {
+        BOOST_CHECK_EQUAL(0, loop.removeSource(1000 + id));
+    }
+    map<uint32_t, int> closed;
+    for (uint32_t id = 0; id < numSources; ++id) {
+        close(writers[id]);
+    }
+    for (int i = 0; i < 1000 && loop.getNumSources() > 0; ++i) {
+        loop.poll(10, onSentence, [&](uint32_t id, int error) {
+            closed[id] = error;
+        });
+    }
+    BOOST_CHECK_EQUAL(0u, loop.getNumSources());
+    BOOST_REQUIRE_EQUAL(numStreams + numPtys, closed.size());
+    BOOST_CHECK_EQUAL(0, closed[1000]);
+    BOOST_CHECK_EQUAL(EIO, closed[1000 + numStreams]);
+    for (uint32_t id = 0; id < numSources; ++id) {
+        close(readers[id]);
+    }
+    loop.close();
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEARing)
+{
+    const char* sentence = "$GPGLL,4751.23456,N,00830.12345,E,123519.00,A,A*6F\r\n";
+    const size_t size = strlen(sentence);
+    NMEARing<64> ring;
+    NMEARingSentence view;
+    BOOST_CHECK(!ring.nextSentence(&view));
+    //Garbage is dropped, incomplete sentences are kept
+    BOOST_CHECK_EQUAL(3u + 20u, ring.write("xx\n", 3) + ring.write(sentence, 20));
+    BOOST_CHECK(!ring.nextSentence(&view));
+    BOOST_CHECK_EQUAL(3u, ring.getDroppedBytes());
+    BOOST_CHECK_EQUAL(size - 20, ring.write(sentence + 20, size - 20));
+    BOOST_REQUIRE(ring.nextSentence(&view));
+    BOOST_CHECK(!view.isWrapped());
+    BOOST_CHECK_EQUAL(string(sentence), string(view.first, view.firstSize));
+    //Same sentence until consumed
+    NMEARingSentence again;
+    BOOST_REQUIRE(ring.nextSentence(&again));
+    BOOST_CHECK_EQUAL(view.position, again.position);
+    ring.consume(view);
+    BOOST_CHECK_EQUAL(0u, ring.available());
+    //The garbage was consumed before the rest of the sentence was written
+    BOOST_CHECK_EQUAL(size, ring.getHighWater());
+    //The next sentence wraps around the end
+    BOOST_REQUIRE_EQUAL(size, ring.write(sentence, size));
+    BOOST_REQUIRE(ring.nextSentence(&view));
+    BOOST_CHECK(view.isWrapped());
+    BOOST_CHECK_EQUAL(size, view.size());
+    BOOST_CHECK_EQUAL(64u - (3 + size), view.firstSize);
+    char scratch[NMEA_FRAMER_BUFSIZE];
+    BOOST_CHECK_EQUAL(string(sentence), string(view.linearize(scratch)));
+    for (size_t i = 0; i < size; ++i) {
+        BOOST_CHECK_EQUAL(sentence[i], view[i]);
+    }
+    BOOST_CHECK_EQUAL(0, checkNMEAChecksum(view.linearize(scratch), view.size()));
+    ring.consume(view);
+    //Overrun: only what fits is written
+    BOOST_CHECK_EQUAL(size, ring.write(sentence, size));
+    BOOST_CHECK_EQUAL(64u - size, ring.write(sentence, size));
+    BOOST_CHECK_EQUAL(1u, ring.getOverruns());
+    BOOST_CHECK_EQUAL(2 * size - 64, ring.getOverrunBytes());
+    BOOST_CHECK_EQUAL(64u, ring.getHighWater());
+    char* space;
+    BOOST_CHECK_EQUAL(0u, ring.getWriteSpace(&space));
+    BOOST_CHECK_EQUAL(1u, ring.readSentences([&](const NMEARingSentence& s) {
+        BOOST_CHECK_EQUAL(size, s.size());
+    }));
+    //Once terminated, the truncated sentence is delivered, but its checksum is wrong
+    BOOST_CHECK(ring.put('\r') && ring.put('\n'));
+    BOOST_CHECK_EQUAL(1u, ring.readSentences([&](const NMEARingSentence& s) {
+        BOOST_CHECK(checkNMEAChecksum(s.linearize(scratch), s.size()) != 0);
+    }));
+    BOOST_CHECK_EQUAL(0u, ring.available());
+    //Overlong sentences do not block a small ring
+    NMEARing<16> small;
+    BOOST_CHECK_EQUAL(16u, small.write("$GPTXT,012345678", 16));
+    BOOST_CHECK(!small.nextSentence(&view));
+    BOOST_CHECK_EQUAL(0u, small.available());
+    BOOST_CHECK_EQUAL(16u, small.getDroppedBytes());
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEARingThreads)
+{
+    const string corpus = NMEACorpusGenerator(7).generate(20000);
+    //Lossless: a reader thread waits for free space
+    {
+        NMEARing<256> ring;
+        std::atomic<bool> finished(false);
+        thread producer([&]() {
+            uint32_t rng = 1;
+            size_t pos = 0;
+            while(pos < corpus.size()) {
+                char* space;
+                uint32_t n = ring.getWriteSpace(&space);
+                rng = rng * 1103515245 + 12345;
+                n = min<uint32_t>(n, 1 + (rng >> 16) % 100);
+                n = min<uint32_t>(n, corpus.size() - pos);
+                if(n == 0) {
+                    this_thread::yield();
+                    continue;
+                }
+                memcpy(space, corpus.data() + pos, n);
+                ring.commitWrite(n);
+                pos += n;
+            }
+            finished = true;
+        });
+        string received;
+        size_t wrapped = 0;
+        char scratch[NMEA_FRAMER_BUFSIZE];
+        for(;;) {
+            bool done = finished;
+            size_t n = ring.readSentences([&](const NMEARingSentence& s) {
+                wrapped += s.isWrapped();
+                received.append(s.linearize(scratch), s.size());
+            });
+            if(done && n == 0) {
+                break;
+            }
+            if(n == 0) {
+                this_thread::yield();
+            }
+        }
+        producer.join();
+        BOOST_CHECK(received == corpus);
+        BOOST_CHECK(wrapped > 0);
+        BOOST_CHECK_EQUAL(0u, ring.getOverruns());
+        BOOST_CHECK_EQUAL(0u, ring.getDroppedBytes());
+        BOOST_CHECK(ring.getHighWater() <= 256u);
+    }
+    //Lossy: like an ISR, the producer never waits. Every byte is either
+    //delivered, dropped by the consumer, lost by an overrun or still in the ring.
+    {
+        NMEARing<512> ring;
+        std::atomic<bool> finished(false);
+        thread producer([&]() {
+            for (size_t pos = 0; pos < corpus.size(); pos += 64) {
+                ring.write(corpus.data() + pos, min<size_t>(64, corpus.size() - pos));
+                if(pos % 4096 == 0) {
+                    this_thread::yield();
+                }
+            }
+            finished = true;
+        });
+        size_t delivered = 0, valid = 0, spliced = 0;
+        char scratch[NMEA_FRAMER_BUFSIZE];
+        for(;;) {
+            bool done = finished;
+            size_t n = ring.readSentences([&](const NMEARingSentence& s) {
+                delivered += s.size();
+                const char* data = s.linearize(scratch);
+                if(checkNMEAChecksum(data, s.size()) == 0) {
+                    valid++;
+                    spliced += corpus.find(string(data, s.size())) == string::npos;
+                }
+            });
+            if(done && n == 0) {
+                break;
+            }
+        }
+        producer.join();
+        BOOST_CHECK(valid > 0);
+        //Sentences spliced by an overrun only pass the checksum by chance
+        BOOST_CHECK(spliced * 20 < valid);
+        BOOST_CHECK_EQUAL(corpus.size(), delivered + ring.getDroppedBytes() + ring.getOverrunBytes() + ring.available());
+        BOOST_TEST_MESSAGE("Ring overruns: " << ring.getOverruns() << ", " << ring.getOverrunBytes() << " bytes, "
+            << valid << " valid sentences, " << spliced << " spliced");
+    }
+}
+
+/**
+ * UBloxDriver transport reading from a MemoryPort and recording writes
+ */
+struct MemoryTransport {
+    size_t read(char* buf, size_t size) {
+        return memoryPortRead(port, buf, size);
+    }
+
+    void write(const char* buf, size_t size) {
+        written->append(buf, size);
+    }
+
+    MemoryPort* port;
+    string* written;
+};
+
+BOOST_AUTO_TEST_CASE(TestUBloxDriver)
+{
+    //Two receivers driven alternately keep separate state
+    const string corpusA = NMEACorpusGenerator(11).generate(500);
+    const string corpusB = NMEACorpusGenerator(12).generate(500);
+    MemoryPort portA = {corpusA.data(), corpusA.size(), 0};
+    MemoryPort portB = {corpusB.data(), corpusB.size(), 0};
+    string writtenA, writtenB;
+    MemoryTransport transportA = {&portA, &writtenA};
+    MemoryTransport transportB = {&portB, &writtenB};
+    UBloxDriver<MemoryTransport> a(transportA);
+    UBloxDriver<MemoryTransport, 128> b(transportB);
+    string receivedA, receivedB;
+    while(portA.pos < portA.size || portB.pos < portB.size) {
+        a.readSentences([&](const char* sentence, size_t size) {
+            receivedA.append(sentence, size);
+        });
+        b.readSentences([&](const char* sentence, size_t size) {
+            receivedB.append(sentence, size);
+        });
+    }
+    BOOST_CHECK(receivedA == corpusA);
+    BOOST_CHECK(receivedB == corpusB);
+    BOOST_CHECK_EQUAL(0u, a.getFramer().getDroppedBytes());
+    //Line reads
+    const char* rmc = "$GPRMC,083559.00,A,4717.11437,N,00833.91522,E,0.004,77.52,091202,,,A*57\r\n";
+    portA = {rmc, strlen(rmc), 0};
+    size_t size = a.readLine();
+    BOOST_REQUIRE_EQUAL(strlen(rmc), size);
+    BOOST_CHECK_EQUAL(string(rmc), a.getLine());
+    NMEAParsedSentence parsed;
+    BOOST_CHECK_EQUAL(0, a.parseMessage(size, NMEA_TYPE_MASK_ALL, &parsed));
+    BOOST_CHECK_EQUAL(NMEASentenceRMC, parsed.type);
+    BOOST_CHECK_EQUAL(0u, a.readLine());
+    //Ring reads
+    portB = {rmc, strlen(rmc), 0};
+    NMEARing<128> ring;
+    BOOST_CHECK_EQUAL(strlen(rmc), b.readIntoRing(ring));
+    BOOST_CHECK_EQUAL(1u, ring.readSentences([](const NMEARingSentence&) {}));
+    //Configuration
+    a.configure();
+    BOOST_CHECK_EQUAL(0, checkNMEAChecksum(writtenA.data(), writtenA.size()));
+    BOOST_CHECK_EQUAL(0, writtenA.compare(0, 30, "$PUBX,41,1,0001,0001,115200,0*"));
+    BOOST_CHECK(writtenB.empty());
+    b.configureBinary(115200, 100, 5);
+    NMEAUBXFramer framer;
+    vector<uint8_t> ids;
+    framer.feed(writtenB.data(), writtenB.size(), [](const char*, size_t) {}, [&](const UBXMessage& msg) {
+        ids.push_back(msg.msgId);
+    });
+    BOOST_REQUIRE_EQUAL(4u, ids.size());
+    BOOST_CHECK_EQUAL(0u, framer.getChecksumErrors());
+    //The baudrate change comes last, so the receiver gets the other messages
+    BOOST_CHECK_EQUAL(UBX_ID_CFG_RATE, ids[0]);
+    BOOST_CHECK_EQUAL(UBX_ID_CFG_PRT, ids[3]);
+    //Legacy checksum helper
+    char payload[6] = {0x06, 0x08, 0x00, 0x00};
+    calcChecksum(payload, 4);
+    BOOST_CHECK_EQUAL(0x0E, payload[4]);
+    BOOST_CHECK_EQUAL(0x30, payload[5]);
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEAStats)
+{
+    BOOST_REQUIRE(isNMEAStatsEnabled());
+    const string corpus = NMEACorpusGenerator(21, 5, 5).generate(4000);
+    //Expected counts from the plain API
+    uint64_t types[NMEA_STATS_NUM_TYPES] = {}, errors[NMEA_STATS_NUM_TYPES][NMEA_STATS_NUM_ERRORS] = {};
+    uint64_t checksumErrors = 0, parsed = 0;
+    NMEAFramer framer;
+    vector<string> sentences;
+    framer.feed(corpus.data(), corpus.size(), [&](const char* s, size_t size) {
+        sentences.push_back(string(s, size));
+    });
+    for (const string& s : sentences) {
+        NMEAParsedSentence result;
+        NMEASentenceType type = getNMEASentenceType(s.data(), s.size());
+        types[type]++;
+        checksumErrors += checkNMEAChecksum(s.data(), s.size()) == -2;
+        int rc = dispatchNMEASentence(s.data(), s.size(), NMEA_TYPE_MASK_ALL, &result);
+        parsed += type != NMEASentenceUnknown;
+        if(rc < 0) {
+            errors[type][-rc]++;
+        }
+    }
+    //Two threads parse the corpus while another thread takes snapshots
+    resetNMEAStats();
+    NMEAStatsSnapshot stats;
+    getNMEAStats(&stats);
+    BOOST_CHECK_EQUAL(0u, stats.totalSentences());
+    std::atomic<int> running(2);
+    auto worker = [&]() {
+        for (const string& s : sentences) {
+            NMEAParsedSentence result;
+            checkNMEAChecksum(s.data(), s.size());
+            dispatchNMEASentence(s.data(), s.size(), NMEA_TYPE_MASK_ALL, &result);
+        }
+        running--;
+    };
+    thread a(worker), b(worker);
+    uint64_t lastTotal = 0;
+    while(running > 0) {
+        getNMEAStats(&stats);
+        BOOST_CHECK(stats.totalSentences() >= lastTotal);
+        lastTotal = stats.totalSentences();
+        this_thread::yield();
+    }
+    a.join();
+    b.join();
+    getNMEAStats(&stats);
+    for (int i = 0; i < NMEA_STATS_NUM_TYPES; ++i) {
+        BOOST_CHECK_EQUAL(2 * types[i], stats.sentences[i]);
+    }
+    uint64_t errorTypes = 0, checksumMismatches = 0;
+    for (int type = 0; type < NMEA_STATS_NUM_TYPES; ++type) {
+        uint64_t typeErrors = 0;
+        for (int i = 0; i < NMEA_STATS_NUM_ERRORS; ++i) {
+            BOOST_CHECK_EQUAL(2 * errors[type][i], stats.errors[type][i]);
+            typeErrors += errors[type][i];
+        }
+        errorTypes += typeErrors != 0;
+        checksumMismatches += errors[type][2];
+    }
+    BOOST_CHECK(errorTypes > 1);
+    BOOST_CHECK_EQUAL(2 * checksumMismatches, stats.totalErrors(-2));
+    BOOST_CHECK(stats.totalErrors() > 0);
+    //Direct parser calls are not instrumented
+    RMCSentence rmc;
+    parseRMCSentence("$GPRMC,1*00\r\n", &rmc);
+    NMEAStatsSnapshot after;
+    getNMEAStats(&after);
+    BOOST_CHECK_EQUAL(stats.totalErrors(), after.totalErrors());
+    BOOST_CHECK(checksumErrors > 0);
+    BOOST_CHECK_EQUAL(2 * checksumErrors, stats.counters[NMEAStatsChecksumErrors]);
+    uint64_t latencies = 0;
+    for (int i = 0; i < NMEA_STATS_NUM_LATENCY_BUCKETS; ++i) {
+        latencies += stats.latency[i];
+    }
+    BOOST_CHECK_EQUAL(2 * parsed, latencies);
+    BOOST_CHECK(stats.latencyQuantile(0.5) <= stats.latencyQuantile(0.99));
+    BOOST_TEST_MESSAGE("Parse latency p50 <= " << stats.latencyQuantile(0.5) << " ns, p99 <= "
+        << stats.latencyQuantile(0.99) << " ns");
+    //Framing counters
+    resetNMEAStats();
+    const char* garbage = "xx$GPGLL,47$GPGLL,1*00\r\nyy";
+    framer = NMEAFramer();
+    framer.feed(garbage, strlen(garbage), [](const char*, size_t) {});
+    NMEARing<64> ring;
+    ring.write(garbage, strlen(garbage));
+    ring.write(corpus.data(), 64);
+    ring.readSentences([](const NMEARingSentence&) {});
+    getNMEAStats(&stats);
+    BOOST_CHECK_EQUAL(framer.getResyncs() + ring.getResyncs(), stats.counters[NMEAStatsResyncs]);
+    BOOST_CHECK_EQUAL(framer.getDroppedBytes() + ring.getDroppedBytes(), stats.counters[NMEAStatsDroppedBytes]);
+    BOOST_CHECK_EQUAL(1u, stats.counters[NMEAStatsOverruns]);
+    BOOST_CHECK_EQUAL(ring.getOverrunBytes(), stats.counters[NMEAStatsOverrunBytes]);
+    resetNMEAStats();
+    getNMEAStats(&stats);
+    BOOST_CHECK_EQUAL(0u, stats.counters[NMEAStatsDroppedBytes]);
+    BOOST_CHECK_EQUAL(0u, stats.latencyQuantile(0.5));
+}
+
+/**
+ * Decoding all fields of valid sentences must give the same result as parsing them
+ */
+template<typename T, typename Parse, typename Decode>
+static void checkFullFieldMask(const vector<string>& sentences, Parse parse, Decode decode) {
+    for (size_t i = 0; i < sentences.size(); ++i) {
+        NMEASentenceView view(sentences[i].c_str());
+        T parsed, decoded;
+        memset(&parsed, 0, sizeof(parsed));
+        memset(&decoded, 0, sizeof(decoded));
+        BOOST_REQUIRE_MESSAGE(parse(view, &parsed) == 0, sentences[i]);
+        uint32_t valid = decode(view, NMEA_ALL_FIELDS, &decoded);
+        BOOST_CHECK(valid != 0);
+        BOOST_CHECK_MESSAGE(memcmp(&parsed, &decoded, sizeof(T)) == 0, sentences[i]);
+    }
+}
+
+static vector<string> generateSentences(NMEASentenceType type, size_t n) {
+    NMEACorpusGenerator generator(7, 0, 0);
+    vector<string> sentences;
+    char buf[128];
+    for (size_t i = 0; i < n; ++i) {
+        size_t size = generator.next(type, buf, sizeof(buf));
+        sentences.push_back(string(buf, size));
+    }
+    return sentences;
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEAFieldMask) {
+    const char* msg = "$GPRMC,083559.00,A,4717.11437,S,00833.91522,W,0.004,77.52,091202,,,A*57";
+    NMEASentenceView view(msg);
+    //Position only: Other fields are not modified
+    RMCSentence rmc;
+    memset(&rmc, 0x55, sizeof(rmc));
+    BOOST_CHECK_EQUAL(NMEA_RMC_POSITION, parseRMCSentenceFields(view, NMEA_RMC_POSITION, &rmc));
+    BOOST_CHECK_EQUAL(-471711437, rmc.position.latitude);
+    BOOST_CHECK_EQUAL(-83391522, rmc.position.longitude);
+    BOOST_CHECK_EQUAL(0x55555555u, rmc.utcTime);
+    BOOST_CHECK_EQUAL(0x55555555, rmc.speed);
+    //Compile-time mask
+    RMCSentence rmc2;
+    memset(&rmc2, 0x55, sizeof(rmc2));
+    BOOST_CHECK_EQUAL(NMEA_RMC_POSITION, NMEARMCSchema::decode<NMEA_RMC_POSITION>(view, &rmc2));
+    BOOST_CHECK_EQUAL(0, memcmp(&rmc, &rmc2, sizeof(rmc)));
+    //Empty speed fails parse() but keeps the other fields
+    const char* noSpeed = "$GPRMC,083559.00,V,4717.11437,N,00833.91522,E,,,091202,,,N*57";
+    BOOST_CHECK_EQUAL(-8, parseRMCSentence(noSpeed, &rmc));
+    uint32_t valid = parseRMCSentenceFields(NMEASentenceView(noSpeed), NMEA_ALL_FIELDS, &rmc);
+    BOOST_CHECK_EQUAL(NMEA_RMC_TIME | NMEA_RMC_STATUS | NMEA_RMC_POSITION | NMEA_RMC_DATE | NMEA_RMC_POS_MODE, valid);
+    BOOST_CHECK_EQUAL(INT32_MAX, rmc.speed);
+    BOOST_CHECK_EQUAL(INT32_MAX, rmc.course);
+    BOOST_CHECK_EQUAL(471711437, rmc.position.latitude);
+    BOOST_CHECK_EQUAL(91202u, rmc.date);
+    BOOST_CHECK_EQUAL('V', rmc.status);
+    //A coordinate without a valid direction is invalid
+    const char* noDirection = "$GPGLL,4717.11437,X,00833.91522,E*00";
+    NMEAPosition pos;
+    valid = parseGLLSentenceFields(NMEASentenceView(noDirection), NMEA_GLL_POSITION, &pos);
+    BOOST_CHECK_EQUAL(NMEA_FIELD(3) | NMEA_FIELD(4), valid);
+    BOOST_CHECK_EQUAL(INT32_MAX, pos.latitude);
+    BOOST_CHECK_EQUAL(83391522, pos.longitude);
+    //Selecting only the coordinates also decodes their directions
+    memset(&rmc2, 0x55, sizeof(rmc2));
+    valid = parseRMCSentenceFields(view, NMEA_FIELD(3) | NMEA_FIELD(5), &rmc2);
+    BOOST_CHECK_EQUAL(NMEA_RMC_POSITION, valid);
+    BOOST_CHECK_EQUAL(-471711437, rmc2.position.latitude);
+    BOOST_CHECK_EQUAL(-83391522, rmc2.position.longitude);
+    memset(&rmc2, 0x55, sizeof(rmc2));
+    BOOST_CHECK_EQUAL(NMEA_RMC_POSITION, (NMEARMCSchema::decode<NMEA_FIELD(3) | NMEA_FIELD(5)>(view, &rmc2)));
+    BOOST_CHECK_EQUAL(-471711437, rmc2.position.latitude);
+    //Characters that are not allowed are stored as '\0'
+    valid = parseRMCSentenceFields(NMEASentenceView("$GPRMC,083559.00,X,,,,,,,091202,,,Q*00"), NMEA_ALL_FIELDS, &rmc);
+    BOOST_CHECK_EQUAL(NMEA_RMC_TIME | NMEA_RMC_DATE, valid);
+    BOOST_CHECK_EQUAL('\0', rmc.status);
+    BOOST_CHECK_EQUAL('\0', rmc.posMode);
+    //Missing fields are invalid, not an error
+    valid = parseRMCSentenceFields(NMEASentenceView("$GPRMC,083559.00,A*00"), NMEA_ALL_FIELDS, &rmc);
+    BOOST_CHECK_EQUAL(NMEA_RMC_TIME | NMEA_RMC_STATUS, valid);
+    BOOST_CHECK_EQUAL(INT32_MAX, rmc.position.latitude);
+    //Selected elements of array fields and repeated groups
+    GSASentence gsa;
+    memset(&gsa, 0, sizeof(gsa));
+    valid = parseGSASentenceFields(NMEASentenceView("$GNGSA,A,3,80,71,,,,,,,,,,,3.0,2.1,2.2,2*00"),
+        NMEA_FIELD(3) | NMEA_FIELD(5) | NMEA_GSA_SYSTEM_ID, &gsa);
+    BOOST_CHECK_EQUAL(NMEA_FIELD(3) | NMEA_GSA_SYSTEM_ID, valid);
+    BOOST_CHECK_EQUAL(80, gsa.satellites[0]);
+    BOOST_CHECK_EQUAL(0, gsa.satellites[1]);
+    BOOST_CHECK_EQUAL(INT32_MAX, gsa.satellites[2]);
+    BOOST_CHECK_EQUAL(2, gsa.systemId);
+    GSVSentence gsv;
+    valid = parseGSVSentenceFields(NMEASentenceView("$GPGSV,3,1,10,23,38,230,44,29,71,156,47*7F"),
+        NMEA_GSV_SATELLITES, &gsv);
+    BOOST_CHECK_EQUAL(0x00000ff0u, valid);
+    BOOST_CHECK_EQUAL(2, gsv.numSatInfos);
+    BOOST_CHECK_EQUAL(29, gsv.satellites[1].id);
+    //Full mask
+    checkFullFieldMask<NMEAPosition>(generateSentences(NMEASentenceGLL, 200),
+        [](const NMEASentenceView& v, NMEAPosition* r) {return parseGLLSentence(v, r);},
+        [](const NMEASentenceView& v, uint32_t m, NMEAPosition* r) {return parseGLLSentenceFields(v, m, r);});
+    checkFullFieldMask<RMCSentence>(generateSentences(NMEASentenceRMC, 200),
+        [](const NMEASentenceView& v, RMCSentence* r) {return parseRMCSentence(v, r);},
+        [](const NMEASentenceView& v, uint32_t m, RMCSentence* r) {return parseRMCSentenceFields(v, m, r);});
+    checkFullFieldMask<GSVSentence>(generateSentences(NMEASentenceGSV, 200),
+        [](const NMEASentenceView& v, GSVSentence* r) {return parseGSVSentence(v, r);},
+        [](const NMEASentenceView& v, uint32_t m, GSVSentence* r) {return parseGSVSentenceFields(v, m, r);});
+    checkFullFieldMask<GGASentence>(vector<string>{"$GPGGA,092725.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,*5B",
+            "$GPGGA,092725.00,4717.11399,S,00833.91590,W,2,12,,-12.5,M,-3.0,M,,*5B"},
+        [](const NMEASentenceView& v, GGASentence* r) {return parseGGASentence(v, r);},
+        [](const NMEASentenceView& v, uint32_t m, GGASentence* r) {return parseGGASentenceFields(v, m, r);});
+    checkFullFieldMask<GSASentence>(vector<string>{"$GPGSA,A,3,23,29,07,08,09,18,26,28,,,,,1.94,1.18,1.54*0D",
+            "$GNGSA,A,3,23,29,07,08,09,18,26,28,,,,,1.94,1.18,1.54,1*0D"},
+        [](const NMEASentenceView& v, GSASentence* r) {return parseGSASentence(v, r);},
+        [](const NMEASentenceView& v, uint32_t m, GSASentence* r) {return parseGSASentenceFields(v, m, r);});
+    checkFullFieldMask<VTGSentence>(vector<string>{"$GPVTG,77.52,T,,M,0.004,N,0.008,K,A*06"},
+        [](const NMEASentenceView& v, VTGSentence* r) {return parseVTGSentence(v, r);},
+        [](const NMEASentenceView& v, uint32_t m, VTGSentence* r) {return parseVTGSentenceFields(v, m, r);});
+    checkFullFieldMask<ZDASentence>(vector<string>{"$GPZDA,082710.00,16,09,2002,00,00*64", "$GPZDA,082710.00,16,09,2002,-05,30*64"},
+        [](const NMEASentenceView& v, ZDASentence* r) {return parseZDASentence(v, r);},
+        [](const NMEASentenceView& v, uint32_t m, ZDASentence* r) {return parseZDASentenceFields(v, m, r);});
+    checkFullFieldMask<GSTSentence>(vector<string>{"$GPGST,082356.00,1.8,,,,1.7,1.3,2.2*7E"},
+        [](const NMEASentenceView& v, GSTSentence* r) {return parseGSTSentence(v, r);},
+        [](const NMEASentenceView& v, uint32_t m, GSTSentence* r) {return parseGSTSentenceFields(v, m, r);});
+}
+
+static int64_t utcEpochNs(int year, int month, int day, int hour, int minute, int second, int centis) {
+    struct tm t;
+    memset(&t, 0, sizeof(t));
+    t.tm_year = year - 1900;
+    t.tm_mon = month - 1;
+    t.tm_mday = day;
+    t.tm_hour = hour;
+    t.tm_min = minute;
+    t.tm_sec = second;
+    return (int64_t)timegm(&t) * NMEA_NS_PER_SECOND + centis * 10000000ll;
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEAEpochConverter) {
+    BOOST_CHECK_EQUAL(0, getNMEACivilDays(1970, 1, 1));
+    BOOST_CHECK_EQUAL(10957, getNMEACivilDays(2000, 1, 1));
+    BOOST_CHECK_EQUAL(-1, getNMEACivilDays(1969, 12, 31));
+    BOOST_CHECK_EQUAL(2, getNMEACivilDays(2000, 3, 1) - getNMEACivilDays(2000, 2, 28));
+    BOOST_CHECK_EQUAL(1, getNMEACivilDays(2100, 3, 1) - getNMEACivilDays(2100, 2, 28));
+    NMEAEpochConverter converter;
+    BOOST_CHECK_EQUAL(NMEA_EPOCH_INVALID, converter.toEpochNs(8355900u)); //No date yet
+    BOOST_CHECK_EQUAL(utcEpochNs(2002, 12, 9, 8, 35, 59, 0), converter.toEpochNs(91202, 8355900u));
+    BOOST_CHECK_EQUAL(utcEpochNs(2002, 12, 9, 8, 35, 59, 50), converter.toEpochNs(91202, 8355950u));
+    BOOST_CHECK_EQUAL(utcEpochNs(2002, 12, 9, 8, 36, 0, 0), converter.toEpochNs(8360000u));
+    BOOST_CHECK_EQUAL(utcEpochNs(2024, 2, 29, 23, 59, 60, 0), converter.toEpochNs(290224, 23596000u)); //Leap second
+    //Invalid dates and times
+    BOOST_CHECK_EQUAL(NMEA_EPOCH_INVALID, converter.toEpochNs(91202, INT32_MAX));
+    BOOST_CHECK_EQUAL(NMEA_EPOCH_INVALID, converter.toEpochNs(91302, 8355900u));
+    BOOST_CHECK_EQUAL(NMEA_EPOCH_INVALID, converter.toEpochNs(91202, 24000000u));
+    BOOST_CHECK_EQUAL(NMEA_EPOCH_INVALID, converter.toEpochNs(91202, 8605900u));
+    BOOST_CHECK_EQUAL(NMEA_EPOCH_INVALID, converter.toEpochNs(91202, 8356100u));
+    //Sentences without date across midnight
+    converter.reset();
+    BOOST_CHECK_EQUAL(utcEpochNs(2023, 12, 31, 23, 59, 59, 90), converter.toEpochNs(311223, 23595990u));
+    BOOST_CHECK_EQUAL(utcEpochNs(2024, 1, 1, 0, 0, 0, 0), converter.toEpochNs(0u));
+    BOOST_CHECK_EQUAL(utcEpochNs(2024, 1, 1, 0, 0, 0, 10), converter.toEpochNs(10u));
+    //Late sentence from before midnight, then the date catches up
+    BOOST_CHECK_EQUAL(utcEpochNs(2023, 12, 31, 23, 59, 59, 90), converter.toEpochNs(23595990u));
+    BOOST_CHECK_EQUAL(utcEpochNs(2024, 1, 1, 0, 0, 0, 20), converter.toEpochNs(10124, 20u));
+    BOOST_CHECK_EQUAL(utcEpochNs(2023, 12, 31, 23, 59, 59, 80), converter.toEpochNs(23595980u));
+    //GPS week number rollover
+    NMEAEpochConverter corrected(10140);
+    int64_t wrapped = utcEpochNs(2020, 6, 15, 12, 0, 0, 0);
+    BOOST_CHECK_EQUAL(wrapped + 7168 * NMEA_NS_PER_DAY, corrected.toEpochNs(150620, 12000000u));
+    BOOST_CHECK_EQUAL(utcEpochNs(2040, 1, 1, 0, 0, 0, 0), corrected.toEpochNs(10140, 0u));
+    BOOST_CHECK_EQUAL(wrapped, converter.toEpochNs(150620, 12000000u));
+    //Batch
+    NMEACorpusGenerator generator(3, 10, 0);
+    vector<int32_t> dates;
+    vector<uint32_t> times;
+    char buf[128];
+    for (int i = 0; i < 500; ++i) {
+        generator.next(NMEASentenceRMC, buf, sizeof(buf));
+        RMCSentence rmc;
+        parseRMCSentenceFields(NMEASentenceView(buf), NMEA_RMC_TIME | NMEA_RMC_DATE, &rmc);
+        dates.push_back(i % 3 == 0 ? rmc.date : INT32_MAX);
+        times.push_back(rmc.utcTime);
+    }
+    vector<int64_t> batch(dates.size());
+    NMEAEpochConverter batchConverter, singleConverter;
+    size_t valid = batchConverter.toEpochNs(dates.data(), times.data(), dates.size(), batch.data());
+    size_t expectedValid = 0;
+    for (size_t i = 0; i < dates.size(); ++i) {
+        int64_t ns = singleConverter.toEpochNs(dates[i], times[i]);
+        BOOST_CHECK_EQUAL(ns, batch[i]);
+        expectedValid += ns != NMEA_EPOCH_INVALID;
+        if(i > 0 && ns != NMEA_EPOCH_INVALID && batch[i - 1] != NMEA_EPOCH_INVALID) {
+            BOOST_CHECK(ns >= batch[i - 1]);
+        }
+    }
+    BOOST_CHECK_EQUAL(expectedValid, valid);
+    BOOST_CHECK(valid > 400);
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEAGeo) {
+    //4717.11437 N = 47.2852395 degrees, 00833.91522 W = -8.565253666.. degrees
+    BOOST_CHECK_EQUAL(472852395, nmeaCoordinateToDegrees(471711437));
+    BOOST_CHECK_EQUAL(-85652537, nmeaCoordinateToDegrees(-83391522));
+    BOOST_CHECK_EQUAL(INT32_MAX, nmeaCoordinateToDegrees(INT32_MAX));
+    BOOST_CHECK_EQUAL(1800000000, nmeaCoordinateToDegrees(1800000000));
+    BOOST_CHECK_EQUAL(-1799999998, nmeaCoordinateToDegrees(-1795999999));
+    //Exact round trip and agreement with floating point
+    NMEACorpusGenerator generator(5, 0, 0);
+    vector<NMEAPosition> positions;
+    char buf[128];
+    for (int i = 0; i < 1000; ++i) {
+        generator.next(NMEASentenceGLL, buf, sizeof(buf));
+        NMEAPosition pos;
+        BOOST_REQUIRE_EQUAL(0, parseGLLSentence(buf, &pos));
+        positions.push_back(pos);
+    }
+    positions.push_back(NMEAPosition{INT32_MAX, INT32_MAX});
+    size_t n = positions.size();
+    vector<int32_t> lat(n), lon(n);
+    convertNMEAPositionsToDegrees(positions.data(), n, lat.data(), lon.data());
+    for (size_t i = 0; i + 1 < n; ++i) {
+        int32_t coord = positions[i].latitude;
+        double expected = (coord / 10000000) * 1e7 + (coord % 10000000) / 60.0 * 100.0;
+        BOOST_CHECK(fabs(lat[i] - expected) <= 0.5);
+        BOOST_CHECK_EQUAL(coord, nmeaDegreesToCoordinate(lat[i]));
+        BOOST_CHECK_EQUAL(positions[i].longitude, nmeaDegreesToCoordinate(lon[i]));
+    }
+    BOOST_CHECK_EQUAL(INT32_MAX, lat[n - 1]);
+    vector<double> latRad(n), lonRad(n);
+    convertNMEAPositionsToRadians(positions.data(), n, latRad.data(), lonRad.data());
+    BOOST_CHECK_CLOSE(lat[0] * 1e-7 * M_PI / 180, latRad[0], 1e-9);
+    BOOST_CHECK(std::isnan(latRad[n - 1]));
+    //ECEF: Equator/prime meridian and north pole
+    NMEAPosition reference[2] = {{0, 0}, {900000000, 0}};
+    int32_t altitudes[2] = {1000, 0};
+    double x[2], y[2], z[2];
+    convertNMEAPositionsToECEF(reference, altitudes, 2, x, y, z);
+    BOOST_CHECK_CLOSE(6378138.0, x[0], 1e-9);
+    BOOST_CHECK_SMALL(y[0], 1e-6);
+    BOOST_CHECK_SMALL(z[0], 1e-6);
+    BOOST_CHECK_SMALL(x[1], 1e-6);
+    BOOST_CHECK_CLOSE(6356752.314245, z[1], 1e-9);
+    //ENU: About 1 km east and 1 km north of the origin
+    NMEAPosition origin = {471711437, 83391522};
+    NMEALocalFrame frame(origin, 500000);
+    NMEAPosition moved[3] = {origin, {471711437 + 53996, 83391522}, {471711437, 83391522 + 79410}};
+    int32_t heights[3] = {500000, 500000, 510000};
+    double east[3], north[3], up[3];
+    frame.toENU(moved, heights, 3, east, north, up);
+    BOOST_CHECK_SMALL(east[0], 1e-6);
+    BOOST_CHECK_SMALL(north[0], 1e-6);
+    BOOST_CHECK_SMALL(up[0], 1e-6);
+    BOOST_CHECK_SMALL(east[1], 1e-3);
+    BOOST_CHECK_CLOSE(1000.0, north[1], 0.5);
+    BOOST_CHECK_CLOSE(1000.0, east[2], 0.5);
+    BOOST_CHECK_SMALL(north[2], 0.1);
+    //10 m higher, minus the curvature of the earth over 1 km (8 cm)
+    BOOST_CHECK_CLOSE(10.0 - 0.08, up[2], 1.0);
+}
+
+/**
+ * A fix at the given position (1e-7 degrees) and time (seconds since midnight, 1/100 s)
+ */
+static RMCSentence makeReducerFix(int32_t latitude, int32_t longitude, uint32_t centis) {
+    RMCSentence fix;
+    memset(&fix, 0, sizeof(fix));
+    fix.status = 'A';
+    fix.position.latitude = nmeaDegreesToCoordinate(latitude);
+    fix.position.longitude = nmeaDegreesToCoordinate(longitude);
+    uint32_t seconds = centis / 100;
+    fix.utcTime = (seconds / 3600 * 10000 + seconds / 60 % 60 * 100 + seconds % 60) * 100 + centis % 100;
+    fix.date = 10124;
+    fix.speed = fix.course = INT32_MAX;
+    fix.posMode = 'A';
+    return fix;
+}
+
+static void checkReducerStats(const NMEAReducerStats& stats) {
+    BOOST_CHECK_EQUAL(stats.input, stats.invalid + stats.duplicates + stats.rateLimited
+        + stats.simplified + stats.output);
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEATrackReducer) {
+    //Stationary receiver: Only the first fix
+    NMEATrackReducer stationary(1.0);
+    RMCSentence out;
+    size_t emitted = 0;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        emitted += stationary.add(makeReducerFix(472852395, 85652537, i * 10), &out) == 1;
+    }
+    emitted += stationary.flush(&out);
+    BOOST_CHECK_EQUAL(1u, emitted);
+    BOOST_CHECK_EQUAL(999u, stationary.getStats().duplicates);
+    BOOST_CHECK_CLOSE(1000.0, stationary.getStats().reductionRatio(), 1e-9);
+    checkReducerStats(stationary.getStats());
+    //Jitter below the duplicate distance (1e-5 degrees = 1.1 m)
+    NMEATrackReducer jitter(1.0, 3.0);
+    emitted = 0;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        emitted += jitter.add(makeReducerFix(472852395 + (int32_t)(i * 7919 % 200) - 100,
+            85652537 + (int32_t)(i * 104729 % 200) - 100, i * 10), &out) == 1;
+    }
+    emitted += jitter.flush(&out);
+    BOOST_CHECK_EQUAL(1u, emitted);
+    checkReducerStats(jitter.getStats());
+    //Invalid positions
+    RMCSentence invalid = makeReducerFix(0, 0, 0);
+    invalid.position.latitude = INT32_MAX;
+    BOOST_CHECK_EQUAL(-1, jitter.add(invalid, &out));
+    BOOST_CHECK_EQUAL(1u, jitter.getStats().invalid);
+    //L-shaped track at 10 Hz: 50 fixes east, then 50 north. Only the start, the corner and the end remain.
+    NMEATrackReducer line(0.5);
+    vector<RMCSentence> reduced;
+    for (uint32_t i = 0; i <= 100; ++i) {
+        int32_t east = i <= 50 ? i : 50;
+        int32_t north = i <= 50 ? 0 : i - 50;
+        if(line.add(makeReducerFix(472852395 + north * 100, 85652537 + east * 100, i * 10), &out) == 1) {
+            reduced.push_back(out);
+        }
+    }
+    if(line.flush(&out) == 1) {
+        reduced.push_back(out);
+    }
+    BOOST_REQUIRE_EQUAL(3u, reduced.size());
+    BOOST_CHECK_EQUAL(makeReducerFix(472852395, 85652537 + 5000, 0).position.longitude, reduced[1].position.longitude);
+    BOOST_CHECK_EQUAL(makeReducerFix(472852395 + 5000, 0, 0).position.latitude, reduced[2].position.latitude);
+    BOOST_CHECK_EQUAL(98u, line.getStats().simplified);
+    checkReducerStats(line.getStats());
+    //Fixes are held back at most NMEA_REDUCER_WINDOW fixes
+    NMEATrackReducer straight(0.5);
+    emitted = 0;
+    for (uint32_t i = 0; i < 10 * NMEA_REDUCER_WINDOW; ++i) {
+        emitted += straight.add(makeReducerFix(472852395, 85652537 + i * 100, i * 10), &out) == 1;
+    }
+    BOOST_CHECK_EQUAL(10u, emitted);
+    //Zigzag beyond the tolerance at 10 Hz, limited to 1 Hz: Every accepted fix is emitted
+    NMEATrackReducer limited(0.5, 0, 1000);
+    emitted = 0;
+    for (uint32_t i = 0; i < 600; ++i) {
+        emitted += limited.add(makeReducerFix(472852395 + (int32_t)(i / 10 % 2) * 1000, 85652537 + i * 100, i * 10), &out) == 1;
+    }
+    emitted += limited.flush(&out);
+    BOOST_CHECK_EQUAL(60u, emitted);
+    BOOST_CHECK_EQUAL(540u, limited.getStats().rateLimited);
+    checkReducerStats(limited.getStats());
+    //Noise within the tolerance around a straight line, longer than the window
+    NMEATrackReducer noisy(5.0);
+    emitted = 0;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        emitted += noisy.add(makeReducerFix(472852395 + (int32_t)(i * 7919 % 40) - 20, 85652537 + i * 100, i * 10), &out) == 1;
+    }
+    emitted += noisy.flush(&out);
+    BOOST_CHECK(emitted <= 1000 / NMEA_REDUCER_WINDOW + 2);
+    BOOST_CHECK(noisy.getStats().reductionRatio() >= 10);
+    checkReducerStats(noisy.getStats());
+}
+
+static NMEAPosition geofencePosition(int32_t latitude, int32_t longitude) {
+    NMEAPosition position = {nmeaDegreesToCoordinate(latitude), nmeaDegreesToCoordinate(longitude)};
+    return position;
+}
+
+BOOST_AUTO_TEST_CASE(TestNMEAGeofence) {
+    NMEAGeofenceIndex index;
+    //Concave polygon (U shape) and circles, 1e-7 degrees
+    NMEAPosition u[8] = {geofencePosition(470000000, 80000000), geofencePosition(470000000, 80030000),
+        geofencePosition(470030000, 80030000), geofencePosition(470030000, 80020000),
+        geofencePosition(470010000, 80020000), geofencePosition(470010000, 80010000),
+        geofencePosition(470030000, 80010000), geofencePosition(470030000, 80000000)};
+    BOOST_CHECK_EQUAL(0, index.addPolygon(u, 8));
+    BOOST_CHECK_EQUAL(1, index.addCircle(geofencePosition(470000000, 80000000), 100.0));
+    BOOST_CHECK_EQUAL(-1, index.addPolygon(u, 2));
+    BOOST_CHECK_EQUAL(-1, index.addCircle(NMEAPosition{INT32_MAX, 0}, 10.0));
+    NMEAPosition huge[3] = {geofencePosition(0, 0), geofencePosition(0, 1000000000), geofencePosition(10000000, 0)};
+    BOOST_CHECK_EQUAL(-2, index.addPolygon(huge, 3));
+    uint32_t result[4];
+    BOOST_CHECK_EQUAL(0u, index.query(u[0], result, 4)); //Not built yet
+    BOOST_CHECK_EQUAL(0, index.build());
+    BOOST_CHECK_EQUAL(-3, index.addCircle(u[0], 10.0));
+    //Inside both
+    BOOST_REQUIRE_EQUAL(2u, index.query(geofencePosition(470001000, 80001000), result, 4));
+    BOOST_CHECK_EQUAL(0u, result[0]);
+    BOOST_CHECK_EQUAL(1u, result[1]);
+    //Inside the notch of the U: Only the circle's bounding box, no fence
+    BOOST_CHECK_EQUAL(0u, index.query(geofencePosition(470020000, 80015000), result, 4));
+    //Arms of the U
+    BOOST_CHECK_EQUAL(1u, index.query(geofencePosition(470020000, 80005000), result, 4));
+    BOOST_CHECK_EQUAL(1u, index.query(geofencePosition(470020000, 80025000), result, 4));
+    //Circle only (100 m south-west of the corner is outside the polygon)
+    BOOST_REQUIRE_EQUAL(1u, index.query(geofencePosition(469995000, 79995000), result, 4));
+    BOOST_CHECK_EQUAL(1u, result[0]);
+    BOOST_CHECK_EQUAL(0u, index.query(geofencePosition(469990000, 80000000), result, 4)); //111 m
+    BOOST_CHECK_EQUAL(0u, index.query(geofencePosition(-470000000, 80000000), result, 4));
+    //North-east of all bounding boxes, i.e. outside of the grid
+    BOOST_CHECK_EQUAL(0u, index.query(geofencePosition(470040000, 80040000), result, 4));
+    BOOST_CHECK_EQUAL(0u, index.query(NMEAPosition{INT32_MAX, INT32_MAX}, result, 4));
+    //Result count beyond maxFences
+    BOOST_CHECK_EQUAL(2u, index.query(geofencePosition(470001000, 80001000), result, 1));
+    //Many fences: Compare the grid against testing every fence
+    NMEAGeofenceIndex grid;
+    uint32_t random = 12345;
+    for (int i = 0; i < 2000; ++i) {
+        random = random * 1103515245 + 12345;
+        int32_t latitude = 470000000 + (int32_t)(random >> 8) % 2000000;
+        random = random * 1103515245 + 12345;
+        int32_t longitude = 80000000 + (int32_t)(random >> 8) % 2000000;
+        if(i % 2 == 0) {
+            BOOST_REQUIRE_EQUAL(i, grid.addCircle(geofencePosition(latitude, longitude), 50.0 + random % 500));
+        } else {
+            int32_t size = 1000 + random % 5000;
+            NMEAPosition triangle[3] = {geofencePosition(latitude, longitude),
+                geofencePosition(latitude + size, longitude), geofencePosition(latitude, longitude + size)};
+            BOOST_REQUIRE_EQUAL(i, grid.addPolygon(triangle, 3));
+        }
+    }
+    BOOST_REQUIRE_EQUAL(0, grid.build());
+    vector<int32_t> latitudes, longitudes;
+    size_t hits = 0;
+    for (int i = 0; i < 2000; ++i) {
+        random = random * 1103515245 + 12345;
+        int32_t latitude = 470000000 + (int32_t)(random >> 8) % 2000000;
+        random = random * 1103515245 + 12345;
+        int32_t longitude = 80000000 + (int32_t)(random >> 8) % 2000000;
+        NMEAPosition position = geofencePosition(latitude, longitude);
+        latitudes.push_back(position.latitude);
+        longitudes.push_back(position.longitude);
+        uint32_t found[64];
+        size_t n = grid.query(position, found, 64);
+        BOOST_REQUIRE(n <= 64);
+        vector<uint32_t> expected;
+        for (uint32_t fence = 0; fence < grid.getNumFences(); ++fence) {
+            if(grid.contains(fence, position)) {
+                expected.push_back(fence);
+            }
+        }
+        BOOST_REQUIRE_EQUAL(expected.size(), n);
+        BOOST_CHECK(std::equal(expected.begin(), expected.end(), found));
+        hits += n;
+    }
+    BOOST_CHECK(hits > 10);
+    //Clustered fences subdivide the grid cells of the cluster,
+    //a few large fences overlap all cells of the subdivision
+    NMEAGeofenceIndex clustered;
+    for (int i = 0; i < 2000; ++i) {
+        random = random * 1103515245 + 12345;
+        int32_t spread = i % 10 == 0 ? 2000000 : 40000;
+        int32_t latitude = 470000000 + (int32_t)((random >> 8) % spread);
+        random = random * 1103515245 + 12345;
+        int32_t longitude = 80000000 + (int32_t)((random >> 8) % spread);
+        if(i % 100 == 1) {
+            BOOST_REQUIRE_EQUAL(i, clustered.addCircle(geofencePosition(470020000, 80020000), 500.0));
+        } else if(i % 2 == 0) {
+            BOOST_REQUIRE_EQUAL(i, clustered.addCircle(geofencePosition(latitude, longitude), 5.0 + random % 20));
+        } else {
+            int32_t size = 100 + random % 300;
+            NMEAPosition triangle[3] = {geofencePosition(latitude, longitude),
+                geofencePosition(latitude + size, longitude), geofencePosition(latitude, longitude + size)};
+            BOOST_REQUIRE_EQUAL(i, clustered.addPolygon(triangle, 3));
+        }
+    }
+    BOOST_REQUIRE_EQUAL(0, clustered.build());
+    size_t clusteredHits = 0;
+    for (int i = 0; i < 20000; ++i) {
+        random = random * 1103515245 + 12345;
+        int32_t spread = i % 10 == 0 ? 2000000 : 50000;
+        int32_t latitude = 470000000 - 5000 + (int32_t)((random >> 8) % spread);
+        random = random * 1103515245 + 12345;
+        int32_t longitude = 80000000 - 5000 + (int32_t)((random >> 8) % spread);
+        NMEAPosition position = geofencePosition(latitude, longitude);
+        uint32_t found[64];
+        size_t n = clustered.query(position, found, 64);
+        BOOST_REQUIRE(n <= 64);
+        vector<uint32_t> expected;
+        for (uint32_t fence = 0; fence < clustered.getNumFences(); ++fence) {
+            if(clustered.contains(fence, position)) {
+                expected.push_back(fence);
+            }
+        }
+        BOOST_REQUIRE_EQUAL(expected.size(), n);
+        BOOST_CHECK(std::equal(expected.begin(), expected.end(), found));
+        clusteredHits += n;
+    }
+    BOOST_CHECK(clusteredHits > 1000);
+    //Batch query, stopping when the results are full
+    vector<uint32_t> offsets(latitudes.size() + 1), fences(hits);
+    BOOST_CHECK_EQUAL(latitudes.size(), grid.query(latitudes.data(), longitudes.data(), latitudes.size(),
+        offsets.data(), fences.data(), fences.size()));
+    BOOST_CHECK_EQUAL(hits, offsets.back());
+    size_t rows = grid.query(latitudes.data(), longitudes.data(), latitudes.size(),
+        offsets.data(), fences.data(), hits - 1);
+    BOOST_CHECK(rows < latitudes.size());
+    BOOST_CHECK(offsets[rows] <= hits - 1);
+    //Enter/exit tracking
+    NMEAGeofenceTracker tracker;
+    vector<pair<uint32_t, bool> > transitions;
+    auto onTransition = [&transitions](uint32_t fence, bool entered) {
+        transitions.push_back(make_pair(fence, entered));
+    };
+    BOOST_CHECK_EQUAL(2u, tracker.update(index, geofencePosition(470001000, 80001000), onTransition));
+    BOOST_CHECK_EQUAL(0u, tracker.update(index, geofencePosition(470001100, 80001000), onTransition));
+    BOOST_CHECK_EQUAL(0u, tracker.update(index, NMEAPosition{INT32_MAX, INT32_MAX}, onTransition));
+    BOOST_CHECK_EQUAL(1u, tracker.update(index, geofencePosition(470020000, 80005000), onTransition)); //Leaves the circle
+    BOOST_CHECK_EQUAL(2u, tracker.update(index, geofencePosition(469995000, 79995000), onTransition)); //Circle only
+    BOOST_REQUIRE_EQUAL(5u, transitions.size());
+    BOOST_CHECK(transitions[0] == make_pair(0u, true));
+    BOOST_CHECK(transitions[1] == make_pair(1u, true));
+    BOOST_CHECK(transitions[2] == make_pair(1u, false));
+    BOOST_CHECK(transitions[3] == make_pair(0u, false));
+    BOOST_CHECK(transitions[4] == make_pair(1u, true));
+    BOOST_REQUIRE_EQUAL(1u, tracker.getInside().size());
+    BOOST_CHECK_EQUAL(1u, tracker.getInside()[0]);
+}
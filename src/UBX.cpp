@@ -0,0 +1,58 @@
+#include "UBX.h"
+
+#include <cstring>
+
+static inline void putUBXU16(uint8_t* dst, uint16_t value) {
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+}
+
+static inline void putUBXU32(uint8_t* dst, uint32_t value) {
+    putUBXU16(dst, (uint16_t)value);
+    putUBXU16(dst + 2, (uint16_t)(value >> 16));
+}
+
+uint16_t computeUBXChecksum(const uint8_t* data, size_t size) {
+    uint8_t a = 0, b = 0;
+    for (size_t i = 0; i < size; ++i) {
+        a += data[i];
+        b += a;
+    }
+    return (uint16_t)(a | (b << 8));
+}
+
+size_t buildUBXMessage(uint8_t msgClass, uint8_t msgId, const void* payload, uint16_t size, uint8_t* out) {
+    out[0] = UBX_SYNC_CHAR_1;
+    out[1] = UBX_SYNC_CHAR_2;
+    out[2] = msgClass;
+    out[3] = msgId;
+    putUBXU16(out + 4, size);
+    if(size != 0) {
+        memcpy(out + UBX_HEADER_SIZE, payload, size);
+    }
+    putUBXU16(out + UBX_HEADER_SIZE + size, computeUBXChecksum(out + 2, size + 4));
+    return size + UBX_FRAME_OVERHEAD;
+}
+
+size_t buildUBXCfgPrtUART(uint32_t baudrate, uint16_t inProtoMask, uint16_t outProtoMask, uint8_t* out) {
+    uint8_t payload[20] = {};
+    payload[0] = 1; //Port ID: UART1
+    putUBXU32(payload + 4, 0x000008D0); //Mode: 8 bits, no parity, 1 stop bit
+    putUBXU32(payload + 8, baudrate);
+    putUBXU16(payload + 12, inProtoMask);
+    putUBXU16(payload + 14, outProtoMask);
+    return buildUBXMessage(UBX_CLASS_CFG, UBX_ID_CFG_PRT, payload, sizeof(payload), out);
+}
+
+size_t buildUBXCfgRate(uint16_t measRateMs, uint16_t navRate, uint8_t* out) {
+    uint8_t payload[6];
+    putUBXU16(payload, measRateMs);
+    putUBXU16(payload + 2, navRate);
+    putUBXU16(payload + 4, 1); //Time reference: GPS time
+    return buildUBXMessage(UBX_CLASS_CFG, UBX_ID_CFG_RATE, payload, sizeof(payload), out);
+}
+
+size_t buildUBXCfgMsg(uint8_t msgClass, uint8_t msgId, uint8_t rate, uint8_t* out) {
+    uint8_t payload[3] = {msgClass, msgId, rate};
+    return buildUBXMessage(UBX_CLASS_CFG, UBX_ID_CFG_MSG, payload, sizeof(payload), out);
+}
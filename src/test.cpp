@@ -8,15 +8,22 @@ using namespace boost;
 
 boost::asio::io_service io;
 
-void ubloxLLDWrite(void* arg, const char* buf, size_t length) {
-    boost::asio::serial_port* port = (boost::asio::serial_port*)arg;
-    boost::asio::write(*port, boost::asio::buffer(buf, length));
-}
+/**
+ * UBloxDriver transport for a boost::asio serial port
+ */
+struct SerialTransport {
+    explicit SerialTransport(boost::asio::serial_port* port) : port(port) {}
 
-size_t ubloxLLDRead(void* arg, char* buf, size_t size) {
-    boost::asio::serial_port* port = (boost::asio::serial_port*)arg;
-    return boost::asio::read(*port, boost::asio::buffer(buf, size));
-}
+    size_t read(char* buf, size_t size) {
+        return port->read_some(boost::asio::buffer(buf, size));
+    }
+
+    void write(const char* buf, size_t size) {
+        boost::asio::write(*port, boost::asio::buffer(buf, size));
+    }
+
+    boost::asio::serial_port* port;
+};
 
 int main() {
     cout << parseNMEACoordinate("4153.94820") << endl;
@@ -26,15 +33,13 @@ int main() {
     //uint16_t chksum = computeHexNMEAChecksum(msg, strlen(msg));
     //string s((char*)&chksum, 2);
     //cout << s << endl;
-    //configureUBLOX(&serial);
-    //requestPosition(&serial);
+    SerialTransport transport(&serial);
+    UBloxDriver<SerialTransport> ublox(transport);
+    //ublox.configure();
     while(true) {
-        size_t linesize = ubloxReadLine(&serial);
-        if(linesize == 0) {
-            continue;
-        }
-        string s(rxbuf, linesize);
-        cout << s;
+        ublox.readSentences([](const char* sentence, size_t size) {
+            cout << string(sentence, size);
+        });
     }
     /*char c;
     std::string result;
@@ -43,4 +48,4 @@ int main() {
         boost::asio::read(serial, boost::asio::buffer(&c,1));
         cout << c;
     }*/
-}
\ No newline at end of file
+}